@@ -0,0 +1,102 @@
+/**
+ * RP2040 FreeRTOS Template - App #5
+ * Benchmark measurement and reporting helpers
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#ifndef BENCH_HEADER
+#define BENCH_HEADER
+
+
+#include <cstdio>
+#include <cstdint>
+#if defined(PICO_ON_DEVICE) && PICO_ON_DEVICE
+#include <malloc.h>
+// Pico SDK
+#include "pico/stdlib.h"
+#else
+// Host-side builds of portable benchmarks
+#include <chrono>
+#endif
+
+
+/**
+    Running min/max/mean of a series of measurements.
+ */
+struct Bench_Stats {
+    uint32_t    count = 0;
+    uint32_t    min = UINT32_MAX;
+    uint32_t    max = 0;
+    uint64_t    sum = 0;
+
+    void add(uint32_t value) {
+        count++;
+        sum += value;
+        if (value < min) min = value;
+        if (value > max) max = value;
+    }
+
+    // Mean scaled by 1000, eg. nanoseconds from microsecond samples
+    uint32_t mean_milli() const {
+        return count > 0 ? (uint32_t)((sum * 1000) / count) : 0;
+    }
+};
+
+
+/**
+ * @brief Emit one result as a CSV record:
+ *        `BENCH,<benchmark>,<metric>,<value>,<unit>`.
+ */
+inline void bench_report(const char* bench, const char* metric, uint32_t value, const char* unit) {
+    printf("BENCH,%s,%s,%lu,%s\n", bench, metric, (unsigned long)value, unit);
+}
+
+/**
+ * @brief Emit a latency series: min and max in us, mean in ns.
+ */
+inline void bench_report_stats(const char* bench, const char* metric, const Bench_Stats& stats) {
+    char name[48];
+    snprintf(name, sizeof(name), "%s_min", metric);
+    bench_report(bench, name, stats.min, "us");
+    snprintf(name, sizeof(name), "%s_mean", metric);
+    bench_report(bench, name, stats.mean_milli(), "ns");
+    snprintf(name, sizeof(name), "%s_max", metric);
+    bench_report(bench, name, stats.max, "us");
+}
+
+/**
+ * @brief Microseconds since boot on target, or since an arbitrary
+ *        epoch on the host.
+ */
+inline uint64_t bench_now_us() {
+#if defined(PICO_ON_DEVICE) && PICO_ON_DEVICE
+    return time_us_64();
+#else
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+/**
+ * @brief Emit the cost of one operation, given the time taken by
+ *        `iterations` of them.
+ */
+inline void bench_report_per_op(const char* bench, const char* metric, uint64_t elapsed_us, uint32_t iterations) {
+    bench_report(bench, metric, (uint32_t)((elapsed_us * 1000) / iterations), "ns");
+}
+
+#if defined(PICO_ON_DEVICE) && PICO_ON_DEVICE
+/**
+ * @brief Bytes currently allocated from the C heap, which FreeRTOS
+ *        also uses via `heap_3.c`.
+ */
+inline uint32_t bench_heap_used() {
+    struct mallinfo info = mallinfo();
+    return (uint32_t)info.uordblks;
+}
+#endif
+
+
+#endif  // BENCH_HEADER
@@ -0,0 +1,127 @@
+/**
+ * RP2040 FreeRTOS Template - App #5
+ * ADC pipeline benchmarks: CIC decimation cost per buffer
+ *
+ * First, the decimator runs over a synthetic buffer for one, two and
+ * four inputs and two decimation rates. The time per buffer is compared
+ * with the time the DMA takes to fill one at 500,000 samples a second.
+ * Then the pipeline runs for real over input 3, VSYS / 3 on a Pico, and
+ * the temperature sensor, while this task drains the frames.
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#include "main.h"
+#include "../Common/adc_pipeline.h"
+
+
+/*
+ * CONSTANTS
+ */
+#define ADC_BENCH_BUFFERS           16
+#define ADC_BENCH_RUN_MS            500
+// Input 3 reads VSYS through a 3:1 divider; the ADC reference is 3.3V
+#define ADC_BENCH_VSYS_INPUT        3
+#define ADC_BENCH_TEMP_INPUT        4
+
+static_assert(Board::ADC_INPUTS & (1 << ADC_BENCH_VSYS_INPUT), "The board doesn't wire the VSYS ADC input");
+#define ADC_BENCH_VREF_MV           3300
+#define ADC_BENCH_VSYS_DIVIDER      3
+
+
+/*
+ * GLOBALS
+ */
+static uint16_t         samples[ADC_PIPELINE_BUFFER_SAMPLES];
+static ADC_Pipeline     pipeline;
+static volatile uint32_t    sink_frames = 0;
+
+
+/*
+ * HELPERS
+ */
+
+static void count_frame(void* unused_context, const ADC_Frame& frame) {
+    sink_frames = sink_frames + 1;
+}
+
+/**
+ * @brief Time the decimator over ADC_BENCH_BUFFERS buffers, and report
+ *        the mean time per buffer and the CPU load at the maximum rate.
+ */
+static void run_decimator(uint8_t inputs, uint32_t rate_bits) {
+    CIC_Decimator decimator;
+    decimator.configure(inputs, rate_bits);
+    char metric[40];
+
+    const uint64_t start = bench_now_us();
+    for (uint32_t i = 0 ; i < ADC_BENCH_BUFFERS ; ++i) decimator.process(samples, ADC_PIPELINE_BUFFER_SAMPLES, count_frame, nullptr);
+    const uint32_t per_buffer = (uint32_t)((bench_now_us() - start) / ADC_BENCH_BUFFERS);
+
+    // Microseconds to fill a buffer at the maximum rate
+    const uint32_t budget = (uint32_t)((uint64_t)ADC_PIPELINE_BUFFER_SAMPLES * 1000000 / ADC_PIPELINE_MAX_RATE);
+    snprintf(metric, sizeof(metric), "cic_%lu_inputs_r%u", (unsigned long)decimator.get_input_count(), 1u << rate_bits);
+    bench_report("adc", metric, per_buffer, "us");
+    snprintf(metric, sizeof(metric), "cic_%lu_inputs_r%u_load", (unsigned long)decimator.get_input_count(), 1u << rate_bits);
+    bench_report("adc", metric, per_buffer * 10000 / budget, "bp");
+}
+
+
+/*
+ * BENCHMARKS
+ */
+
+/**
+ * @brief Cost the decimator per buffer, then run the pipeline at the
+ *        maximum rate and report its load, losses and a VSYS reading.
+ */
+void bench_adc() {
+    // A ramp with some noise, across the ADC's 12 bits
+    uint32_t seed = 0x2545F491;
+    for (uint32_t i = 0 ; i < ADC_PIPELINE_BUFFER_SAMPLES ; ++i) {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        samples[i] = (uint16_t)((i * 4 + (seed & 0x3F)) & 0x0FFF);
+    }
+
+    run_decimator(0x01, 4);
+    run_decimator(0x01, 6);
+    run_decimator(0x03, 6);
+    run_decimator(0x0F, 6);
+
+    // Live: the pipeline's task preempts this one to decimate each buffer
+    const ADC_Pipeline_Config config = {
+        .inputs = (1 << ADC_BENCH_VSYS_INPUT) | (1 << ADC_BENCH_TEMP_INPUT),
+        .sample_rate = ADC_PIPELINE_MAX_RATE,
+        .rate_bits = 6
+    };
+
+    if (!pipeline.begin(config)) {
+        bench_report("adc", "error", 1, "count");
+        return;
+    }
+
+    ADC_Frame frame = {};
+    uint32_t frames = 0;
+    const uint64_t start = bench_now_us();
+    const uint64_t stop = start + ADC_BENCH_RUN_MS * 1000;
+    while (bench_now_us() < stop) {
+        if (pipeline.receive(&frame, 1)) frames++;
+    }
+
+    const uint32_t elapsed = (uint32_t)(bench_now_us() - start);
+    const uint32_t busy = (uint32_t)pipeline.get_busy_total_us();
+    const uint32_t vsys_mv = (uint32_t)frame.values[ADC_BENCH_VSYS_INPUT] * ADC_BENCH_VREF_MV * ADC_BENCH_VSYS_DIVIDER / (4096 << ADC_FRAME_FRACTION_BITS);
+    pipeline.end();
+
+    bench_report("adc", "live_buffers", pipeline.get_buffers(), "count");
+    bench_report("adc", "live_frames", frames, "count");
+    bench_report("adc", "live_overruns", pipeline.get_overruns(), "count");
+    bench_report("adc", "live_dropped", pipeline.get_dropped(), "count");
+    bench_report("adc", "live_buffer_max", pipeline.get_busy_max_us(), "us");
+    bench_report("adc", "live_load", elapsed > 0 ? (uint32_t)((uint64_t)busy * 10000 / elapsed) : 0, "bp");
+    bench_report("adc", "live_vsys", vsys_mv, "mV");
+}
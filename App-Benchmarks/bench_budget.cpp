@@ -0,0 +1,129 @@
+/**
+ * RP2040 FreeRTOS Template - App #5
+ * CPU budget benchmarks: a well-behaved task beside a runaway one
+ *
+ * A runaway task spins for 200ms above the benchmark task, which wakes
+ * every tick and records the gap between its runs. With no budget, the
+ * runaway takes the CPU for the whole 200ms. With a budget of 3ms in
+ * every 10ms window, it is demoted or suspended once it overruns, so
+ * the benchmark task's gaps stay short.
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#include "main.h"
+#include "../Common/cpu_budget.h"
+
+
+/*
+ * CONSTANTS
+ */
+#define BUDGET_BENCH_RUNAWAY_MS     200
+#define BUDGET_BENCH_RUN_MS         300
+#define BUDGET_BENCH_WINDOW_MS      10
+#define BUDGET_BENCH_BUDGET_US      3000
+#define BUDGET_BENCH_STACK_DEPTH    256
+
+
+/*
+ * GLOBALS
+ */
+static volatile uint32_t    stop_us = 0;
+static volatile uint32_t    spins = 0;
+static volatile bool        runaway_done = false;
+static CPU_Budget_Stats     runaway_stats;
+
+
+/*
+ * TASKS
+ */
+
+/**
+ * @brief Spin until the stop time, counting the loops as a measure of
+ *        the CPU time it got, then drop the budget and exit.
+ */
+static void task_runaway(void* unused_arg) {
+    uint32_t count = 0;
+    while ((int32_t)(time_us_32() - stop_us) < 0) count++;
+
+    spins = count;
+    runaway_stats = CPU_Budget::get_stats(NULL);
+    CPU_Budget::remove(NULL);
+    runaway_done = true;
+    vTaskDelete(NULL);
+}
+
+
+/*
+ * BENCHMARKS
+ */
+
+/**
+ * @brief Run the runaway task beside this one, with or without a budget,
+ *        and report the gaps between this task's runs.
+ */
+static void run_case(const char* name, bool budget, CPU_Budget_Action action) {
+    Bench_Stats gaps;
+    char metric[32];
+
+    // Create and budget the runaway before it can run
+    vTaskSuspendAll();
+    TaskHandle_t runaway = NULL;
+    runaway_done = false;
+    runaway_stats = {};
+    stop_us = time_us_32() + BUDGET_BENCH_RUNAWAY_MS * 1000;
+    if (xTaskCreate(task_runaway, "BENCH_RUNAWAY", BUDGET_BENCH_STACK_DEPTH, NULL, BENCH_HIGH_PRIORITY, &runaway) == pdPASS && budget) {
+        CPU_Budget::set(runaway, BUDGET_BENCH_BUDGET_US, action);
+    }
+
+    const uint32_t start = time_us_32();
+    uint32_t last = start;
+    xTaskResumeAll();
+
+    // The runaway preempts this task straight away
+    while (!runaway_done || time_us_32() - start < BUDGET_BENCH_RUN_MS * 1000) {
+        vTaskDelay(1);
+        const uint32_t now = time_us_32();
+        gaps.add(now - last);
+        last = now;
+    }
+
+    snprintf(metric, sizeof(metric), "%s_gap", name);
+    bench_report_stats("budget", metric, gaps);
+    snprintf(metric, sizeof(metric), "%s_spins", name);
+    bench_report("budget", metric, spins, "count");
+    if (budget) {
+        snprintf(metric, sizeof(metric), "%s_violations", name);
+        bench_report("budget", metric, runaway_stats.violations, "count");
+        snprintf(metric, sizeof(metric), "%s_windows", name);
+        bench_report("budget", metric, runaway_stats.windows, "count");
+        snprintf(metric, sizeof(metric), "%s_used_max", name);
+        bench_report("budget", metric, runaway_stats.max_used_us, "us");
+    }
+}
+
+
+/**
+ * @brief Measure a tick-driven task's gaps beside a runaway task that
+ *        is unbudgeted, then demoted and then suspended on overrun.
+ */
+void bench_budget() {
+    run_case("free", false, CPU_Budget_Action::DEMOTE);
+
+    // Let the idle task reclaim the runaway's memory
+    vTaskDelay(pdMS_TO_TICKS(10));
+
+    if (!CPU_Budget::start(BUDGET_BENCH_WINDOW_MS)) {
+        bench_report("budget", "enforced", 0, "bool");
+        return;
+    }
+
+    bench_report("budget", "window", BUDGET_BENCH_WINDOW_MS * 1000, "us");
+    bench_report("budget", "budget", BUDGET_BENCH_BUDGET_US, "us");
+    run_case("demote", true, CPU_Budget_Action::DEMOTE);
+    vTaskDelay(pdMS_TO_TICKS(10));
+    run_case("suspend", true, CPU_Budget_Action::SUSPEND);
+    vTaskDelay(pdMS_TO_TICKS(10));
+}
@@ -0,0 +1,128 @@
+/**
+ * RP2040 FreeRTOS Template - App #5
+ * Coroutine executor benchmarks: RAM per activity and resume latency
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#include "main.h"
+#include "../Common/coro.h"
+
+
+/*
+ * CONSTANTS
+ */
+#define CORO_BENCH_ACTIVITIES       8
+#define CORO_BENCH_STACK_DEPTH      128
+#define CORO_BENCH_WAKES            1000
+
+
+/*
+ * GLOBALS
+ */
+static Coro::Executor   ram_executor;
+static Coro::Executor   latency_executor;
+static Coro::Event      latency_event;
+static TaskHandle_t     latency_task = NULL;
+static volatile uint32_t stamp_us = 0;
+static Bench_Stats      coro_stats;
+static Bench_Stats      task_stats;
+
+
+/*
+ * ACTIVITIES
+ */
+
+/**
+ * @brief A minimal LED-flip style activity: sleep, do a little work, repeat.
+ */
+static Coro::Task coro_activity(uint32_t cycles) {
+    for (uint32_t i = 0 ; i < cycles ; ++i) {
+        co_await Coro::sleep(1);
+    }
+}
+
+static void task_activity(void* unused_arg) {
+    vTaskSuspend(NULL);
+}
+
+static Coro::Task coro_latency() {
+    while (true) {
+        co_await latency_event.wait();
+        coro_stats.add(time_us_32() - stamp_us);
+    }
+}
+
+static void task_latency(void* unused_arg) {
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        task_stats.add(time_us_32() - stamp_us);
+    }
+}
+
+
+/*
+ * BENCHMARKS
+ */
+
+/**
+ * @brief Compare the heap cost of N activities as FreeRTOS tasks and as
+ *        coroutines on one Executor, then the latency from a wake-up
+ *        signal to the waiting activity running.
+ */
+void bench_coro() {
+    // RAM: tasks
+    TaskHandle_t handles[CORO_BENCH_ACTIVITIES] = {NULL};
+    uint32_t before = bench_heap_used();
+    for (uint32_t i = 0 ; i < CORO_BENCH_ACTIVITIES ; ++i) {
+        xTaskCreate(task_activity, "BENCH_ACT", CORO_BENCH_STACK_DEPTH, NULL, BENCH_TASK_PRIORITY, &handles[i]);
+    }
+
+    const uint32_t task_bytes = bench_heap_used() - before;
+    for (uint32_t i = 0 ; i < CORO_BENCH_ACTIVITIES ; ++i) {
+        if (handles[i] != NULL) vTaskDelete(handles[i]);
+    }
+
+    // Let the idle task reclaim the deleted tasks' memory
+    vTaskDelay(pdMS_TO_TICKS(100));
+
+    // RAM: coroutines, including the one task they all share
+    before = bench_heap_used();
+    for (uint32_t i = 0 ; i < CORO_BENCH_ACTIVITIES ; ++i) {
+        ram_executor.spawn(coro_activity(10));
+    }
+
+    const uint32_t frames = Coro::frame_count;
+    const uint32_t frame_bytes = Coro::frame_bytes;
+    ram_executor.start("BENCH_EXEC", CORO_BENCH_STACK_DEPTH, BENCH_TASK_PRIORITY);
+    const uint32_t coro_bytes = bench_heap_used() - before;
+
+    bench_report("coro", "activities", CORO_BENCH_ACTIVITIES, "count");
+    bench_report("coro", "task_heap_total", task_bytes, "bytes");
+    bench_report("coro", "task_heap_each", task_bytes / CORO_BENCH_ACTIVITIES, "bytes");
+    bench_report("coro", "coro_heap_total", coro_bytes, "bytes");
+    bench_report("coro", "coro_frame_each", frames > 0 ? frame_bytes / frames : 0, "bytes");
+
+    // Wait for the activities to complete and free their frames
+    vTaskDelay(pdMS_TO_TICKS(100));
+    bench_report("coro", "frames_after_exit", Coro::frame_count, "count");
+
+    // Latency: both waiters run above this task, so each signal
+    // preempts it and the delta is the signal-to-resume path
+    latency_executor.spawn(coro_latency());
+    latency_executor.start("BENCH_EXEC", CORO_BENCH_STACK_DEPTH, BENCH_HIGH_PRIORITY);
+    xTaskCreate(task_latency, "BENCH_WAIT", CORO_BENCH_STACK_DEPTH, NULL, BENCH_HIGH_PRIORITY, &latency_task);
+    vTaskDelay(1);
+
+    for (uint32_t i = 0 ; i < CORO_BENCH_WAKES ; ++i) {
+        stamp_us = time_us_32();
+        latency_event.set();
+        stamp_us = time_us_32();
+        xTaskNotifyGive(latency_task);
+    }
+
+    bench_report_stats("coro", "coro_resume", coro_stats);
+    bench_report_stats("coro", "task_resume", task_stats);
+}
@@ -0,0 +1,210 @@
+/**
+ * RP2040 FreeRTOS Template - App #5
+ * EDF benchmarks: deadline misses under EDF versus fixed priorities
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#include "main.h"
+#include "../Common/edf.h"
+
+
+/*
+ * CONSTANTS
+ */
+#define EDF_BENCH_TASKS             3
+#define EDF_BENCH_RUN_MS            5000
+#define EDF_BENCH_STACK_DEPTH       256
+
+
+/**
+    A periodic task set: period, deadline and execution time in ticks.
+    The periods are in rate-monotonic order, highest priority first.
+ */
+struct Task_Set {
+    const char* name;
+    TickType_t  period[EDF_BENCH_TASKS];
+    TickType_t  deadline[EDF_BENCH_TASKS];
+    TickType_t  cost[EDF_BENCH_TASKS];
+};
+
+/**
+    One benchmark task's parameters and results.
+ */
+struct Bench_Job {
+    const Task_Set* set;
+    int             index;
+    uint32_t        jobs;
+    uint32_t        misses;
+    TickType_t      max_lateness;
+};
+
+
+/*
+ * GLOBALS
+ */
+// U = 0.92: within EDF's bound of 1, over the rate-monotonic
+// bound of 0.78 for three tasks. Then U = 1.08: overloaded
+static const Task_Set   sets[] = {
+    {"heavy",    {10, 15, 20}, {10, 15, 20}, {3, 4, 7}},
+    {"overload", {10, 15, 20}, {10, 15, 20}, {3, 5, 9}}
+};
+
+static EDF_Supervisor*  edf = nullptr;
+static Bench_Job        bench_jobs[EDF_BENCH_TASKS];
+static TaskHandle_t     handles[EDF_BENCH_TASKS];
+static volatile uint32_t loops_per_tick = 0;
+static volatile uint32_t sink = 0;
+static volatile bool    running = false;
+
+
+/*
+ * HELPERS
+ */
+
+/**
+ * @brief Burn CPU time: a fixed amount of work, so preemption
+ *        stretches the job rather than shortening it.
+ */
+static void work(TickType_t ticks) {
+    const uint32_t loops = ticks * loops_per_tick;
+    for (uint32_t i = 0 ; i < loops ; ++i) sink = sink + i;
+}
+
+static void calibrate() {
+    const uint32_t loops = 100000;
+    const uint64_t start = bench_now_us();
+    for (uint32_t i = 0 ; i < loops ; ++i) sink = sink + i;
+    const uint64_t elapsed = bench_now_us() - start;
+    loops_per_tick = (uint32_t)((loops * (uint64_t)(1000000 / configTICK_RATE_HZ)) / elapsed);
+}
+
+
+/*
+ * TASKS
+ */
+static void task_edf_job(void* arg) {
+    Bench_Job* job = (Bench_Job*)arg;
+    while (running) {
+        edf->wait_release(job->index);
+        work(job->set->cost[job->index]);
+        edf->complete(job->index);
+    }
+
+    vTaskSuspend(NULL);
+}
+
+/**
+ * @brief The same job at a fixed priority. Releases follow the EDF
+ *        supervisor's policy: an overrun delays the next release and
+ *        missed periods are skipped.
+ */
+static void task_fixed_job(void* arg) {
+    Bench_Job* job = (Bench_Job*)arg;
+    const TickType_t period = job->set->period[job->index];
+    TickType_t next = xTaskGetTickCount();
+
+    while (running) {
+        TickType_t now = xTaskGetTickCount();
+        if ((int32_t)(next - now) > 0) vTaskDelay(next - now);
+
+        const TickType_t release = next;
+        now = xTaskGetTickCount();
+        while ((int32_t)(now - next) >= 0) next += period;
+
+        work(job->set->cost[job->index]);
+
+        const TickType_t late = xTaskGetTickCount() - (release + job->set->deadline[job->index]);
+        if ((int32_t)late > 0) {
+            job->misses++;
+            if (late > job->max_lateness) job->max_lateness = late;
+        }
+
+        job->jobs++;
+    }
+
+    vTaskSuspend(NULL);
+}
+
+
+/*
+ * BENCHMARKS
+ */
+
+/**
+ * @brief Run one task set under one policy and report its misses.
+ */
+static void run_set(const Task_Set& set, bool use_edf) {
+    EDF_Supervisor supervisor;
+    edf = &supervisor;
+    running = true;
+
+    for (uint32_t i = 0 ; i < EDF_BENCH_TASKS ; ++i) {
+        bench_jobs[i] = {&set, (int)i, 0, 0, 0};
+        if (use_edf) {
+            bench_jobs[i].index = supervisor.add(set.period[i], set.deadline[i]);
+            xTaskCreate(task_edf_job, "BENCH_EDF", EDF_BENCH_STACK_DEPTH, &bench_jobs[i], EDF_PRIORITY_LOWEST, &handles[i]);
+        } else {
+            // Rate-monotonic: shortest period, highest priority
+            xTaskCreate(task_fixed_job, "BENCH_RM", EDF_BENCH_STACK_DEPTH, &bench_jobs[i], EDF_PRIORITY_HIGHEST - i, &handles[i]);
+        }
+    }
+
+    if (use_edf) supervisor.start();
+    vTaskDelay(pdMS_TO_TICKS(EDF_BENCH_RUN_MS));
+    running = false;
+    if (use_edf) supervisor.stop();
+
+    uint32_t jobs = 0;
+    uint32_t misses = 0;
+    TickType_t lateness = 0;
+    for (uint32_t i = 0 ; i < EDF_BENCH_TASKS ; ++i) {
+        vTaskDelete(handles[i]);
+        if (use_edf) {
+            const EDF_Stats stats = supervisor.get_stats(bench_jobs[i].index);
+            bench_jobs[i].jobs = stats.jobs;
+            bench_jobs[i].misses = stats.misses;
+            bench_jobs[i].max_lateness = stats.max_lateness;
+        }
+
+        jobs += bench_jobs[i].jobs;
+        misses += bench_jobs[i].misses;
+        if (bench_jobs[i].max_lateness > lateness) lateness = bench_jobs[i].max_lateness;
+
+        char name[48];
+        snprintf(name, sizeof(name), "%s_%s_task%lu_misses", set.name, use_edf ? "edf" : "rm", (unsigned long)i);
+        bench_report("edf", name, bench_jobs[i].misses, "count");
+    }
+
+    char name[48];
+    snprintf(name, sizeof(name), "%s_%s_jobs", set.name, use_edf ? "edf" : "rm");
+    bench_report("edf", name, jobs, "count");
+    snprintf(name, sizeof(name), "%s_%s_miss_ratio", set.name, use_edf ? "edf" : "rm");
+    bench_report("edf", name, jobs > 0 ? (misses * 1000) / jobs : 0, "milli");
+    snprintf(name, sizeof(name), "%s_%s_lateness_max", set.name, use_edf ? "edf" : "rm");
+    bench_report("edf", name, (uint32_t)lateness, "ticks");
+
+    // Let the idle task reclaim the deleted tasks' memory
+    edf = nullptr;
+    vTaskDelay(pdMS_TO_TICKS(20));
+}
+
+/**
+ * @brief Run each task set with EDF and with rate-monotonic fixed
+ *        priorities, and compare deadline misses.
+ */
+void bench_edf() {
+    // Stay above the jobs so the run ends on time
+    const UBaseType_t priority = uxTaskPriorityGet(NULL);
+    vTaskPrioritySet(NULL, EDF_SUPERVISOR_PRIORITY);
+    calibrate();
+
+    for (const Task_Set& set : sets) {
+        run_set(set, false);
+        run_set(set, true);
+    }
+
+    vTaskPrioritySet(NULL, priority);
+}
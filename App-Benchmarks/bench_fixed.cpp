@@ -0,0 +1,169 @@
+/**
+ * RP2040 FreeRTOS Template - App #5
+ * Fixed-point library benchmarks: Q-format versus soft-float `double`
+ *
+ * Runs on target as part of App #5. To run the portable fallback
+ * on the host:
+ *
+ *   g++ -std=c++20 -O2 App-Benchmarks/bench_fixed.cpp -o bench_fixed && ./bench_fixed
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#if defined(PICO_ON_DEVICE) && PICO_ON_DEVICE
+#include "main.h"
+#else
+#include "bench.h"
+#endif
+#include "../Common/fixed.h"
+
+
+/*
+ * CONSTANTS
+ */
+#define FIXED_BENCH_ITERATIONS      10000
+#define FIXED_BENCH_INPUTS          16
+
+
+/*
+ * GLOBALS
+ */
+// Results go to volatiles so the work isn't optimised away
+static volatile int32_t     sink_int = 0;
+static volatile double      sink_double = 0.0;
+
+// Sample MCP9808 ambient register values, -20C to +60C
+static const uint16_t       raw_temps[FIXED_BENCH_INPUTS] = {
+    0x1EC0, 0x1F40, 0x1FC4, 0x0000, 0x0038, 0x00A0, 0x0110, 0x0158,
+    0x0191, 0x01C8, 0x0200, 0x0264, 0x02C0, 0x0318, 0x0388, 0x03C0
+};
+
+// A nine-point table over [0, 2048), eg. a sensor linearisation curve
+static const int32_t        curve[9] = {0, 410, 790, 1130, 1420, 1660, 1850, 1980, 2048};
+static const Fixed_Lut<8, 8, 8> curve_lut(curve);
+
+
+/*
+ * LEGACY IMPLEMENTATIONS
+ */
+static double legacy_get_temp(uint32_t temp_raw) {
+    double temp_cel = (temp_raw & 0x0FFF) / 16.0;
+    if (temp_raw & 0x1000) temp_cel = 256.0 - temp_cel;
+    return temp_cel;
+}
+
+static uint32_t legacy_bcd(uint32_t base) {
+    for (uint32_t i = 0 ; i < 16 ; ++i) {
+        base = base << 1;
+        if (i == 15) break;
+        if ((base & 0x000F0000) > 0x0004FFFF) base += 0x00030000;
+        if ((base & 0x00F00000) > 0x004FFFFF) base += 0x00300000;
+        if ((base & 0x0F000000) > 0x04FFFFFF) base += 0x03000000;
+        if ((base & 0xF0000000) > 0x4FFFFFFF) base += 0x30000000;
+    }
+
+    return (base >> 16) & 0xFFFF;
+}
+
+static uint32_t divider_bcd(uint32_t base) {
+    uint32_t result = 0;
+    for (uint32_t shift = 0 ; shift < 16 ; shift += 4) {
+        uint32_t digit = 0;
+        base = FixedMath::divmod_u32(base, 10, &digit);
+        result |= digit << shift;
+    }
+
+    return result;
+}
+
+
+/*
+ * BENCHMARKS
+ */
+
+/**
+ * @brief Time each fixed-point operation against its `double` equivalent.
+ */
+void bench_fixed() {
+    Fixed<16> fixed_in[FIXED_BENCH_INPUTS];
+    double double_in[FIXED_BENCH_INPUTS];
+    for (uint32_t i = 0 ; i < FIXED_BENCH_INPUTS ; ++i) {
+        fixed_in[i] = Fixed<16>::from_ratio((int32_t)(i * 37 + 5), 16);
+        double_in[i] = (i * 37 + 5) / 16.0;
+    }
+
+    const uint32_t n = FIXED_BENCH_ITERATIONS;
+    const uint32_t mask = FIXED_BENCH_INPUTS - 1;
+    uint64_t start = 0;
+
+    // Multiply
+    start = bench_now_us();
+    for (uint32_t i = 0 ; i < n ; ++i) sink_double = double_in[i & mask] * double_in[(i + 3) & mask];
+    bench_report_per_op("fixed", "mul_double", bench_now_us() - start, n);
+
+    start = bench_now_us();
+    for (uint32_t i = 0 ; i < n ; ++i) sink_int = (fixed_in[i & mask] * fixed_in[(i + 3) & mask]).raw;
+    bench_report_per_op("fixed", "mul_q16", bench_now_us() - start, n);
+
+    // Divide
+    start = bench_now_us();
+    for (uint32_t i = 0 ; i < n ; ++i) sink_double = double_in[i & mask] / double_in[(i + 5) & mask];
+    bench_report_per_op("fixed", "div_double", bench_now_us() - start, n);
+
+    start = bench_now_us();
+    for (uint32_t i = 0 ; i < n ; ++i) sink_int = (fixed_in[i & mask] / fixed_in[(i + 5) & mask]).raw;
+    bench_report_per_op("fixed", "div_q16", bench_now_us() - start, n);
+
+    // Scale: sensor register to Celsius
+    start = bench_now_us();
+    for (uint32_t i = 0 ; i < n ; ++i) sink_double = legacy_get_temp(raw_temps[i & mask]);
+    bench_report_per_op("fixed", "scale_double", bench_now_us() - start, n);
+
+    start = bench_now_us();
+    for (uint32_t i = 0 ; i < n ; ++i) sink_int = Fixed<4>::from_field<0, 12, 4>(raw_temps[i & mask]).raw;
+    bench_report_per_op("fixed", "scale_q4", bench_now_us() - start, n);
+
+    // Lookup with linear interpolation
+    start = bench_now_us();
+    for (uint32_t i = 0 ; i < n ; ++i) {
+        const double x = (double)((i * 131) & 2047) / 256.0;
+        const uint32_t index = (uint32_t)x;
+        sink_double = curve[index] + (curve[index + 1] - curve[index]) * (x - index);
+    }
+    bench_report_per_op("fixed", "lookup_double", bench_now_us() - start, n);
+
+    start = bench_now_us();
+    for (uint32_t i = 0 ; i < n ; ++i) sink_int = curve_lut.lookup((int32_t)((i * 131) & 2047)).raw;
+    bench_report_per_op("fixed", "lookup_q8", bench_now_us() - start, n);
+
+    // Integer to BCD for the display
+    start = bench_now_us();
+    for (uint32_t i = 0 ; i < n ; ++i) sink_int = legacy_bcd(i % 10000);
+    bench_report_per_op("fixed", "bcd_shift_add", bench_now_us() - start, n);
+
+    start = bench_now_us();
+    for (uint32_t i = 0 ; i < n ; ++i) sink_int = divider_bcd(i % 10000);
+    bench_report_per_op("fixed", "bcd_divider", bench_now_us() - start, n);
+
+    // Display formatting
+    char text[16];
+    start = bench_now_us();
+    for (uint32_t i = 0 ; i < n / 10 ; ++i) sink_int = snprintf(text, sizeof(text), "%.2f", double_in[i & mask]);
+    bench_report_per_op("fixed", "format_double", bench_now_us() - start, n / 10);
+
+    start = bench_now_us();
+    for (uint32_t i = 0 ; i < n / 10 ; ++i) sink_int = (int32_t)fixed_in[i & mask].to_chars(text, sizeof(text), 2);
+    bench_report_per_op("fixed", "format_q16", bench_now_us() - start, n / 10);
+
+    bench_report("fixed", "on_target", FIXED_ON_TARGET, "bool");
+}
+
+
+#if !(defined(PICO_ON_DEVICE) && PICO_ON_DEVICE)
+int main() {
+    bench_fixed();
+    return 0;
+}
+#endif
@@ -0,0 +1,207 @@
+/**
+ * RP2040 FreeRTOS Template - App #5
+ * Idle work benchmarks: RAM saved and latency versus housekeeping tasks
+ *
+ * Housekeeping is run two ways: as tasks of its own, each with a
+ * stack and TCB, and as `Idle_Work` items on the idle task's stack. The
+ * latency from a request to the item starting is measured with the
+ * kernel otherwise idle, and then with a task keeping the CPU two-thirds
+ * busy. The item order by priority is checked, and a long job is run in
+ * budgeted slices.
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#include "main.h"
+#include "../Common/idle_work.h"
+
+
+/*
+ * CONSTANTS
+ */
+// Housekeeping tasks replaced, eg. log draining, flash batching and stats
+#define IDLE_BENCH_TASKS            3
+#define IDLE_BENCH_STACK_DEPTH      256
+#define IDLE_BENCH_REQUESTS         200
+// The load task spins this long, then sleeps a tick
+#define IDLE_BENCH_LOAD_SPIN_US     2000
+#define IDLE_BENCH_BUDGET_US        200
+#define IDLE_BENCH_JOB_BYTES        32768
+#define IDLE_BENCH_JOB_CHUNK        256
+
+
+/*
+ * GLOBALS
+ */
+static TaskHandle_t         bench_task = NULL;
+static volatile uint32_t    stamp_us = 0;
+static Bench_Stats          rest_stats;
+static Bench_Stats          busy_stats;
+static Bench_Stats*         latency_stats = nullptr;
+static volatile bool        load_running = false;
+
+static volatile uint32_t    order[2] = {0};
+static volatile uint32_t    order_count = 0;
+
+static uint8_t              job_data[IDLE_BENCH_JOB_BYTES];
+static uint32_t             job_offset = 0;
+static uint32_t             job_sum = 0;
+
+
+/*
+ * TASKS AND ITEMS
+ */
+
+/**
+ * @brief A housekeeping task that waits for work, as each would without
+ *        idle work.
+ */
+static void task_housekeeping(void* unused_arg) {
+    while (true) ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+}
+
+/**
+ * @brief Keep the CPU busy at the benchmark's priority, in bursts.
+ */
+static void task_load(void* unused_arg) {
+    while (load_running) {
+        busy_wait_us_32(IDLE_BENCH_LOAD_SPIN_US);
+        vTaskDelay(1);
+    }
+
+    vTaskDelete(NULL);
+}
+
+static bool item_ping(void* unused_context) {
+    latency_stats->add(time_us_32() - stamp_us);
+    xTaskNotifyGive(bench_task);
+    return false;
+}
+
+static bool item_order(void* context) {
+    const uint32_t n = order_count;
+    if (n < 2) order[n] = (uint32_t)(uintptr_t)context;
+    order_count = n + 1;
+    if (order_count == 2) xTaskNotifyGive(bench_task);
+    return false;
+}
+
+/**
+ * @brief Sum the job's data in chunks for as long as the budget lasts.
+ */
+static bool item_job(void* unused_context) {
+    while (job_offset < IDLE_BENCH_JOB_BYTES) {
+        for (uint32_t i = 0 ; i < IDLE_BENCH_JOB_CHUNK ; ++i) job_sum += job_data[job_offset + i];
+        job_offset += IDLE_BENCH_JOB_CHUNK;
+        if (!Idle_Work::has_time()) return true;
+    }
+
+    xTaskNotifyGive(bench_task);
+    return false;
+}
+
+
+/*
+ * BENCHMARKS
+ */
+
+/**
+ * @brief Time requests until the item has run, or its notification times out.
+ */
+static void measure_latency(int32_t item, Bench_Stats& stats) {
+    latency_stats = &stats;
+    for (uint32_t i = 0 ; i < IDLE_BENCH_REQUESTS ; ++i) {
+        stamp_us = time_us_32();
+        Idle_Work::request(item);
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(50));
+    }
+}
+
+
+/**
+ * @brief Compare the heap cost of housekeeping tasks with idle work
+ *        items, then measure idle work's latency, ordering and budgets.
+ */
+void bench_idle() {
+    bench_task = xTaskGetCurrentTaskHandle();
+
+    // RAM: housekeeping tasks
+    TaskHandle_t handles[IDLE_BENCH_TASKS] = {NULL};
+    const uint32_t before = bench_heap_used();
+    for (uint32_t i = 0 ; i < IDLE_BENCH_TASKS ; ++i) {
+        xTaskCreate(task_housekeeping, "BENCH_HOUSE", IDLE_BENCH_STACK_DEPTH, NULL, BENCH_TASK_PRIORITY, &handles[i]);
+    }
+
+    const uint32_t task_bytes = bench_heap_used() - before;
+    for (uint32_t i = 0 ; i < IDLE_BENCH_TASKS ; ++i) {
+        if (handles[i] != NULL) vTaskDelete(handles[i]);
+    }
+
+    // Let the idle task reclaim the deleted tasks' memory
+    vTaskDelay(pdMS_TO_TICKS(100));
+
+    // Items are static: the table's share for the same work
+    const uint32_t item_bytes = Idle_Work::get_item_size() * IDLE_BENCH_TASKS;
+    bench_report("idle", "housekeeping", IDLE_BENCH_TASKS, "count");
+    bench_report("idle", "task_heap_total", task_bytes, "bytes");
+    bench_report("idle", "item_ram_total", item_bytes, "bytes");
+    bench_report("idle", "ram_saved", task_bytes > item_bytes ? task_bytes - item_bytes : 0, "bytes");
+
+    // Without the hook, nothing calls the items
+    #if configUSE_IDLE_HOOK == 0
+    bench_report("idle", "idle_hook", 0, "bool");
+    return;
+    #endif
+
+    const int32_t ping = Idle_Work::add(item_ping, nullptr, 2, IDLE_BENCH_BUDGET_US);
+    const int32_t low = Idle_Work::add(item_order, (void*)1, 1, IDLE_BENCH_BUDGET_US);
+    const int32_t high = Idle_Work::add(item_order, (void*)3, 3, IDLE_BENCH_BUDGET_US);
+    const int32_t job = Idle_Work::add(item_job, nullptr, 0, IDLE_BENCH_BUDGET_US);
+    if (ping == IDLE_WORK_NONE || low == IDLE_WORK_NONE || high == IDLE_WORK_NONE || job == IDLE_WORK_NONE) {
+        bench_report("idle", "items_added", Idle_Work::get_count(), "count");
+        return;
+    }
+
+    // Latency: first with nothing else ready, so the item runs as soon
+    // as this task blocks
+    measure_latency(ping, rest_stats);
+    bench_report_stats("idle", "rest_latency", rest_stats);
+
+    // ...then with a task at this priority busy for 2ms of every 3ms
+    load_running = true;
+    xTaskCreate(task_load, "BENCH_LOAD", IDLE_BENCH_STACK_DEPTH, NULL, BENCH_TASK_PRIORITY, NULL);
+    measure_latency(ping, busy_stats);
+    load_running = false;
+    vTaskDelay(pdMS_TO_TICKS(10));
+    bench_report_stats("idle", "busy_latency", busy_stats);
+
+    const Idle_Item_Stats ping_stats = Idle_Work::get_stats(ping);
+    bench_report("idle", "ping_runs", ping_stats.runs, "count");
+    bench_report("idle", "ping_run_max", ping_stats.max_run_us, "us");
+
+    // Order: request the low-priority item first, then the high
+    order_count = 0;
+    Idle_Work::request(low);
+    Idle_Work::request(high);
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(50));
+    bench_report("idle", "priority_order", order_count == 2 && order[0] == 3 && order[1] == 1, "bool");
+
+    // Budgets: a 32KB job in slices of about 200us
+    for (uint32_t i = 0 ; i < IDLE_BENCH_JOB_BYTES ; ++i) job_data[i] = (uint8_t)i;
+    job_offset = 0;
+    job_sum = 0;
+    const uint64_t start = bench_now_us();
+    Idle_Work::request(job);
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(1000));
+    const uint32_t elapsed = (uint32_t)(bench_now_us() - start);
+
+    const Idle_Item_Stats job_stats = Idle_Work::get_stats(job);
+    bench_report("idle", "job_complete", job_sum == (IDLE_BENCH_JOB_BYTES / 256) * (255 * 256 / 2), "bool");
+    bench_report("idle", "job_time", elapsed, "us");
+    bench_report("idle", "job_slices", job_stats.runs, "count");
+    bench_report("idle", "job_slice_max", job_stats.max_run_us, "us");
+    bench_report("idle", "job_budget", IDLE_BENCH_BUDGET_US, "us");
+    bench_report("idle", "job_overruns", job_stats.overruns, "count");
+}
@@ -0,0 +1,224 @@
+/**
+ * RP2040 FreeRTOS Template - App #5
+ * Interrupt latency benchmarks: kernel-aware ISRs versus zero-latency ISRs
+ *
+ * A hardware alarm fires at a known time; the ISR's first act is to read
+ * the timer, so the difference is the entry latency. The same alarm is
+ * handled first on core 0, alongside FreeRTOS, and then on core 1 in the
+ * zero-latency class, each with the kernel idle and heavily loaded.
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#include "main.h"
+#include "hardware/structs/timer.h"
+#include "../Common/zero_latency.h"
+
+
+/*
+ * CONSTANTS
+ */
+#define IRQ_BENCH_SAMPLES           2000
+#define IRQ_BENCH_MIN_DELAY_US      50
+#define IRQ_BENCH_SPREAD_US         97
+#define IRQ_BENCH_CHANNEL           0
+#define IRQ_BENCH_LOAD_STACK        256
+// Length of each critical section in the load, as a driver might take
+#define IRQ_BENCH_CRITICAL_US       10
+
+
+/*
+ * GLOBALS
+ */
+struct IRQ_Sample {
+    uint32_t    latency_us;
+    uint32_t    stamp_us;
+};
+
+static SPSC_Buffer<IRQ_Sample, 16>  samples;
+static uint32_t                     alarm_num = 0;
+static volatile uint32_t            target_us = 0;
+static TaskHandle_t                 bench_task = NULL;
+
+static volatile bool                load_running = false;
+static volatile uint32_t            load_tasks = 0;
+static QueueHandle_t                ping_queue = NULL;
+static QueueHandle_t                pong_queue = NULL;
+
+
+/*
+ * ISRS
+ */
+static void __not_in_flash_func(zero_latency_isr)() {
+    const uint32_t now = timer_hw->timerawl;
+    timer_hw->intr = 1u << alarm_num;
+    samples.push({now - target_us, now});
+    Zero_Latency::ring(IRQ_BENCH_CHANNEL);
+}
+
+static void kernel_isr() {
+    const uint32_t now = timer_hw->timerawl;
+    timer_hw->intr = 1u << alarm_num;
+    samples.push({now - target_us, now});
+
+    BaseType_t higher_priority_task_woken = pdFALSE;
+    vTaskNotifyGiveFromISR(bench_task, &higher_priority_task_woken);
+    portYIELD_FROM_ISR(higher_priority_task_woken);
+}
+
+
+/*
+ * LOAD
+ */
+
+/**
+ * @brief Bounce a token between two tasks: every pass is a queue
+ *        operation, a context switch and the kernel's critical sections.
+ */
+static void task_ping(void* arg) {
+    const bool starter = arg != nullptr;
+    QueueHandle_t in = starter ? pong_queue : ping_queue;
+    QueueHandle_t out = starter ? ping_queue : pong_queue;
+    uint32_t token = 0;
+    if (starter) xQueueSend(out, &token, 0);
+
+    while (load_running) {
+        if (xQueueReceive(in, &token, 1) == pdPASS) {
+            token++;
+            xQueueSend(out, &token, 0);
+        }
+    }
+
+    load_tasks = load_tasks - 1;
+    vTaskDelete(NULL);
+}
+
+/**
+ * @brief Hold interrupts off for short periods, as drivers do when they
+ *        update state shared with their ISRs.
+ */
+static void task_critical(void* unused_arg) {
+    while (load_running) {
+        taskENTER_CRITICAL();
+        busy_wait_us_32(IRQ_BENCH_CRITICAL_US);
+        taskEXIT_CRITICAL();
+        taskYIELD();
+    }
+
+    load_tasks = load_tasks - 1;
+    vTaskDelete(NULL);
+}
+
+static void start_load() {
+    ping_queue = xQueueCreate(1, sizeof(uint32_t));
+    pong_queue = xQueueCreate(1, sizeof(uint32_t));
+    load_running = true;
+    load_tasks = 3;
+    xTaskCreate(task_ping, "BENCH_PING", IRQ_BENCH_LOAD_STACK, (void*)1, BENCH_TASK_PRIORITY, NULL);
+    xTaskCreate(task_ping, "BENCH_PONG", IRQ_BENCH_LOAD_STACK, NULL, BENCH_TASK_PRIORITY, NULL);
+    xTaskCreate(task_critical, "BENCH_CRIT", IRQ_BENCH_LOAD_STACK, NULL, BENCH_TASK_PRIORITY, NULL);
+}
+
+static void stop_load() {
+    load_running = false;
+    while (load_tasks > 0) vTaskDelay(1);
+    vTaskDelay(1);
+    vQueueDelete(ping_queue);
+    vQueueDelete(pong_queue);
+}
+
+
+/*
+ * HELPERS
+ */
+
+/**
+ * @brief Fire the alarm IRQ_BENCH_SAMPLES times at staggered offsets,
+ *        and report the ISR entry latency and the time from the ISR to
+ *        this task draining the sample.
+ *
+ * @param name: The metric prefix.
+ */
+static void measure(const char* name) {
+    Bench_Stats latency;
+    Bench_Stats handoff;
+    uint32_t missed = 0;
+    IRQ_Sample sample;
+
+    for (uint32_t i = 0 ; i < IRQ_BENCH_SAMPLES ; ++i) {
+        target_us = timer_hw->timerawl + IRQ_BENCH_MIN_DELAY_US + (i * 37) % IRQ_BENCH_SPREAD_US;
+        timer_hw->alarm[alarm_num] = target_us;
+        if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(10)) == 0) {
+            missed++;
+            continue;
+        }
+
+        const uint32_t now = time_us_32();
+        while (samples.pop(sample)) {
+            latency.add(sample.latency_us);
+            handoff.add(now - sample.stamp_us);
+        }
+    }
+
+    char metric[48];
+    snprintf(metric, sizeof(metric), "%s_latency", name);
+    bench_report_stats("irq", metric, latency);
+    snprintf(metric, sizeof(metric), "%s_handoff", name);
+    bench_report_stats("irq", metric, handoff);
+    snprintf(metric, sizeof(metric), "%s_missed", name);
+    bench_report("irq", metric, missed, "count");
+}
+
+
+/*
+ * BENCHMARKS
+ */
+
+/**
+ * @brief Compare worst-case interrupt latency on core 0, where kernel
+ *        critical sections mask every interrupt, with the zero-latency
+ *        class on core 1, with the kernel idle and then loaded.
+ */
+void bench_irq() {
+    const int alarm = hardware_alarm_claim_unused(false);
+    if (alarm < 0) {
+        bench_report("irq", "no_alarm", 1, "bool");
+        return;
+    }
+
+    alarm_num = (uint32_t)alarm;
+    const uint32_t irq = TIMER_IRQ_0 + alarm_num;
+    hw_set_bits(&timer_hw->inte, 1u << alarm_num);
+
+    // Raise this task above the load so that hand-offs preempt it
+    bench_task = xTaskGetCurrentTaskHandle();
+    vTaskPrioritySet(NULL, BENCH_HIGH_PRIORITY);
+
+    // Kernel-aware: core 0, at the map's timer priority
+    irq_set_exclusive_handler(irq, kernel_isr);
+    irq_set_enabled(irq, true);
+    measure("kernel_idle");
+    start_load();
+    measure("kernel_load");
+    stop_load();
+    irq_set_enabled(irq, false);
+    irq_remove_handler(irq, kernel_isr);
+
+    // Zero-latency: core 1, waking this task through the doorbell
+    Zero_Latency::start();
+    Zero_Latency::set_doorbell_task(IRQ_BENCH_CHANNEL, bench_task);
+    Zero_Latency::add(irq, zero_latency_isr);
+    measure("zl_idle");
+    start_load();
+    measure("zl_load");
+    stop_load();
+    Zero_Latency::remove(irq);
+    Zero_Latency::set_doorbell_task(IRQ_BENCH_CHANNEL, NULL);
+
+    hw_clear_bits(&timer_hw->inte, 1u << alarm_num);
+    hardware_alarm_unclaim(alarm_num);
+    bench_report("irq", "dropped", samples.get_dropped(), "count");
+    vTaskPrioritySet(NULL, BENCH_TASK_PRIORITY);
+}
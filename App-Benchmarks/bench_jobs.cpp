@@ -0,0 +1,169 @@
+/**
+ * RP2040 FreeRTOS Template - App #5
+ * Job system benchmarks: one core versus both on batch workloads
+ *
+ * Each workload runs once by calling its job over the whole range on
+ * core 0, then through `Jobs::parallel_for()` on both cores. The outputs
+ * must match, and the ratio of the times is the dual-core speedup.
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#include "main.h"
+#include "../Common/jobs.h"
+
+
+/*
+ * CONSTANTS
+ */
+// A flash page holds 128 16-bit samples
+#define JOBS_BENCH_PAGES            64
+#define JOBS_BENCH_PAGE_SAMPLES     128
+// Delta varints take at most three bytes per sample
+#define JOBS_BENCH_PACKED_MAX       (JOBS_BENCH_PAGE_SAMPLES * 3)
+#define JOBS_BENCH_TAPS             16
+#define JOBS_BENCH_FILTER_CHUNK     256
+#define JOBS_BENCH_SAMPLES          (JOBS_BENCH_PAGES * JOBS_BENCH_PAGE_SAMPLES)
+
+
+/*
+ * GLOBALS
+ */
+static int16_t      samples[JOBS_BENCH_SAMPLES];
+static uint8_t      packed[2][JOBS_BENCH_PAGES][JOBS_BENCH_PACKED_MAX];
+static uint16_t     packed_size[2][JOBS_BENCH_PAGES];
+static int16_t      filtered[2][JOBS_BENCH_SAMPLES];
+static int16_t      taps[JOBS_BENCH_TAPS];
+
+
+/*
+ * JOBS
+ */
+
+/**
+ * @brief Compress pages of samples: each is a first value then the
+ *        differences, zigzag-encoded as variable-length integers.
+ *        `context` selects the output set.
+ */
+static void __not_in_flash_func(compress_pages)(void* context, uint32_t begin, uint32_t end) {
+    const uint32_t set = (uint32_t)(uintptr_t)context;
+    for (uint32_t page = begin ; page < end ; ++page) {
+        const int16_t* in = samples + page * JOBS_BENCH_PAGE_SAMPLES;
+        uint8_t* out = packed[set][page];
+        uint32_t size = 0;
+        int32_t last = 0;
+        for (uint32_t i = 0 ; i < JOBS_BENCH_PAGE_SAMPLES ; ++i) {
+            const int32_t delta = in[i] - last;
+            last = in[i];
+            uint32_t zigzag = (uint32_t)((delta << 1) ^ (delta >> 31));
+            while (zigzag >= 0x80) {
+                out[size++] = (uint8_t)(zigzag | 0x80);
+                zigzag >>= 7;
+            }
+
+            out[size++] = (uint8_t)zigzag;
+        }
+
+        packed_size[set][page] = (uint16_t)size;
+    }
+}
+
+/**
+ * @brief A Q15 FIR low-pass over the samples. Each output reads the
+ *        taps before it, so any range can be computed independently.
+ */
+static void __not_in_flash_func(filter_samples)(void* context, uint32_t begin, uint32_t end) {
+    const uint32_t set = (uint32_t)(uintptr_t)context;
+    for (uint32_t i = begin ; i < end ; ++i) {
+        int32_t sum = 0;
+        for (uint32_t t = 0 ; t < JOBS_BENCH_TAPS && t <= i ; ++t) sum += (int32_t)taps[t] * samples[i - t];
+        filtered[set][i] = (int16_t)(sum >> 15);
+    }
+}
+
+
+/*
+ * HELPERS
+ */
+
+/**
+ * @brief Fill the samples with a temperature-like trace in Q4, and
+ *        the filter with equal taps that sum to one.
+ */
+static void make_inputs() {
+    uint32_t seed = 0x2545F491;
+    for (uint32_t i = 0 ; i < JOBS_BENCH_SAMPLES ; ++i) {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        const uint32_t phase = i % 2048;
+        const int32_t swing = phase < 1024 ? (int32_t)phase : (int32_t)(2048 - phase);
+        samples[i] = (int16_t)(320 + swing / 16 + (int32_t)(seed & 7) - 4);
+    }
+
+    for (uint32_t t = 0 ; t < JOBS_BENCH_TAPS ; ++t) taps[t] = 32768 / JOBS_BENCH_TAPS;
+}
+
+/**
+ * @brief Time a workload on core 0 alone, then on both cores, and
+ *        report both times and the speedup in hundredths.
+ */
+static void run_workload(const char* name, Job_Function function, uint32_t count, uint32_t chunk) {
+    char metric[40];
+    uint64_t start = bench_now_us();
+    function((void*)0, 0, count);
+    const uint32_t single_us = (uint32_t)(bench_now_us() - start);
+
+    start = bench_now_us();
+    Jobs::parallel_for(count, chunk, function, (void*)1);
+    const uint32_t dual_us = (uint32_t)(bench_now_us() - start);
+
+    snprintf(metric, sizeof(metric), "%s_single", name);
+    bench_report("jobs", metric, single_us, "us");
+    snprintf(metric, sizeof(metric), "%s_dual", name);
+    bench_report("jobs", metric, dual_us, "us");
+    snprintf(metric, sizeof(metric), "%s_speedup", name);
+    bench_report("jobs", metric, dual_us > 0 ? single_us * 100 / dual_us : 0, "x100");
+}
+
+
+/*
+ * BENCHMARKS
+ */
+
+/**
+ * @brief Compress flash pages of samples and filter the sample stream,
+ *        on one core and then two. Report the times, the speedups, the
+ *        jobs each core ran and stole, and whether the outputs matched.
+ */
+void bench_jobs() {
+    if (!Jobs::start()) {
+        bench_report("jobs", "error", 1, "count");
+        return;
+    }
+
+    make_inputs();
+    const uint32_t executed[JOBS_CORES] = {Jobs::get_executed(0), Jobs::get_executed(1)};
+    const uint32_t stolen[JOBS_CORES] = {Jobs::get_stolen(0), Jobs::get_stolen(1)};
+
+    run_workload("compress", compress_pages, JOBS_BENCH_PAGES, 1);
+    run_workload("filter", filter_samples, JOBS_BENCH_SAMPLES, JOBS_BENCH_FILTER_CHUNK);
+
+    bool match = memcmp(filtered[0], filtered[1], sizeof(filtered[0])) == 0;
+    uint32_t packed_bytes = 0;
+    for (uint32_t page = 0 ; page < JOBS_BENCH_PAGES ; ++page) {
+        packed_bytes += packed_size[0][page];
+        if (packed_size[0][page] != packed_size[1][page] ||
+            memcmp(packed[0][page], packed[1][page], packed_size[0][page]) != 0) match = false;
+    }
+
+    bench_report("jobs", "compress_bytes_in", JOBS_BENCH_SAMPLES * sizeof(int16_t), "bytes");
+    bench_report("jobs", "compress_bytes_out", packed_bytes, "bytes");
+    bench_report("jobs", "core0_jobs", Jobs::get_executed(0) - executed[0], "count");
+    bench_report("jobs", "core1_jobs", Jobs::get_executed(1) - executed[1], "count");
+    bench_report("jobs", "core0_steals", Jobs::get_stolen(0) - stolen[0], "count");
+    bench_report("jobs", "core1_steals", Jobs::get_stolen(1) - stolen[1], "count");
+    bench_report("jobs", "match", match ? 1 : 0, "bool");
+}
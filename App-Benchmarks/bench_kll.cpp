@@ -0,0 +1,141 @@
+/**
+ * RP2040 FreeRTOS Template - App #5
+ * Quantile sketch benchmarks: accuracy, memory and update cost
+ *
+ * Runs on target as part of App #5. To run on the host:
+ *
+ *   g++ -std=c++20 -O2 App-Benchmarks/bench_kll.cpp -o bench_kll && ./bench_kll
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#if defined(PICO_ON_DEVICE) && PICO_ON_DEVICE
+#include "main.h"
+#else
+#include "bench.h"
+#endif
+#include "../Common/kll.h"
+
+
+/*
+ * CONSTANTS
+ */
+#define KLL_BENCH_SAMPLES           200000
+#define KLL_BENCH_PARTS             4
+// Exact counts cover 0C to 64C in Q4
+#define KLL_BENCH_RANGE             1024
+
+
+/*
+ * GLOBALS
+ */
+typedef KLL_Sketch<int16_t> Temp_Sketch;
+
+static Temp_Sketch          whole;
+static Temp_Sketch          parts[KLL_BENCH_PARTS];
+static uint32_t             exact[KLL_BENCH_RANGE];
+static uint32_t             seed = 0x2545F491;
+
+static const uint32_t       ranks[] = {5000, 9500, 9900};
+static const char*          rank_names[] = {"p50", "p95", "p99"};
+
+
+/*
+ * HELPERS
+ */
+
+/**
+ * @brief A day-like temperature trace in Q4: a slow swing between about
+ *        16C and 24C, sensor noise, and occasional hot spells for a tail.
+ */
+static int16_t next_temp(uint32_t i) {
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+
+    const uint32_t phase = i % 4000;
+    const int32_t swing = phase < 2000 ? (int32_t)phase : (int32_t)(4000 - phase);
+    int32_t raw = 256 + swing * 128 / 2000 + (int32_t)(seed & 31) - 16;
+    if ((seed >> 8) % 100 == 0) raw += 160 + (int32_t)((seed >> 16) & 63);
+    return (int16_t)raw;
+}
+
+/**
+ * @brief How far, in basis points, an estimate's true rank lies from
+ *        the requested rank. Ties span a range of ranks; inside it the
+ *        error is zero.
+ */
+static uint32_t rank_error(int16_t value, uint32_t rank) {
+    uint64_t below = 0;
+    for (int32_t v = 0 ; v < value && v < KLL_BENCH_RANGE ; ++v) below += exact[v];
+    const uint64_t upto = below + (value >= 0 && value < KLL_BENCH_RANGE ? exact[value] : 0);
+    const uint64_t low = below * KLL_RANK_ONE / KLL_BENCH_SAMPLES;
+    const uint64_t high = upto * KLL_RANK_ONE / KLL_BENCH_SAMPLES;
+    if (rank < low) return (uint32_t)(low - rank);
+    if (rank > high) return (uint32_t)(rank - high);
+    return 0;
+}
+
+static void report_accuracy(const char* name, Temp_Sketch& sketch) {
+    char metric[48];
+    for (uint32_t i = 0 ; i < sizeof(ranks) / sizeof(ranks[0]) ; ++i) {
+        const int16_t value = sketch.get_quantile(ranks[i]);
+        snprintf(metric, sizeof(metric), "%s_%s_q4", name, rank_names[i]);
+        bench_report("kll", metric, (uint32_t)value, "q4");
+        snprintf(metric, sizeof(metric), "%s_%s_error", name, rank_names[i]);
+        bench_report("kll", metric, rank_error(value, ranks[i]), "bp");
+    }
+}
+
+
+/*
+ * BENCHMARKS
+ */
+
+/**
+ * @brief Feed a long temperature trace to one sketch, and to several
+ *        sketches that are then merged. Report memory against storing
+ *        the raw history, the update and query costs, and the rank
+ *        error of p50, p95 and p99 against exact counts.
+ */
+void bench_kll() {
+    for (uint32_t i = 0 ; i < KLL_BENCH_RANGE ; ++i) exact[i] = 0;
+
+    const uint64_t start = bench_now_us();
+    for (uint32_t i = 0 ; i < KLL_BENCH_SAMPLES ; ++i) whole.update(next_temp(i));
+    bench_report_per_op("kll", "update", bench_now_us() - start, KLL_BENCH_SAMPLES);
+
+    // Replay the same trace for the exact counts and the partial sketches
+    seed = 0x2545F491;
+    for (uint32_t i = 0 ; i < KLL_BENCH_SAMPLES ; ++i) {
+        const int16_t temp = next_temp(i);
+        if (temp >= 0 && temp < KLL_BENCH_RANGE) exact[temp]++;
+        parts[i * KLL_BENCH_PARTS / KLL_BENCH_SAMPLES].update(temp);
+    }
+
+    bench_report("kll", "samples", KLL_BENCH_SAMPLES, "count");
+    bench_report("kll", "sketch_bytes", sizeof(Temp_Sketch), "bytes");
+    bench_report("kll", "history_bytes", KLL_BENCH_SAMPLES * sizeof(int16_t), "bytes");
+    bench_report("kll", "retained", whole.get_retained(), "count");
+    bench_report("kll", "levels", whole.get_level_count(), "count");
+
+    const uint64_t query_start = bench_now_us();
+    (void)whole.get_quantile(9900);
+    bench_report("kll", "query", (uint32_t)(bench_now_us() - query_start), "us");
+    report_accuracy("single", whole);
+
+    const uint64_t merge_start = bench_now_us();
+    for (uint32_t i = 1 ; i < KLL_BENCH_PARTS ; ++i) parts[0].merge(parts[i]);
+    bench_report("kll", "merge", (uint32_t)(bench_now_us() - merge_start), "us");
+    report_accuracy("merged", parts[0]);
+}
+
+
+#if !(defined(PICO_ON_DEVICE) && PICO_ON_DEVICE)
+int main() {
+    bench_kll();
+    return 0;
+}
+#endif
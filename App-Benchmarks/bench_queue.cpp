@@ -0,0 +1,175 @@
+/**
+ * RP2040 FreeRTOS Template - App #5
+ * Batched queue benchmarks: Batch_Queue versus per-item FreeRTOS queue calls
+ *
+ * Byte items, as App Three's LED task sends, are moved in batches of 1
+ * to 32, first by one task to itself, which measures the calls alone,
+ * and then to a higher-priority task, which each wake-up switches to.
+ * The FreeRTOS queue takes one call, critical section and wake-up per
+ * item; `Batch_Queue` takes one of each per batch.
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#include "main.h"
+#include "../Common/batch_queue.h"
+
+
+/*
+ * CONSTANTS
+ */
+#define QUEUE_BENCH_ITEMS           8192
+#define QUEUE_BENCH_DEPTH           64
+#define QUEUE_BENCH_MAX_BATCH       32
+#define QUEUE_BENCH_STACK_DEPTH     256
+
+
+/*
+ * GLOBALS
+ */
+static const uint32_t                           batch_sizes[] = {1, 2, 4, 8, 16, 32};
+
+static Batch_Queue<uint8_t, QUEUE_BENCH_DEPTH>  batch_queue;
+static QueueHandle_t                            item_queue = NULL;
+static TaskHandle_t                             bench_task = NULL;
+static uint8_t                                  items[QUEUE_BENCH_MAX_BATCH];
+static volatile uint32_t                        sink = 0;
+
+
+/*
+ * TASKS
+ */
+
+/**
+ * @brief Receive every item from the FreeRTOS queue, one call each.
+ */
+static void task_item_consumer(void* unused_arg) {
+    uint8_t item = 0;
+    uint32_t count = 0;
+    while (count < QUEUE_BENCH_ITEMS) {
+        if (xQueueReceive(item_queue, &item, portMAX_DELAY) == pdPASS) count++;
+    }
+
+    xTaskNotifyGive(bench_task);
+    vTaskDelete(NULL);
+}
+
+/**
+ * @brief Receive every item from the Batch_Queue, as many as are there per call.
+ */
+static void task_batch_consumer(void* unused_arg) {
+    uint8_t batch[QUEUE_BENCH_MAX_BATCH];
+    uint32_t count = 0;
+    while (count < QUEUE_BENCH_ITEMS) count += batch_queue.receive(batch, QUEUE_BENCH_MAX_BATCH, portMAX_DELAY);
+
+    xTaskNotifyGive(bench_task);
+    vTaskDelete(NULL);
+}
+
+
+/*
+ * BENCHMARKS
+ */
+
+/**
+ * @brief Emit a rate in items per second, and return it.
+ */
+static uint32_t report_rate(const char* metric, uint32_t batch, uint64_t elapsed_us) {
+    char name[32];
+    const uint32_t rate = elapsed_us > 0 ? (uint32_t)((uint64_t)QUEUE_BENCH_ITEMS * 1000000 / elapsed_us) : 0;
+    snprintf(name, sizeof(name), "%s_b%lu", metric, (unsigned long)batch);
+    bench_report("queue", name, rate, "per_s");
+    return rate;
+}
+
+static void report_speedup(const char* metric, uint32_t batch, uint32_t batched, uint32_t per_item) {
+    char name[32];
+    snprintf(name, sizeof(name), "%s_b%lu", metric, (unsigned long)batch);
+    bench_report("queue", name, per_item > 0 ? (uint32_t)((uint64_t)batched * 100 / per_item) : 0, "x100");
+}
+
+
+/**
+ * @brief One task sends each batch to itself, then receives it.
+ */
+static void run_local(uint32_t batch) {
+    uint8_t out[QUEUE_BENCH_MAX_BATCH];
+    const uint32_t rounds = QUEUE_BENCH_ITEMS / batch;
+
+    uint64_t start = bench_now_us();
+    for (uint32_t r = 0 ; r < rounds ; ++r) {
+        for (uint32_t i = 0 ; i < batch ; ++i) xQueueSendToBack(item_queue, &items[i], 0);
+        for (uint32_t i = 0 ; i < batch ; ++i) xQueueReceive(item_queue, &out[i], 0);
+        sink = out[batch - 1];
+    }
+
+    const uint32_t per_item = report_rate("local_queue", batch, bench_now_us() - start);
+
+    start = bench_now_us();
+    for (uint32_t r = 0 ; r < rounds ; ++r) {
+        batch_queue.send(items, batch);
+        batch_queue.receive(out, batch, 0);
+        sink = out[batch - 1];
+    }
+
+    const uint32_t batched = report_rate("local_batch", batch, bench_now_us() - start);
+    report_speedup("local_speedup", batch, batched, per_item);
+}
+
+
+/**
+ * @brief Send batches to a higher-priority task, which each wake-up
+ *        switches to, until it has every item.
+ */
+static void run_cross(uint32_t batch) {
+    const uint32_t rounds = QUEUE_BENCH_ITEMS / batch;
+
+    uint64_t start = bench_now_us();
+    if (xTaskCreate(task_item_consumer, "BENCH_CONSUMER", QUEUE_BENCH_STACK_DEPTH, NULL, BENCH_HIGH_PRIORITY, NULL) != pdPASS) return;
+    for (uint32_t r = 0 ; r < rounds ; ++r) {
+        for (uint32_t i = 0 ; i < batch ; ++i) xQueueSendToBack(item_queue, &items[i], portMAX_DELAY);
+    }
+
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(5000));
+    const uint32_t per_item = report_rate("cross_queue", batch, bench_now_us() - start);
+
+    start = bench_now_us();
+    if (xTaskCreate(task_batch_consumer, "BENCH_CONSUMER", QUEUE_BENCH_STACK_DEPTH, NULL, BENCH_HIGH_PRIORITY, NULL) != pdPASS) return;
+    for (uint32_t r = 0 ; r < rounds ; ++r) {
+        uint32_t sent = 0;
+        while (sent < batch) {
+            const uint32_t added = batch_queue.send(items + sent, batch - sent);
+            if (added == 0) vTaskDelay(1);
+            sent += added;
+        }
+    }
+
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(5000));
+    const uint32_t batched = report_rate("cross_batch", batch, bench_now_us() - start);
+    report_speedup("cross_speedup", batch, batched, per_item);
+
+    // Let the idle task reclaim the consumers' memory
+    vTaskDelay(pdMS_TO_TICKS(10));
+}
+
+
+/**
+ * @brief Compare item rates through a FreeRTOS queue and a Batch_Queue
+ *        at each batch size, within one task and across two.
+ */
+void bench_queue() {
+    bench_task = xTaskGetCurrentTaskHandle();
+    ulTaskNotifyTake(pdTRUE, 0);
+    item_queue = xQueueCreate(QUEUE_BENCH_DEPTH, sizeof(uint8_t));
+    if (item_queue == NULL) return;
+
+    for (uint32_t i = 0 ; i < QUEUE_BENCH_MAX_BATCH ; ++i) items[i] = (uint8_t)i;
+
+    for (uint32_t batch : batch_sizes) run_local(batch);
+    for (uint32_t batch : batch_sizes) run_cross(batch);
+
+    vQueueDelete(item_queue);
+    item_queue = NULL;
+}
@@ -0,0 +1,151 @@
+/**
+ * RP2040 FreeRTOS Template - App #5
+ * Shared-state benchmarks: Seq_Lock versus critical sections and queues
+ *
+ * A 16-byte state is published and read three ways: through a Seq_Lock,
+ * copied inside a FreeRTOS critical section, and through a one-item
+ * queue used as a mailbox (`xQueueOverwrite()` and `xQueuePeek()`).
+ * Then a job on core 1 writes the Seq_Lock while core 0 reads it, and
+ * the reads are checked for torn values.
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#include "main.h"
+#include "../Common/seqlock.h"
+#include "../Common/jobs.h"
+
+
+/*
+ * CONSTANTS
+ */
+#define SEQLOCK_BENCH_ITERATIONS    20000
+#define SEQLOCK_BENCH_CONTEND_US    200000
+
+
+/*
+ * GLOBALS
+ */
+// Every field is derived from `count`, so a torn read is detectable
+struct Bench_State {
+    uint32_t    count;
+    uint32_t    square;
+    int32_t     negative;
+    uint32_t    check;
+
+    static Bench_State make(uint32_t n) {
+        return {n, n * n, -(int32_t)n, n ^ 0xA5A5A5A5};
+    }
+
+    bool is_whole() const {
+        return square == count * count && negative == -(int32_t)count && check == (count ^ 0xA5A5A5A5);
+    }
+};
+
+static Seq_Lock<Bench_State>    shared;
+static Bench_State              guarded;
+static volatile uint32_t        sink = 0;
+static volatile uint32_t        torn = 0;
+static uint32_t                 retries = 0;
+static uint32_t                 reads = 0;
+
+
+/*
+ * JOBS
+ */
+
+/**
+ * @brief Job 0 writes the Seq_Lock and job 1 reads it, each for a set
+ *        time, so neither waits on the other whichever core it runs on.
+ */
+static void __not_in_flash_func(contend)(void* unused_context, uint32_t begin, uint32_t end) {
+    const uint64_t stop = time_us_64() + SEQLOCK_BENCH_CONTEND_US;
+    if (begin == 0) {
+        uint32_t n = 0;
+        while (time_us_64() < stop) shared.write(Bench_State::make(++n));
+        return;
+    }
+
+    uint32_t count = 0;
+    while (time_us_64() < stop) {
+        if (!shared.read(retries).is_whole()) torn = torn + 1;
+        count++;
+    }
+
+    reads = count;
+}
+
+
+/*
+ * BENCHMARKS
+ */
+
+/**
+ * @brief Time reads and writes of the shared state by each method on one
+ *        core, then read the Seq_Lock while the other core writes it.
+ */
+void bench_seqlock() {
+    // Seq_Lock
+    uint64_t start = bench_now_us();
+    for (uint32_t i = 0 ; i < SEQLOCK_BENCH_ITERATIONS ; ++i) shared.write(Bench_State::make(i));
+    bench_report_per_op("seqlock", "seqlock_write", bench_now_us() - start, SEQLOCK_BENCH_ITERATIONS);
+
+    start = bench_now_us();
+    for (uint32_t i = 0 ; i < SEQLOCK_BENCH_ITERATIONS ; ++i) sink = shared.read().count;
+    bench_report_per_op("seqlock", "seqlock_read", bench_now_us() - start, SEQLOCK_BENCH_ITERATIONS);
+
+    // Critical section: safe on core 0 only, since it doesn't stop core 1
+    start = bench_now_us();
+    for (uint32_t i = 0 ; i < SEQLOCK_BENCH_ITERATIONS ; ++i) {
+        const Bench_State next = Bench_State::make(i);
+        taskENTER_CRITICAL();
+        guarded = next;
+        taskEXIT_CRITICAL();
+    }
+
+    bench_report_per_op("seqlock", "critical_write", bench_now_us() - start, SEQLOCK_BENCH_ITERATIONS);
+
+    start = bench_now_us();
+    for (uint32_t i = 0 ; i < SEQLOCK_BENCH_ITERATIONS ; ++i) {
+        taskENTER_CRITICAL();
+        const Bench_State copy = guarded;
+        taskEXIT_CRITICAL();
+        sink = copy.count;
+    }
+
+    bench_report_per_op("seqlock", "critical_read", bench_now_us() - start, SEQLOCK_BENCH_ITERATIONS);
+
+    // Mailbox queue
+    QueueHandle_t mailbox = xQueueCreate(1, sizeof(Bench_State));
+    if (mailbox != NULL) {
+        start = bench_now_us();
+        for (uint32_t i = 0 ; i < SEQLOCK_BENCH_ITERATIONS ; ++i) {
+            const Bench_State next = Bench_State::make(i);
+            xQueueOverwrite(mailbox, &next);
+        }
+
+        bench_report_per_op("seqlock", "queue_write", bench_now_us() - start, SEQLOCK_BENCH_ITERATIONS);
+
+        start = bench_now_us();
+        for (uint32_t i = 0 ; i < SEQLOCK_BENCH_ITERATIONS ; ++i) {
+            Bench_State copy;
+            xQueuePeek(mailbox, &copy, 0);
+            sink = copy.count;
+        }
+
+        bench_report_per_op("seqlock", "queue_read", bench_now_us() - start, SEQLOCK_BENCH_ITERATIONS);
+        vQueueDelete(mailbox);
+    }
+
+    // Cross-core: reads on one core while the other writes
+    if (Jobs::start()) {
+        const uint32_t core1_jobs = Jobs::get_executed(1);
+        Jobs::parallel_for(2, 1, contend, nullptr);
+        bench_report("seqlock", "contended_cross_core", Jobs::get_executed(1) - core1_jobs, "count");
+        bench_report("seqlock", "contended_reads", reads, "count");
+        bench_report("seqlock", "contended_retries", retries, "count");
+        bench_report("seqlock", "contended_torn", torn, "count");
+    }
+}
@@ -0,0 +1,163 @@
+/**
+ * RP2040 FreeRTOS Template - App #5
+ * Timer benchmarks: hardware-alarm timers versus FreeRTOS software timers
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#include "main.h"
+#include "../Common/hr_timer.h"
+
+
+/*
+ * CONSTANTS
+ */
+#define TIMER_BENCH_SAMPLES         1000
+// The software timer can do no better than one tick
+#define TIMER_BENCH_PERIOD_US       1000
+#define TIMER_BENCH_FAST_PERIOD_US  100
+
+
+/**
+    One periodic run: lateness against each deadline, and the error
+    in each interval versus the nominal period.
+ */
+struct Jitter_Run {
+    uint32_t        period_us;
+    volatile uint32_t remaining;
+    uint64_t        last_us;
+    Bench_Stats     lateness;
+    Bench_Stats     period_error;
+};
+
+
+/*
+ * GLOBALS
+ */
+static HR_Timer         hr_timer;
+static Jitter_Run       run;
+static TaskHandle_t     bench_task = NULL;
+
+
+/*
+ * HELPERS
+ */
+static void run_reset(uint32_t period_us) {
+    run.period_us = period_us;
+    run.remaining = TIMER_BENCH_SAMPLES;
+    run.last_us = 0;
+    run.lateness = Bench_Stats();
+    run.period_error = Bench_Stats();
+}
+
+/**
+ * @brief Log one expiry.
+ *
+ * @param now_us:      When the expiry action ran.
+ * @param deadline_us: When it was due, or 0 if that isn't known.
+ */
+static void run_record(uint64_t now_us, uint64_t deadline_us) {
+    if (deadline_us > 0) run.lateness.add((uint32_t)(now_us - deadline_us));
+    if (run.last_us > 0) {
+        const uint32_t interval = (uint32_t)(now_us - run.last_us);
+        run.period_error.add(interval > run.period_us ? interval - run.period_us : run.period_us - interval);
+    }
+
+    run.last_us = now_us;
+}
+
+/**
+ * @brief HR timer callback, in the alarm ISR: record, then restart
+ *        from the previous deadline so the period doesn't drift.
+ */
+static void hr_isr_callback(HR_Timer* timer, void* context, BaseType_t* higher_priority_task_woken) {
+    run_record(time_us_64(), timer->get_deadline());
+    run.remaining = run.remaining - 1;
+    if (run.remaining > 0) {
+        timer->start_at(timer->get_deadline() + run.period_us);
+    } else {
+        vTaskNotifyGiveFromISR(bench_task, higher_priority_task_woken);
+    }
+}
+
+/**
+ * @brief FreeRTOS timer callback, in the timer daemon task.
+ */
+static void sw_timer_callback(TimerHandle_t timer) {
+    run_record(time_us_64(), 0);
+    run.remaining = run.remaining - 1;
+    if (run.remaining == 0) {
+        xTimerStop(timer, 0);
+        xTaskNotifyGive(bench_task);
+    }
+}
+
+
+/*
+ * BENCHMARKS
+ */
+
+/**
+ * @brief Measure the jitter of periodic expiries: HR timer callbacks
+ *        in the ISR, HR timer task notifications, and an auto-reload
+ *        FreeRTOS timer, all at 1ms. Then HR callbacks at 100us, which
+ *        a tick-based timer can't do.
+ */
+void bench_timer() {
+    bench_task = xTaskGetCurrentTaskHandle();
+    if (!HR_Timer::init()) {
+        bench_report("timer", "alarms_claimed", 0, "count");
+        return;
+    }
+
+    // Wake as the timer daemon does, so the two task paths compare fairly
+    const UBaseType_t priority = uxTaskPriorityGet(NULL);
+    vTaskPrioritySet(NULL, configTIMER_TASK_PRIORITY);
+
+    // HR timer, ISR callback
+    run_reset(TIMER_BENCH_PERIOD_US);
+    hr_timer.set_callback(hr_isr_callback);
+    hr_timer.start_in(TIMER_BENCH_PERIOD_US);
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    bench_report_stats("timer", "hr_isr_late", run.lateness);
+    bench_report_stats("timer", "hr_isr_period_err", run.period_error);
+
+    // HR timer, task notification
+    run_reset(TIMER_BENCH_PERIOD_US);
+    hr_timer.set_notify(bench_task);
+    uint64_t deadline = time_us_64() + TIMER_BENCH_PERIOD_US;
+    while (run.remaining > 0) {
+        hr_timer.start_at(deadline);
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        run_record(time_us_64(), deadline);
+        run.remaining = run.remaining - 1;
+        deadline += TIMER_BENCH_PERIOD_US;
+    }
+
+    bench_report_stats("timer", "hr_task_late", run.lateness);
+    bench_report_stats("timer", "hr_task_period_err", run.period_error);
+
+    // FreeRTOS software timer. Its deadlines fall on ticks, so
+    // only the interval error can be measured
+    run_reset(TIMER_BENCH_PERIOD_US);
+    TimerHandle_t sw_timer = xTimerCreate("BENCH_TIMER", pdMS_TO_TICKS(TIMER_BENCH_PERIOD_US / 1000), pdTRUE, NULL, sw_timer_callback);
+    if (sw_timer != NULL) {
+        xTimerStart(sw_timer, 0);
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        xTimerDelete(sw_timer, 0);
+        bench_report_stats("timer", "sw_period_err", run.period_error);
+    }
+
+    // HR timer, sub-millisecond
+    run_reset(TIMER_BENCH_FAST_PERIOD_US);
+    hr_timer.set_callback(hr_isr_callback);
+    hr_timer.start_in(TIMER_BENCH_FAST_PERIOD_US);
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    bench_report("timer", "hr_fast_period", TIMER_BENCH_FAST_PERIOD_US, "us");
+    bench_report_stats("timer", "hr_fast_late", run.lateness);
+    bench_report_stats("timer", "hr_fast_period_err", run.period_error);
+
+    vTaskPrioritySet(NULL, priority);
+}
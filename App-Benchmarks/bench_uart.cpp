@@ -0,0 +1,148 @@
+/**
+ * RP2040 FreeRTOS Template - App #5
+ * UART receive benchmarks: DMA ring versus an interrupt per byte
+ *
+ * UART1 runs in internal loopback, so no wiring is needed, and STDIO
+ * on UART0 is undisturbed.
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#include "main.h"
+#include "../Common/uart_dma.h"
+
+
+/*
+ * CONSTANTS
+ */
+#define UART_BENCH_PORT             uart1
+#define UART_BENCH_IRQ              UART1_IRQ
+#define UART_BENCH_TX_PIN           Board::LOOP_UART_TX_PIN
+#define UART_BENCH_RX_PIN           Board::LOOP_UART_RX_PIN
+#define UART_BENCH_FRAMES           100
+#define UART_BENCH_FRAME_GAP_MS     5
+#define UART_BENCH_SETTLE_MS        20
+
+
+/*
+ * GLOBALS
+ */
+// A new-message URC and the response to reading it
+static const char       frame[] = "+CMTI: \"SM\",12\r\n+CMGR: \"REC UNREAD\",\"+447700900123\",,\"22/06/14\"\r\n";
+
+static UART_DMA_Rx      rx;
+static volatile uint32_t byte_irqs = 0;
+static volatile uint32_t byte_count = 0;
+static uint32_t         ranges = 0;
+static uint32_t         range_bytes = 0;
+
+
+/*
+ * REFERENCE RECEIVER
+ */
+static void byte_isr() {
+    byte_irqs = byte_irqs + 1;
+    while (uart_is_readable(UART_BENCH_PORT)) {
+        (void)uart_getc(UART_BENCH_PORT);
+        byte_count = byte_count + 1;
+    }
+}
+
+
+/*
+ * HELPERS
+ */
+static void report(uint32_t baud, const char* method, const char* metric, uint32_t value, const char* unit) {
+    char name[48];
+    snprintf(name, sizeof(name), "%s_%lu_%s", method, (unsigned long)baud, metric);
+    bench_report("uart", name, value, unit);
+}
+
+static void report_rate(uint32_t baud, const char* method, uint32_t bytes, uint32_t irqs, uint64_t elapsed_us) {
+    report(baud, method, "bytes", bytes, "bytes");
+    report(baud, method, "irqs", irqs, "count");
+    report(baud, method, "irq_rate", elapsed_us > 0 ? (uint32_t)(((uint64_t)irqs * 1000000) / elapsed_us) : 0, "per_s");
+}
+
+/**
+ * @brief Send the test traffic: frames separated by idle gaps, as a
+ *        modem delivers responses and URCs.
+ *
+ * @param on_gap: Called in each gap, or `nullptr`.
+ */
+static void send_frames(void (*on_gap)()) {
+    for (uint32_t i = 0 ; i < UART_BENCH_FRAMES ; ++i) {
+        uart_write_blocking(UART_BENCH_PORT, (const uint8_t*)frame, sizeof(frame) - 1);
+        vTaskDelay(pdMS_TO_TICKS(UART_BENCH_FRAME_GAP_MS));
+        if (on_gap != nullptr) on_gap();
+    }
+
+    uart_tx_wait_blocking(UART_BENCH_PORT);
+    vTaskDelay(pdMS_TO_TICKS(UART_BENCH_SETTLE_MS));
+    if (on_gap != nullptr) on_gap();
+}
+
+static void drain_ranges() {
+    UART_Rx_Range range;
+    while (rx.receive(&range, 0)) {
+        ranges++;
+        range_bytes += range.length;
+    }
+}
+
+
+/*
+ * BENCHMARKS
+ */
+
+/**
+ * @brief Receive the same traffic with an IRQ per byte (FIFO off) and
+ *        with the DMA ring, and compare the interrupt load.
+ *
+ * @param baud: The baud rate.
+ */
+static void bench_uart_at(uint32_t baud) {
+    // An interrupt per byte
+    byte_irqs = 0;
+    byte_count = 0;
+    uart_init(UART_BENCH_PORT, baud);
+    uart_set_fifo_enabled(UART_BENCH_PORT, false);
+    hw_set_bits(&uart_get_hw(UART_BENCH_PORT)->cr, UART_UARTCR_LBE_BITS);
+    irq_set_exclusive_handler(UART_BENCH_IRQ, byte_isr);
+    irq_set_enabled(UART_BENCH_IRQ, true);
+    uart_set_irq_enables(UART_BENCH_PORT, true, false);
+
+    uint64_t start = bench_now_us();
+    send_frames(nullptr);
+    report_rate(baud, "byte_irq", byte_count, byte_irqs, bench_now_us() - start);
+
+    uart_set_irq_enables(UART_BENCH_PORT, false, false);
+    irq_set_enabled(UART_BENCH_IRQ, false);
+    irq_remove_handler(UART_BENCH_IRQ, byte_isr);
+    uart_deinit(UART_BENCH_PORT);
+
+    // The DMA ring
+    ranges = 0;
+    range_bytes = 0;
+    if (!rx.begin(UART_BENCH_PORT, baud, UART_BENCH_TX_PIN, UART_BENCH_RX_PIN)) {
+        report(baud, "dma_ring", "started", 0, "bool");
+        return;
+    }
+
+    hw_set_bits(&uart_get_hw(UART_BENCH_PORT)->cr, UART_UARTCR_LBE_BITS);
+    const uint32_t irqs_before = rx.get_irq_count();
+    start = bench_now_us();
+    send_frames(drain_ranges);
+    report_rate(baud, "dma_ring", range_bytes, rx.get_irq_count() - irqs_before, bench_now_us() - start);
+    report(baud, "dma_ring", "ranges", ranges, "count");
+    report(baud, "dma_ring", "overruns", rx.get_overruns(), "count");
+    rx.end();
+}
+
+void bench_uart() {
+    bench_report("uart", "bytes_sent", UART_BENCH_FRAMES * (sizeof(frame) - 1), "bytes");
+    bench_uart_at(115200);
+    bench_uart_at(921600);
+}
@@ -0,0 +1,126 @@
+/**
+ * RP2040 FreeRTOS Template - App #5
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#include "main.h"
+
+
+/*
+ * GLOBALS
+ */
+
+// Task handles
+TaskHandle_t handle_task_bench = NULL;
+
+
+/*
+ * LED FUNCTIONS
+ */
+
+/**
+ * @brief Configure the on-board LED.
+ */
+void setup_led() {
+    gpio_init(Board::LED_PIN);
+    gpio_set_dir(Board::LED_PIN, GPIO_OUT);
+    led_off();
+}
+
+
+/**
+ * @brief Turn the on-board LED on.
+ */
+void led_on() {
+    led_set();
+}
+
+
+/**
+ * @brief Turn the on-board LED off.
+ */
+void led_off() {
+    led_set(false);
+}
+
+
+/**
+ * @brief Set the on-board LED's state.
+ */
+void led_set(bool state) {
+    gpio_put(Board::LED_PIN, state);
+}
+
+
+/*
+ * TASKS
+ */
+
+/**
+ * @brief Run each benchmark in turn, then signal completion
+ *        by lighting the on-board LED.
+ */
+void task_bench(void* unused_arg) {
+    vTaskDelay(pdMS_TO_TICKS(BENCH_START_DELAY_MS));
+    Utils::log_device_info();
+
+    bench_coro();
+    bench_fixed();
+    bench_timer();
+    bench_uart();
+    bench_edf();
+    bench_irq();
+    bench_kll();
+    bench_jobs();
+    bench_seqlock();
+    bench_adc();
+    bench_idle();
+    bench_budget();
+    bench_queue();
+
+    printf("BENCH,done\n");
+    led_on();
+    vTaskDelete(NULL);
+}
+
+
+/*
+ * RUNTIME START
+ */
+
+int main() {
+    // Results are always reported, so enable STDIO
+    // whether or not this is a debug build
+    stdio_init_all();
+
+    // Set up the hardware
+    IRQ_Priority::apply();
+    setup_led();
+
+    // Set up the benchmark runner task
+    BaseType_t status_task_bench = xTaskCreate(task_bench, "BENCH_TASK", 512, NULL, BENCH_TASK_PRIORITY, &handle_task_bench);
+
+    // Start the FreeRTOS scheduler if the task is good
+    if (status_task_bench == pdPASS) {
+        // Start the scheduler
+        vTaskStartScheduler();
+    } else {
+        // Flash board LED 5 times
+        uint8_t count = LED_ERROR_FLASHES;
+        while (count > 0) {
+            led_on();
+            vTaskDelay(100);
+            led_off();
+            vTaskDelay(100);
+            count--;
+        }
+    }
+
+    // We should never get here, but just in case...
+    while(true) {
+        // NOP
+    };
+}
@@ -0,0 +1,88 @@
+/**
+ * RP2040 FreeRTOS Template - App #5
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#ifndef MAIN_H
+#define MAIN_H
+
+
+// FreeRTOS
+#include <FreeRTOS.h>
+#include <task.h>
+#include <queue.h>
+#include <timers.h>
+#include <semphr.h>
+// CXX
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+// Pico SDK
+#include "pico/stdlib.h"            // Includes `hardware_gpio.h`
+#include "pico/binary_info.h"
+// App
+#include "../Common/board.h"
+#include "../Common/irq_priority.h"
+#include "../Common/utils.h"
+#include "bench.h"
+
+
+/**
+ * CONSTANTS
+ */
+// Allow the USB stdio path to connect before output starts
+#define         BENCH_START_DELAY_MS        4000
+
+#define         BENCH_TASK_PRIORITY         1
+#define         BENCH_HIGH_PRIORITY         2
+
+#define         LED_ON                      1
+#define         LED_OFF                     0
+#define         LED_ERROR_FLASHES           5
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/**
+ * PROTOTYPES
+ */
+void setup_led();
+void led_on();
+void led_off();
+void led_set(bool state = true);
+
+void task_bench(void* unused_arg);
+
+void bench_coro();
+void bench_fixed();
+void bench_timer();
+void bench_uart();
+void bench_edf();
+void bench_irq();
+void bench_kll();
+void bench_jobs();
+void bench_seqlock();
+void bench_adc();
+void bench_idle();
+void bench_budget();
+void bench_queue();
+
+
+#ifdef __cplusplus
+}           // extern "C"
+#endif
+
+
+#endif      // MAIN_H
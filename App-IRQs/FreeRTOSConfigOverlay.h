@@ -0,0 +1,26 @@
+/**
+ * RP2040 FreeRTOS Template - App #3
+ * FreeRTOS configuration overlay: settings that differ from Config/FreeRTOSConfig.h
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#ifndef FREERTOS_CONFIG_OVERLAY_HEADER
+#define FREERTOS_CONFIG_OVERLAY_HEADER
+
+
+/* GPIO interrupts hand off to tasks through a semaphore and
+   notification index 0, never through the timer task, so it and
+   its 1KB stack go */
+#define configUSE_TIMERS                        0
+#define configTASK_NOTIFICATION_ARRAY_ENTRIES   1
+#define configQUEUE_REGISTRY_SIZE               0
+
+/* No thread-local storage: CPU budgets, which the app's CMakeLists.txt
+   enables, restore the slot they use, as WCET_TRACE builds do theirs */
+#define configNUM_THREAD_LOCAL_STORAGE_POINTERS 0
+
+
+#endif  // FREERTOS_CONFIG_OVERLAY_HEADER
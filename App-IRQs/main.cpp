@@ -27,9 +27,6 @@ TaskHandle_t handle_task_gpio = NULL;
 TaskHandle_t handle_task_read = NULL;
 TaskHandle_t handle_task_alrt = NULL;
 
-// Timers
-TimerHandle_t alert_timer = NULL;
-
 // Semaphores
 SemaphoreHandle_t semaphore_irq = NULL;
 
@@ -38,10 +35,41 @@ HT16K33_Segment display;
 
 // The sensor
 MCP9808 sensor;
-volatile double read_temp = 0.0;
-volatile bool sensor_good = false;
+// NOTE The sensor task is the only writer after setup. Readers always
+//      get a whole state, never one torn by a concurrent update
+Seq_Lock<Sensor_State> sensor_state;
+// The RP2040's own sensor, in place of a missing MCP9808
+RP2040_Temp on_die_sensor;
 volatile bool do_clear = false;
 
+// The sensor alert, cleared by the flags that come with each read
+MCP9808_Alert alert(sensor);
+
+// The sensor read scheduler
+Adaptive_Sampler sampler({
+    .min_interval = SENSOR_MIN_DELAY_TICKS,
+    .max_interval = SENSOR_MAX_DELAY_TICKS,
+    .fixed_interval = SENSOR_TASK_DELAY_TICKS,
+    .threshold = Fixed<4>::from_int(TEMP_UPPER_LIMIT_C),
+    .near_band = Fixed<4>::from_raw(SENSOR_NEAR_BAND_Q4),
+    .max_step = Fixed<4>::from_raw(SENSOR_MAX_STEP_Q4),
+    .noise_band = Fixed<4>::from_raw(SENSOR_NOISE_BAND_Q4)
+});
+
+// Early warning of the upper limit, ahead of the sensor's own alert
+Trend_Predictor predictor({
+    .threshold = Fixed<4>::from_int(TEMP_UPPER_LIMIT_C),
+    .horizon = pdMS_TO_TICKS(TREND_HORIZON_MS),
+    .spacing = pdMS_TO_TICKS(TREND_SPACING_MS),
+    .min_rate = Fixed<8>::from_raw(TREND_MIN_RATE_Q8)
+});
+
+// Temperature distribution over the current window, as raw Q4 values
+KLL_Sketch<int16_t> temp_sketch;
+
+// Past readings, for export over USB
+Sensor_History sensor_history;
+
 
 /*
  * LED FUNCTIONS
@@ -51,8 +79,8 @@ volatile bool do_clear = false;
  * @brief Configure the on-board LED.
  */
 void setup_led() {
-    gpio_init(PICO_DEFAULT_LED_PIN);
-    gpio_set_dir(PICO_DEFAULT_LED_PIN, GPIO_OUT);
+    gpio_init(Board::LED_PIN);
+    gpio_set_dir(Board::LED_PIN, GPIO_OUT);
     led_off();
 }
 
@@ -77,7 +105,7 @@ void led_off() {
  * @brief Set the on-board LED's state.
  */
 void led_set(bool state) {
-    gpio_put(PICO_DEFAULT_LED_PIN, state);
+    gpio_put(Board::LED_PIN, state);
 }
 
 
@@ -89,6 +117,7 @@ void led_set(bool state) {
  * @brief Umbrella hardware setup routine.
  */
 void setup() {
+    IRQ_Priority::apply();
     setup_i2c();
     setup_led();
     setup_gpio();
@@ -108,25 +137,32 @@ void setup_i2c() {
 
     // Initialise the sensor
     sensor = MCP9808();
-    sensor_good = sensor.begin();
-    if (!sensor_good) printf("[ERROR] MCP9808 not present\n");
+    const bool sensor_good = sensor.begin();
+    bool on_die = false;
+    if (!sensor_good) {
+        printf("[ERROR] MCP9808 not present\n");
+        on_die = on_die_sensor.begin();
+        if (on_die) printf("[INFO] Using the RP2040 temperature sensor\n");
+    }
+
+    sensor_state.write({.temp = Fixed<4>(), .flags = 0, .good = sensor_good || on_die, .on_die = on_die, .read_at = 0});
 }
 
 
 void setup_gpio() {
     // Configure the MCP9808 alert reader
-    gpio_init(ALERT_SENSE_PIN);
-    gpio_set_dir(ALERT_SENSE_PIN, GPIO_IN);
+    gpio_init(Board::ALERT_SENSE_PIN);
+    gpio_set_dir(Board::ALERT_SENSE_PIN, GPIO_IN);
 
     // Configure the GPIO LED
-    gpio_init(RED_LED_PIN);
-    gpio_set_dir(RED_LED_PIN, GPIO_OUT);
-    gpio_put(ALERT_LED_PIN, false);
+    gpio_init(Board::RED_LED_PIN);
+    gpio_set_dir(Board::RED_LED_PIN, GPIO_OUT);
+    gpio_put(Board::ALERT_LED_PIN, false);
 
     // Configure the GREEN LED
-    gpio_init(ALERT_LED_PIN);
-    gpio_set_dir(ALERT_LED_PIN, GPIO_OUT);
-    gpio_put(ALERT_LED_PIN, false);
+    gpio_init(Board::ALERT_LED_PIN);
+    gpio_set_dir(Board::ALERT_LED_PIN, GPIO_OUT);
+    gpio_put(Board::ALERT_LED_PIN, false);
 }
 
 
@@ -181,7 +217,7 @@ void gpio_isr(uint gpio, uint32_t events) {
  * @param state: The enablement state. Default: `true`.
  */
 void enable_irq(bool state) {
-    gpio_set_irq_enabled_with_callback(ALERT_SENSE_PIN,
+    gpio_set_irq_enabled_with_callback(Board::ALERT_SENSE_PIN,
                                        GPIO_IRQ_LEVEL_LOW,
                                        state,
                                        &gpio_isr);
@@ -203,8 +239,14 @@ void task_led_pico(void* unused_arg) {
     bool state = true;
     TickType_t then = 0;
     
-    // Enable IRQ on the sensor pin
-    if (sensor_good) enable_irq(true);
+    // Enable IRQ on the sensor pin, if the MCP9808 is fitted
+    const Sensor_State current = sensor_state.read();
+    if (current.good && !current.on_die) enable_irq(true);
+
+    // Measure the work, not the polling between flashes. The task never
+    // blocks, so declare it a background task, with no period, or
+    // Tools/rta.py would rank it as a 500ms periodic task
+    WCET::attach("PICO_LED_TASK", 0);
 
     // Start the task loop
     while (true) {
@@ -213,6 +255,7 @@ void task_led_pico(void* unused_arg) {
         TickType_t now = xTaskGetTickCount();
         if (now - then >= 500) {
             then = now;
+            WCET::begin();
 
             if (state) {
                 #ifdef DEBUG
@@ -227,11 +270,12 @@ void task_led_pico(void* unused_arg) {
                 led_off();
                 pico_led_state = LED_ON;
                 xQueueSendToBack(flip_queue, &pico_led_state, 0);
-                display_tmp(read_temp);
+                display_tmp(sensor_state.read().temp);
             }
             
             state = !state;
             if (count > 9998) count = 0;
+            WCET::end();
         }
 
         // Yield -- uncomment the next line to enable,
@@ -249,17 +293,20 @@ void task_led_gpio(void* unused_arg) {
     // This variable will take a copy of the value
     // added to the FreeRTOS xQueue
     uint8_t passed_value_buffer = LED_OFF;
+    WCET::attach("GPIO_LED_TASK", 500 * 1000);
 
     while (true) {
         // Wait for an event: check for an item in the FreeRTOS xQueue
         if (xQueueReceive(flip_queue, &passed_value_buffer, portMAX_DELAY) == pdPASS) {
+            WCET::begin();
             // Received a value so flash the GPIO LED accordingly
             // (NOT the sent value)
             #ifdef DEBUG
             if (passed_value_buffer == LED_ON) Utils::log_debug("GPIO LED FLASH");
             #endif
             
-            gpio_put(RED_LED_PIN, passed_value_buffer);
+            gpio_put(Board::RED_LED_PIN, passed_value_buffer);
+            WCET::end();
         }
         
         // Yield -- uncomment the next line to enable,
@@ -271,13 +318,110 @@ void task_led_gpio(void* unused_arg) {
 
 /**
  * @brief Repeatedly read the sensor and store the current
- *        temperature.
+ *        temperature, at a rate set by the adaptive sampler.
  */
 void task_sensor_read(void* unused_arg) {
+    #ifdef DEBUG
+    TickType_t last_report = xTaskGetTickCount();
+    TickType_t last_window = last_report;
+    #endif
+
+    // Without an MCP9808, fall back on the RP2040's own sensor
+    const Sensor_State setup = sensor_state.read();
+    const bool on_die = setup.on_die;
+    if (!setup.good) {
+        // Neither sensor started, so there is nothing to read
+        #ifdef DEBUG
+        Utils::log_debug("No temperature sensor: sensor task stopped");
+        #endif
+        vTaskDelete(NULL);
+    }
+
+    // Declare the shortest interval the sampler can choose
+    WCET::attach("SENSOR_TASK", SENSOR_MIN_DELAY_TICKS * portTICK_PERIOD_MS * 1000);
+
+    TickType_t last_history = 0;
+    bool have_history = false;
+
     while (true) {
-        // Just read the sensor and yield
-        read_temp = sensor.read_temp();
-        vTaskDelay(SENSOR_TASK_DELAY_TICKS);
+        // The on-die sensor's filter needs a few buffers to settle
+        if (on_die && !on_die_sensor.is_ready()) {
+            vTaskDelay(SENSOR_MIN_DELAY_TICKS);
+            continue;
+        }
+
+        WCET::begin();
+
+        // Read the sensor, then let the sampler decide how long
+        // to yield for, based on how the temperature is moving
+        const MCP9808_Sample sample = on_die ? MCP9808_Sample {on_die_sensor.read_temp(), 0} : sensor.read_sample();
+        const TickType_t now = xTaskGetTickCount();
+        sensor_state.write({.temp = sample.temp, .flags = sample.flags, .good = setup.good, .on_die = on_die, .read_at = now});
+        temp_sketch.update((int16_t)sample.temp.raw);
+
+        // Keep a reading in the history every SENSOR_HISTORY_PERIOD_MS
+        if (!have_history || now - last_history >= pdMS_TO_TICKS(SENSOR_HISTORY_PERIOD_MS)) {
+            sensor_history.add({.time_ms = (uint32_t)(now * portTICK_PERIOD_MS), .temp_raw = (int16_t)sample.temp.raw, .flags = sample.flags, .on_die = on_die});
+            last_history = now;
+            have_history = true;
+        }
+
+        // Warn if the trend will reach the limit within the horizon
+        const Trend_Event trend = predictor.update(sample.temp, now);
+        const TickType_t time_to_limit = predictor.get_time_to_threshold();
+        // Predictions run up to TREND_NO_PREDICTION - 1 ticks, so convert
+        // in 64 bits and hold a distant one at the gauge's maximum
+        const uint64_t limit_ms = (uint64_t)time_to_limit * portTICK_PERIOD_MS;
+        const int32_t limit_ms_gauge = limit_ms > INT32_MAX ? INT32_MAX : (int32_t)limit_ms;
+        Metrics::set(Metrics::Gauge::TREND_TIME_TO_LIMIT, time_to_limit == TREND_NO_PREDICTION ? -1 : limit_ms_gauge);
+        if (trend == Trend_Event::WARNING) {
+            Metrics::add(Metrics::Counter::TREND_WARNINGS);
+            #ifdef DEBUG
+            printf("[DEBUG] Upper limit projected in %ld ms\n", (long)limit_ms_gauge);
+            #endif
+        } else if (trend == Trend_Event::CLEARED) {
+            #ifdef DEBUG
+            Utils::log_debug("Upper limit no longer projected");
+            #endif
+        }
+
+        // Act on any alert change. The flags come with the sample,
+        // so clearing the alert costs no extra sensor reads
+        const Alert_Event event = alert.update(sample.flags);
+        if (event == Alert_Event::RAISED) {
+            #ifdef DEBUG
+            Utils::log_debug("Alert now in comparator mode");
+            #endif
+        } else if (event == Alert_Event::CLEARED) {
+            show_alert(false);
+
+            // IRQ disabled at this point, so reenable it
+            // NOTE This has to come after the sensor is re-armed,
+            //      or it will trip immediately!
+            enable_irq(true);
+        }
+
+        const TickType_t delay = sampler.next_interval(sample.temp, now);
+
+        // The once-a-minute logging below is not part of the job
+        WCET::end();
+
+        #ifdef DEBUG
+        if (now - last_report >= pdMS_TO_TICKS(SENSOR_REPORT_PERIOD_MS)) {
+            last_report = now;
+            sampler.log_report(now);
+            WCET::report();
+            CPU_Budget::report();
+            Heap_Profile::report();
+        }
+
+        if (now - last_window >= pdMS_TO_TICKS(SENSOR_WINDOW_PERIOD_MS)) {
+            last_window = now;
+            log_temp_window();
+        }
+        #endif
+
+        vTaskDelay(delay);
     }
 }
 
@@ -289,20 +433,24 @@ void task_sensor_read(void* unused_arg) {
 void task_sensor_alrt(void* unused_arg) {
     // See BLOG POST https://blog.smittytone.net/2022/03/20/fun-with-freertos-and-pi-pico-interrupts-semaphores-notifications/
     
+    // The IRQ is re-armed only by the sensor task, so alerts
+    // arrive no faster than it samples
+    WCET::attach("ALERT_TASK", SENSOR_MIN_DELAY_TICKS * portTICK_PERIOD_MS * 1000);
+
     /*  ALERT HANDLER TASK FUNCTION BODY USING DIRECT TASK NOTIFICATIONS */
     while (true) {
         // Block until a notification arrives
         ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        WCET::begin();
         
         #ifdef DEBUG
         Utils::log_debug("IRQ detected");
         #endif
 
-        // Show the IRQ was hit
-        gpio_put(ALERT_LED_PIN, true);
-
-        // Set and start a timer to clear the alert
-        set_alert_timer();
+        // Show the IRQ was hit, and hand the alert to the reader
+        show_alert(true);
+        alert.trigger();
+        WCET::end();
     }
     
     /*  ALERT HANDLER TASK FUNCTION BODY USING A SEMAPHORE */
@@ -314,11 +462,9 @@ void task_sensor_alrt(void* unused_arg) {
              Utils::log_debug("IRQ detected");
              #endif
 
-             // Show the IRQ was hit
-             gpio_put(ALERT_LED_PIN, true);
-
-             // Set and start a timer to clear the alert
-             set_alert_timer();
+             // Show the IRQ was hit, and hand the alert to the reader
+             show_alert(true);
+             alert.trigger();
          }
      }
      */
@@ -336,11 +482,9 @@ void task_sensor_alrt(void* unused_arg) {
                 Utils::log_debug("IRQ detected");
                 #endif
                 
-                // Show the IRQ was hit
-                gpio_put(ALERT_LED_PIN, true);
-                
-                // Set and start a timer to clear the alert
-                set_alert_timer();
+                // Show the IRQ was hit, and hand the alert to the reader
+                show_alert(true);
+                alert.trigger();
             }
         }
     }
@@ -349,44 +493,53 @@ void task_sensor_alrt(void* unused_arg) {
 
 
 /**
- * @brief Callback actioned when the post IRQ timer fires.
+ * @brief Set the alert LED.
  *
- * @param timer: The triggering timer.
+ * @param state: The LED state. Default: `true`.
  */
-void timer_fired_callback(TimerHandle_t timer) {
-    #ifdef DEBUG
-    Utils::log_debug("Timer fired");
-    #endif
-    
-    if (read_temp < (double)TEMP_UPPER_LIMIT_C) {
-        gpio_put(ALERT_LED_PIN, false);
-        alert_timer = NULL;
-        
-        // Reset the sensor alert
-        sensor.clear_alert(true);
-        
-        // IRQ disabled at this point, so reenable it
-        // NOTE This has to come after the previous line, or it
-        //      will trip immediately!
-        enable_irq(true);
-    } else {
-        // Start the timer again
-        set_alert_timer();
-    }
+void show_alert(bool state) {
+    gpio_put(Board::ALERT_LED_PIN, state);
+}
+
+
+/**
+ * @brief Log the window's temperature quantiles and a snapshot of the
+ *        sketch, for merging on the host with `Tools/kll_merge.py`,
+ *        then start a new window.
+ */
+void log_temp_window() {
+    char unit[2 * PICO_UNIQUE_BOARD_ID_SIZE_BYTES + 1];
+    pico_get_unique_board_id_string(unit, sizeof(unit));
+
+    char text[16];
+    printf("[DEBUG] Temperature over %lu reads: p50 ", (unsigned long)temp_sketch.get_count());
+    Fixed<4>::from_raw(temp_sketch.get_quantile(5000)).to_chars(text, sizeof(text), 2);
+    printf("%s, p95 ", text);
+    Fixed<4>::from_raw(temp_sketch.get_quantile(9500)).to_chars(text, sizeof(text), 2);
+    printf("%s, p99 ", text);
+    Fixed<4>::from_raw(temp_sketch.get_quantile(9900)).to_chars(text, sizeof(text), 2);
+    printf("%s\n", text);
+
+    temp_sketch.write_snapshot(unit);
+    temp_sketch.reset();
 }
 
 
+#ifdef DEBUG
 /**
- * @brief Set and start a timer to clear the alert.
+ * @brief Idle work: write the next part of the metrics snapshot, one
+ *        family at a time while the run's budget lasts.
+ *
+ * @retval `true` if there is more of the snapshot to write, otherwise `false`.
  */
-void set_alert_timer() {
-    alert_timer = xTimerCreate("ALERT_TIMER",
-                               pdMS_TO_TICKS(ALERT_DISPLAY_PERIOD_MS),
-                               pdFALSE,
-                               (void*)0,
-                               timer_fired_callback);
-    if (alert_timer != NULL) xTimerStart(alert_timer, SENSOR_TASK_DELAY_TICKS);
+bool idle_export_metrics(void* unused_context) {
+    while (Metrics::write_openmetrics_next()) {
+        if (!Idle_Work::has_time()) return true;
+    }
+
+    return false;
 }
+#endif
 
 
 /**
@@ -414,18 +567,17 @@ void display_int(int number) {
  *
  * @param value: The value to show.
  */
-void display_tmp(double value) {
-    // Convert the temperature value (a float) to a string value
+void display_tmp(Fixed<4> value) {
+    // Convert the temperature value to a string value
     // fixed to two decimal places
-    stringstream stream;
-    stream << std::fixed << std::setprecision(2) << value;
-    const string temp = stream.str();
+    char temp[12];
+    const uint32_t length = value.to_chars(temp, sizeof(temp), 2);
 
     // Display the temperature on the LED
     uint32_t digit = 0;
     char previous_char = 0;
     char current_char = 0;
-    for (uint32_t i = 0 ; (i < temp.length() || digit == 3) ; ++i) {
+    for (uint32_t i = 0 ; (i < length || digit == 3) ; ++i) {
         current_char = temp[i];
         if (current_char == '.' && digit > 0) {
             display.set_alpha(previous_char, digit - 1, true);
@@ -465,8 +617,36 @@ int main() {
     // Set up four tasks
     BaseType_t status_task_pico = xTaskCreate(task_led_pico, "PICO_LED_TASK",  128, NULL, 1, &handle_task_pico);
     BaseType_t status_task_gpio = xTaskCreate(task_led_gpio, "GPIO_LED_TASK",  128, NULL, 1, &handle_task_gpio);
-    BaseType_t status_task_read = xTaskCreate(task_sensor_read, "SENSOR_TASK", 128, NULL, 1, &handle_task_read);
+    BaseType_t status_task_read = xTaskCreate(task_sensor_read, "SENSOR_TASK", 256, NULL, 1, &handle_task_read);
     BaseType_t status_task_alrt = xTaskCreate(task_sensor_alrt, "ALERT_TASK",  128, NULL, 1, &handle_task_alrt);
+
+    // Keep the busy-polling LED task within its CPU budget
+    bool pico_budgeted = false;
+    if (status_task_pico == pdPASS && CPU_Budget::start(BUDGET_WINDOW_MS)) {
+        pico_budgeted = CPU_Budget::set(handle_task_pico, PICO_LED_BUDGET_US);
+    }
+
+    // Present the sensor history as a USB drive
+    #ifdef APP_USB_MSC
+    xTaskCreate(task_usb, "USB_TASK", 256, NULL, 1, NULL);
+    #endif
+
+    // Export driver metrics alongside the other debug reports. This runs
+    // as idle work, on the idle task's stack, rather than in a task of its
+    // own. The idle task only gets the CPU once PICO_LED_TASK's budget
+    // drops it to the idle priority: while it polls at priority 1 unchecked,
+    // or the build leaves out the hook, keep the exporter task
+    #ifdef DEBUG
+    #if configUSE_IDLE_HOOK == 1
+    if (pico_budgeted || status_task_pico != pdPASS) {
+        Idle_Work::add(idle_export_metrics, nullptr, METRICS_IDLE_PRIORITY, METRICS_IDLE_BUDGET_US, METRICS_EXPORT_PERIOD_MS);
+    } else {
+        Metrics::start_exporter(METRICS_EXPORT_PERIOD_MS, 1);
+    }
+    #else
+    Metrics::start_exporter(METRICS_EXPORT_PERIOD_MS, 1);
+    #endif
+    #endif
     
     // Start the FreeRTOS scheduler if any of the tasks are good
     if (status_task_pico == pdPASS || status_task_gpio == pdPASS || (status_task_read == pdPASS && status_task_alrt == pdPASS)) {
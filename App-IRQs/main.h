@@ -29,12 +29,26 @@
 // Pico SDK
 #include "pico/stdlib.h"            // Includes `hardware_gpio.h`
 #include "pico/binary_info.h"
+#include "pico/unique_id.h"
 #include "hardware/i2c.h"
 // App
+#include "../Common/board.h"
+#include "../Common/cpu_budget.h"
+#include "../Common/heap_profile.h"
 #include "../Common/i2c_utils.h"
+#include "../Common/idle_work.h"
+#include "../Common/irq_priority.h"
 #include "../Common/ht16k33.h"
 #include "../Common/mcp9808.h"
+#include "../Common/mcp9808_alert.h"
+#include "../Common/rp2040_temp.h"
+#include "../Common/adaptive_sampler.h"
+#include "../Common/kll.h"
+#include "../Common/seqlock.h"
+#include "../Common/sensor_history.h"
+#include "../Common/trend_predictor.h"
 #include "../Common/utils.h"
+#include "../Common/wcet.h"
 
 
 #ifdef __cplusplus
@@ -45,12 +59,31 @@ extern "C" {
 /**
  * CONSTANTS
  */
-#define         RED_LED_PIN                 20
-#define         ALERT_LED_PIN               26
-#define         ALERT_SENSE_PIN             16
-
 #define         SENSOR_TASK_DELAY_TICKS     20
-#define         ALERT_DISPLAY_PERIOD_MS     10000
+// Adaptive sampling bounds: temperatures in 1/16C
+#define         SENSOR_MIN_DELAY_TICKS      20
+#define         SENSOR_MAX_DELAY_TICKS      2000
+#define         SENSOR_NEAR_BAND_Q4         16
+#define         SENSOR_MAX_STEP_Q4          4
+#define         SENSOR_NOISE_BAND_Q4        1
+#define         SENSOR_REPORT_PERIOD_MS     60000
+#define         METRICS_EXPORT_PERIOD_MS    60000
+// Metrics are written as idle work, a family at a time until this is
+// spent. A histogram alone takes longer over the UART: an overrun
+#define         METRICS_IDLE_BUDGET_US      10000
+#define         METRICS_IDLE_PRIORITY       1
+// Warn when the trend projects TEMP_UPPER_LIMIT_C within the horizon
+#define         TREND_HORIZON_MS            30000
+#define         TREND_SPACING_MS            1000
+#define         TREND_MIN_RATE_Q8           1
+// Temperature quantiles are reported, and the sketch reset, per window
+#define         SENSOR_WINDOW_PERIOD_MS     3600000
+// One reading is kept in the history this often
+#define         SENSOR_HISTORY_PERIOD_MS    10000
+// PICO_LED_TASK polls without blocking: hold it to a tenth of the CPU
+// before it drops to the idle priority for the rest of each window
+#define         BUDGET_WINDOW_MS            100
+#define         PICO_LED_BUDGET_US          10000
 
 #define         LED_ON                      1
 #define         LED_OFF                     0
@@ -61,6 +94,21 @@ extern "C" {
 #define         TEMP_CRIT_LIMIT_C           50
 
 
+/**
+ * STRUCTURES
+ */
+// The sensor's latest state, shared with other tasks through a Seq_Lock.
+// `on_die` marks readings from the RP2040's own sensor, used when no
+// MCP9808 is fitted: they have no alert flags
+struct Sensor_State {
+    Fixed<4>    temp;
+    uint8_t     flags;
+    bool        good;               // A sensor, either one, is giving readings
+    bool        on_die;
+    TickType_t  read_at;
+};
+
+
 /**
  * PROTOTYPES
  */
@@ -80,12 +128,19 @@ void task_led_pico(void* unused_arg);
 void task_led_gpio(void* unused_arg);
 void task_sensor_read(void* unused_arg);
 void task_sensor_alrt(void* unused_arg);
+#ifdef APP_USB_MSC
+void task_usb(void* unused_arg);
+void usb_msc_refresh();
+#endif
 
 void display_int(int number);
-void display_tmp(double value);
+void display_tmp(Fixed<4> value);
 
-void timer_fired_callback(TimerHandle_t timer);
-void set_alert_timer();
+void show_alert(bool state = true);
+void log_temp_window();
+#ifdef DEBUG
+bool idle_export_metrics(void* unused_context);
+#endif
 
 
 #ifdef __cplusplus
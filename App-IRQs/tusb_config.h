@@ -0,0 +1,35 @@
+/**
+ * RP2040 FreeRTOS Template - App #3
+ * TinyUSB configuration for the sensor history drive
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#ifndef TUSB_CONFIG_HEADER
+#define TUSB_CONFIG_HEADER
+
+
+/* Device only, at full speed. The SDK sets CFG_TUSB_MCU */
+#define CFG_TUSB_RHPORT0_MODE       (OPT_MODE_DEVICE | OPT_MODE_FULL_SPEED)
+
+/* TinyUSB's FreeRTOS port needs mutexes, which the apps' configuration
+   leaves out, so a task polls `tud_task()` instead */
+#define CFG_TUSB_OS                 OPT_OS_NONE
+
+#define CFG_TUD_ENDPOINT0_SIZE      64
+
+/* One mass-storage interface and nothing else: STDIO is on the UART */
+#define CFG_TUD_CDC                 0
+#define CFG_TUD_MSC                 1
+#define CFG_TUD_HID                 0
+#define CFG_TUD_MIDI                0
+#define CFG_TUD_VENDOR              0
+
+/* Each read callback fills this many bytes: eight sectors, so that
+   one poll per tick keeps a full-speed bus busy */
+#define CFG_TUD_MSC_EP_BUFSIZE      4096
+
+
+#endif  // TUSB_CONFIG_HEADER
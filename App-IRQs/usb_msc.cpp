@@ -0,0 +1,214 @@
+/**
+ * RP2040 FreeRTOS Template - App #3
+ * Sensor history as a read-only USB drive
+ *
+ * Built with `-DAPP_USB_MSC=ON`. The drive holds HISTORY.CSV and
+ * HISTORY.BIN, rendered from the sensor history a sector at a time as
+ * the host reads them. The files show the history as it was when the
+ * drive was mounted. Eject and reload the drive to see newer readings.
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#include "main.h"
+#include "tusb.h"
+#include "../Common/virtual_fat.h"
+
+
+/*
+ * CONSTANTS
+ */
+// TinyUSB's example IDs, for development only: use your own in a product
+#define USB_MSC_VID                 0xCAFE
+#define USB_MSC_PID                 0x4008
+#define USB_MSC_EP_OUT              0x01
+#define USB_MSC_EP_IN               0x81
+#define USB_MSC_CONFIG_LENGTH       (TUD_CONFIG_DESC_LEN + TUD_MSC_DESC_LEN)
+#define USB_MSC_MAX_STRING          31
+// SCSI additional sense codes
+#define USB_MSC_ASC_INVALID_COMMAND 0x20
+#define USB_MSC_ASC_MEDIUM_CHANGED  0x28
+
+
+/*
+ * GLOBALS
+ */
+extern Sensor_History sensor_history;
+
+static Virtual_FAT      volume("RP2040 TEMP");
+static volatile bool    media_changed = false;
+
+static const tusb_desc_device_t device_descriptor = {
+    .bLength = sizeof(tusb_desc_device_t),
+    .bDescriptorType = TUSB_DESC_DEVICE,
+    .bcdUSB = 0x0200,
+    .bDeviceClass = 0x00,
+    .bDeviceSubClass = 0x00,
+    .bDeviceProtocol = 0x00,
+    .bMaxPacketSize0 = CFG_TUD_ENDPOINT0_SIZE,
+    .idVendor = USB_MSC_VID,
+    .idProduct = USB_MSC_PID,
+    .bcdDevice = 0x0141,
+    .iManufacturer = 1,
+    .iProduct = 2,
+    .iSerialNumber = 3,
+    .bNumConfigurations = 1
+};
+
+static const uint8_t config_descriptor[] = {
+    TUD_CONFIG_DESCRIPTOR(1, 1, 0, USB_MSC_CONFIG_LENGTH, 0x00, 100),
+    TUD_MSC_DESCRIPTOR(0, 0, USB_MSC_EP_OUT, USB_MSC_EP_IN, 64)
+};
+
+
+/*
+ * DRIVE FUNCTIONS
+ */
+
+/**
+ * @brief Fix the history's current readings and lay out the files.
+ */
+void usb_msc_refresh() {
+    sensor_history.freeze();
+    volume.clear();
+    volume.add_file("history.csv", sensor_history.get_csv_size(), Sensor_History::read_csv, &sensor_history);
+    volume.add_file("history.bin", sensor_history.get_binary_size(), Sensor_History::read_binary, &sensor_history);
+}
+
+
+/**
+ * @brief Run the USB device stack: poll it every tick.
+ */
+void task_usb(void* unused_arg) {
+    usb_msc_refresh();
+    tusb_init();
+
+    while (true) {
+        tud_task();
+        vTaskDelay(1);
+    }
+}
+
+
+/*
+ * TINYUSB CALLBACKS
+ *
+ * All are called from `tud_task()`, so in the USB task.
+ */
+
+void tud_mount_cb() {
+    usb_msc_refresh();
+}
+
+
+const uint8_t* tud_descriptor_device_cb() {
+    return (const uint8_t*)&device_descriptor;
+}
+
+
+const uint8_t* tud_descriptor_configuration_cb(uint8_t unused_index) {
+    return config_descriptor;
+}
+
+
+const uint16_t* tud_descriptor_string_cb(uint8_t index, uint16_t unused_langid) {
+    static uint16_t descriptor[USB_MSC_MAX_STRING + 1];
+    static char serial[2 * PICO_UNIQUE_BOARD_ID_SIZE_BYTES + 1];
+
+    uint32_t length = 1;
+    if (index == 0) {
+        // Supported language: English
+        descriptor[1] = 0x0409;
+    } else {
+        const char* text = nullptr;
+        switch (index) {
+            case 1:
+                text = "Raspberry Pi";
+                break;
+            case 2:
+                text = "RP2040 Sensor History";
+                break;
+            case 3:
+                pico_get_unique_board_id_string(serial, sizeof(serial));
+                text = serial;
+                break;
+            default:
+                return nullptr;
+        }
+
+        for (length = 0 ; length < USB_MSC_MAX_STRING && text[length] != 0 ; ++length) descriptor[1 + length] = text[length];
+    }
+
+    // Type, then the total length in bytes
+    descriptor[0] = (uint16_t)((TUSB_DESC_STRING << 8) | (2 * length + 2));
+    return descriptor;
+}
+
+
+void tud_msc_inquiry_cb(uint8_t unused_lun, uint8_t vendor_id[8], uint8_t product_id[16], uint8_t product_rev[4]) {
+    memcpy(vendor_id, "RP2040  ", 8);
+    memcpy(product_id, "Sensor History  ", 16);
+    memcpy(product_rev, "1.4 ", 4);
+}
+
+
+/**
+ * @brief Report a new medium once after an eject, so that the host
+ *        re-reads the directory and sees the newer readings.
+ */
+bool tud_msc_test_unit_ready_cb(uint8_t lun) {
+    if (media_changed) {
+        media_changed = false;
+        usb_msc_refresh();
+        tud_msc_set_sense(lun, SCSI_SENSE_UNIT_ATTENTION, USB_MSC_ASC_MEDIUM_CHANGED, 0x00);
+        return false;
+    }
+
+    return true;
+}
+
+
+void tud_msc_capacity_cb(uint8_t unused_lun, uint32_t* block_count, uint16_t* block_size) {
+    *block_count = volume.get_sector_count();
+    *block_size = VFAT_SECTOR_SIZE;
+}
+
+
+bool tud_msc_start_stop_cb(uint8_t unused_lun, uint8_t unused_power_condition, bool start, bool load_eject) {
+    if (load_eject && !start) media_changed = true;
+    return true;
+}
+
+
+/**
+ * @brief Build the sectors the host asked for, straight into TinyUSB's
+ *        endpoint buffer.
+ */
+int32_t tud_msc_read10_cb(uint8_t unused_lun, uint32_t lba, uint32_t offset, void* buffer, uint32_t bufsize) {
+    uint8_t* to = (uint8_t*)buffer;
+    uint32_t done = 0;
+
+    // TinyUSB asks for whole sectors, as its buffer is a multiple of them
+    if (offset != 0) return -1;
+    for ( ; done + VFAT_SECTOR_SIZE <= bufsize ; done += VFAT_SECTOR_SIZE) volume.read_sector(lba++, to + done);
+    return (int32_t)done;
+}
+
+
+bool tud_msc_is_writable_cb(uint8_t unused_lun) {
+    return false;
+}
+
+
+int32_t tud_msc_write10_cb(uint8_t unused_lun, uint32_t unused_lba, uint32_t unused_offset, uint8_t* unused_buffer, uint32_t unused_bufsize) {
+    return -1;
+}
+
+
+int32_t tud_msc_scsi_cb(uint8_t lun, const uint8_t scsi_cmd[16], void* unused_buffer, uint16_t unused_bufsize) {
+    // TinyUSB handles the commands a read-only drive needs
+    tud_msc_set_sense(lun, SCSI_SENSE_ILLEGAL_REQUEST, USB_MSC_ASC_INVALID_COMMAND, 0x00);
+    return -1;
+}
@@ -30,7 +30,9 @@ HT16K33_Segment display;
 
 // The sensor
 MCP9808 sensor;
-volatile double read_temp = 0.0;
+// NOTE A 32-bit fixed-point value is written in a single store,
+//      so readers never see a partly updated temperature
+Fixed<4> read_temp;
 
 
 /*
@@ -41,8 +43,8 @@ volatile double read_temp = 0.0;
  * @brief Configure the on-board LED.
  */
 void setup_led() {
-    gpio_init(PICO_DEFAULT_LED_PIN);
-    gpio_set_dir(PICO_DEFAULT_LED_PIN, GPIO_OUT);
+    gpio_init(Board::LED_PIN);
+    gpio_set_dir(Board::LED_PIN, GPIO_OUT);
     led_off();
 }
 
@@ -67,7 +69,7 @@ void led_off() {
  * @brief Set the on-board LED's state.
  */
 void led_set(bool state) {
-    gpio_put(PICO_DEFAULT_LED_PIN, state);
+    gpio_put(Board::LED_PIN, state);
 }
 
 
@@ -168,8 +170,8 @@ void led_task_gpio(void* unused_arg) {
     uint8_t passed_value_buffer = 0;
     
     // Configure the GPIO LED
-    gpio_init(RED_LED_PIN);
-    gpio_set_dir(RED_LED_PIN, GPIO_OUT);
+    gpio_init(Board::RED_LED_PIN);
+    gpio_set_dir(Board::RED_LED_PIN, GPIO_OUT);
     
     while (true) {
         // Check for an item in the FreeRTOS xQueue
@@ -177,7 +179,7 @@ void led_task_gpio(void* unused_arg) {
             // Received a value so flash the GPIO LED accordingly
             // (NOT the sent value)
             if (passed_value_buffer) Utils::log_debug("GPIO LED FLASH");
-            gpio_put(RED_LED_PIN, passed_value_buffer == 1 ? 0 : 1);
+            gpio_put(Board::RED_LED_PIN, passed_value_buffer == 1 ? 0 : 1);
         }
         
         // Yield -- uncomment the next line to enable,
@@ -190,7 +192,7 @@ void led_task_gpio(void* unused_arg) {
 void sensor_read_task(void* unused_arg) {
     while (true) {
         // Just read the sensor and yield
-        read_temp = sensor.read_temp();
+        read_temp = sensor.read_temp_fixed();
         vTaskDelay(20);
     }
 }
@@ -221,18 +223,17 @@ void display_int(int number) {
  *
  * @param value: The value to show.
  */
-void display_tmp(double value) {
-    // Convert the temperature value (a float) to a string value
+void display_tmp(Fixed<4> value) {
+    // Convert the temperature value to a string value
     // fixed to two decimal places
-    stringstream stream;
-    stream << std::fixed << std::setprecision(2) << value;
-    const string temp = stream.str();
+    char temp[12];
+    const uint32_t length = value.to_chars(temp, sizeof(temp), 2);
 
     // Display the temperature on the LED
     uint32_t digit = 0;
     char previous_char = 0;
     char current_char = 0;
-    for (uint32_t i = 0 ; (i < temp.length() || digit == 3) ; ++i) {
+    for (uint32_t i = 0 ; (i < length || digit == 3) ; ++i) {
         current_char = temp[i];
         if (current_char == '.' && digit > 0) {
             display.set_alpha(previous_char, digit - 1, true);
@@ -29,6 +29,7 @@
 #include "pico/binary_info.h"
 #include "hardware/i2c.h"
 // App
+#include "../Common/board.h"
 #include "../Common/i2c_utils.h"
 #include "../Common/ht16k33.h"
 #include "../Common/mcp9808.h"
@@ -40,12 +41,6 @@ extern "C" {
 #endif
 
 
-/**
- * CONSTANTS
- */
-#define         RED_LED_PIN           20
-
-
 /**
  * PROTOTYPES
  */
@@ -62,7 +57,7 @@ void led_task_gpio(void* unused_arg);
 void sensor_read_task(void* unused_arg);
 
 void display_int(int number);
-void display_tmp(double value);
+void display_tmp(Fixed<4> value);
 
 
 #ifdef __cplusplus
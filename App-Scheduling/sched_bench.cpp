@@ -0,0 +1,252 @@
+/**
+ * RP2040 FreeRTOS Template - App #2
+ * Scheduler benchmark: context-switch cost, time-slice fairness and
+ * starvation under the build's preemption and time-slicing settings
+ *
+ * Built once per combination, as SCHEDULING_DEMO_BENCH_P<p>_T<t>.
+ * Results are written to STDIO as `BENCH,sched,<metric>,<value>,<unit>`.
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+// FreeRTOS
+#include <FreeRTOS.h>
+#include <task.h>
+// CXX
+#include <cstdlib>
+#include <cstdint>
+// Pico SDK
+#include "pico/stdlib.h"
+#include "hardware/clocks.h"
+// App
+#include "../App-Benchmarks/bench.h"
+
+
+/*
+ * CONSTANTS
+ */
+#define SCHED_BENCH_START_DELAY_MS      4000
+#define SCHED_BENCH_TASKS               4
+#define SCHED_BENCH_STACK_DEPTH         256
+#define SCHED_BENCH_WINDOW_US           2000000
+#define SCHED_BENCH_SWITCHES            10000
+// Everything runs below the coordinator, so it always regains the CPU
+#define SCHED_BENCH_LOW_PRIORITY        1
+#define SCHED_BENCH_HIGH_PRIORITY       2
+#define SCHED_BENCH_COORD_PRIORITY      (configMAX_PRIORITIES - 1)
+// The mixed-priority load's high task: spin, then sleep a tick
+#define SCHED_BENCH_HIGH_SPIN_US        500
+
+
+/*
+ * ENUMERATIONS
+ */
+enum class Yield : uint8_t {
+    NONE,           // Busy loop: rely on the scheduler
+    YIELD,          // taskYIELD() each iteration
+    DELAY_ZERO      // vTaskDelay(0) each iteration
+};
+
+
+/**
+    One busy task's record for a run.
+ */
+struct Busy_Task {
+    TaskHandle_t        handle;
+    Yield               yield;
+    bool                periodic;
+    volatile uint32_t   iterations;
+    volatile uint32_t   max_gap_us;
+};
+
+
+/*
+ * GLOBALS
+ */
+static TaskHandle_t     coordinator = NULL;
+static Busy_Task        busy[SCHED_BENCH_TASKS];
+static volatile uint64_t window_start_us = 0;
+static volatile uint32_t switch_count = 0;
+
+
+/*
+ * TASKS
+ */
+
+/**
+ * @brief Count loop iterations until the window closes, tracking the
+ *        longest time between iterations: time spent not running.
+ *        Waiting for the first run counts as a gap. For the periodic
+ *        task, the gap includes its one-tick sleep.
+ */
+static void task_busy(void* arg) {
+    Busy_Task* record = (Busy_Task*)arg;
+    uint64_t last = window_start_us;
+    uint64_t spin_until = 0;
+
+    while (true) {
+        const uint64_t now = time_us_64();
+        if (now - window_start_us >= SCHED_BENCH_WINDOW_US) break;
+
+        const uint32_t gap = (uint32_t)(now - last);
+        if (gap > record->max_gap_us) record->max_gap_us = gap;
+        last = now;
+        record->iterations = record->iterations + 1;
+
+        if (record->periodic) {
+            // Periodic high-priority load: a burst of work every tick
+            if (spin_until == 0) spin_until = now + SCHED_BENCH_HIGH_SPIN_US;
+            if (now >= spin_until) {
+                spin_until = 0;
+                vTaskDelay(1);
+            }
+        } else if (record->yield == Yield::YIELD) {
+            taskYIELD();
+        } else if (record->yield == Yield::DELAY_ZERO) {
+            vTaskDelay(0);
+        }
+    }
+
+    // The time from the last iteration to the window's close, which
+    // is the whole window for a task that never ran
+    const uint32_t gap = (uint32_t)(window_start_us + SCHED_BENCH_WINDOW_US - last);
+    if (gap > record->max_gap_us) record->max_gap_us = gap;
+
+    xTaskNotifyGive(coordinator);
+    vTaskSuspend(NULL);
+}
+
+/**
+ * @brief Yield back and forth with a task of the same priority.
+ */
+static void task_switch(void* arg) {
+    while (switch_count < SCHED_BENCH_SWITCHES) {
+        switch_count = switch_count + 1;
+        taskYIELD();
+    }
+
+    xTaskNotifyGive(coordinator);
+    vTaskSuspend(NULL);
+}
+
+
+/*
+ * HELPERS
+ */
+static void report(const char* scenario, const char* metric, uint32_t value, const char* unit) {
+    char name[48];
+    snprintf(name, sizeof(name), "%s_%s", scenario, metric);
+    bench_report("sched", name, value, unit);
+}
+
+static void wait_for(uint32_t count) {
+    for (uint32_t i = 0 ; i < count ; ++i) ulTaskNotifyTake(pdFALSE, portMAX_DELAY);
+}
+
+/**
+ * @brief Run the busy tasks for one window and report throughput,
+ *        CPU share fairness and starvation.
+ *
+ * @param scenario: The name for the results.
+ * @param yield:    What the low-priority tasks do each iteration.
+ * @param mixed:    `true` to make the last task a periodic high-priority load.
+ */
+static void run_busy(const char* scenario, Yield yield, bool mixed) {
+    const uint32_t lows = mixed ? SCHED_BENCH_TASKS - 1 : SCHED_BENCH_TASKS;
+    window_start_us = time_us_64();
+    for (uint32_t i = 0 ; i < SCHED_BENCH_TASKS ; ++i) {
+        const bool high = mixed && i == SCHED_BENCH_TASKS - 1;
+        busy[i] = {NULL, yield, high, 0, 0};
+        xTaskCreate(task_busy, "BENCH_BUSY", SCHED_BENCH_STACK_DEPTH, &busy[i],
+                    high ? SCHED_BENCH_HIGH_PRIORITY : SCHED_BENCH_LOW_PRIORITY, &busy[i].handle);
+    }
+
+    wait_for(SCHED_BENCH_TASKS);
+
+    // Fairness across the equal-priority tasks: Jain's index,
+    // (sum x)^2 / (n * sum x^2), scaled by 1000
+    uint64_t sum = 0;
+    uint64_t sum_squares = 0;
+    uint32_t least = UINT32_MAX;
+    uint32_t starved = 0;
+    for (uint32_t i = 0 ; i < lows ; ++i) {
+        const uint64_t x = busy[i].iterations;
+        sum += x;
+        sum_squares += x * x;
+        if (x < least) least = (uint32_t)x;
+        if (busy[i].max_gap_us > starved) starved = busy[i].max_gap_us;
+    }
+
+    report(scenario, "iterations", (uint32_t)sum, "count");
+    report(scenario, "jain_index", sum_squares > 0 ? (uint32_t)((sum * sum * 1000) / (lows * sum_squares)) : 0, "milli");
+    report(scenario, "min_share", sum > 0 ? (uint32_t)((least * 1000ULL) / sum) : 0, "milli");
+    report(scenario, "starvation_max", starved, "us");
+    if (mixed) report(scenario, "high_gap_max", busy[SCHED_BENCH_TASKS - 1].max_gap_us, "us");
+
+    for (uint32_t i = 0 ; i < SCHED_BENCH_TASKS ; ++i) vTaskDelete(busy[i].handle);
+
+    // Let the idle task reclaim the deleted tasks' memory
+    vTaskDelay(pdMS_TO_TICKS(10));
+}
+
+
+/*
+ * BENCHMARKS
+ */
+
+/**
+ * @brief Run every scenario under this build's scheduler settings.
+ */
+static void task_coordinator(void* unused_arg) {
+    vTaskDelay(pdMS_TO_TICKS(SCHED_BENCH_START_DELAY_MS));
+    bench_report("sched", "preemption", configUSE_PREEMPTION, "bool");
+    bench_report("sched", "time_slicing", configUSE_TIME_SLICING, "bool");
+
+    // Context switch cost: two equal-priority tasks yielding to each other
+    TaskHandle_t switchers[2] = {NULL, NULL};
+    switch_count = 0;
+    const uint64_t start = time_us_64();
+    xTaskCreate(task_switch, "BENCH_SWITCH", SCHED_BENCH_STACK_DEPTH, NULL, SCHED_BENCH_LOW_PRIORITY, &switchers[0]);
+    xTaskCreate(task_switch, "BENCH_SWITCH", SCHED_BENCH_STACK_DEPTH, NULL, SCHED_BENCH_LOW_PRIORITY, &switchers[1]);
+    wait_for(2);
+    const uint64_t elapsed = time_us_64() - start;
+    vTaskDelete(switchers[0]);
+    vTaskDelete(switchers[1]);
+
+    const uint64_t cycles = (elapsed * (clock_get_hz(clk_sys) / 1000000));
+    bench_report("sched", "switch_cycles", (uint32_t)(cycles / SCHED_BENCH_SWITCHES), "cycles");
+    bench_report_per_op("sched", "switch_time", elapsed, SCHED_BENCH_SWITCHES);
+    vTaskDelay(pdMS_TO_TICKS(10));
+
+    // Equal priorities, each yield strategy
+    run_busy("equal_none", Yield::NONE, false);
+    run_busy("equal_yield", Yield::YIELD, false);
+    run_busy("equal_delay0", Yield::DELAY_ZERO, false);
+
+    // Equal priorities plus a periodic higher-priority load
+    run_busy("mixed_none", Yield::NONE, true);
+    run_busy("mixed_yield", Yield::YIELD, true);
+
+    printf("BENCH,done\n");
+    vTaskDelete(NULL);
+}
+
+
+/*
+ * RUNTIME START
+ */
+
+int main() {
+    // Results are always reported, so enable STDIO
+    stdio_init_all();
+
+    BaseType_t status = xTaskCreate(task_coordinator, "BENCH_COORD", 512, NULL, SCHED_BENCH_COORD_PRIORITY, &coordinator);
+    if (status == pdPASS) vTaskStartScheduler();
+
+    // We should never get here, but just in case...
+    while(true) {
+        // NOP
+    };
+}
@@ -0,0 +1,21 @@
+/**
+ * RP2040 FreeRTOS Template - App #4
+ * FreeRTOS configuration overlay: settings that differ from Config/FreeRTOSConfig.h
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#ifndef FREERTOS_CONFIG_OVERLAY_HEADER
+#define FREERTOS_CONFIG_OVERLAY_HEADER
+
+
+/* Timer callbacks create and start more timers, so the timer
+   task keeps the shared queue depth. Nothing else is needed */
+#define configTASK_NOTIFICATION_ARRAY_ENTRIES   1
+#define configNUM_THREAD_LOCAL_STORAGE_POINTERS 0
+#define configQUEUE_REGISTRY_SIZE               0
+
+
+#endif  // FREERTOS_CONFIG_OVERLAY_HEADER
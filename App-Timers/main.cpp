@@ -31,8 +31,8 @@ volatile TimerHandle_t led_on_timer;
  * @brief Configure the on-board LED.
  */
 void setup_led() {
-    gpio_init(PICO_DEFAULT_LED_PIN);
-    gpio_set_dir(PICO_DEFAULT_LED_PIN, GPIO_OUT);
+    gpio_init(Board::LED_PIN);
+    gpio_set_dir(Board::LED_PIN, GPIO_OUT);
     led_off();
 }
 
@@ -57,7 +57,7 @@ void led_off() {
  * @brief Set the on-board LED's state.
  */
 void led_set(bool state) {
-    gpio_put(PICO_DEFAULT_LED_PIN, state);
+    gpio_put(Board::LED_PIN, state);
 }
 
 
@@ -29,6 +29,7 @@
 #include "pico/stdlib.h"            // Includes `hardware_gpio.h`
 #include "pico/binary_info.h"
 // App
+#include "../Common/board.h"
 #include "../Common/utils.h"
 
 
@@ -0,0 +1,125 @@
+/**
+ * RP2040 FreeRTOS Template - App #3
+ * Adaptive sensor sampling interval
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#include "adaptive_sampler.h"
+
+
+/**
+ * @brief Constructor: instantiate a new Adaptive_Sampler.
+ *
+ * @param config: The interval bounds and thresholds.
+ */
+Adaptive_Sampler::Adaptive_Sampler(const Sampler_Config& config) : config(config) {
+    interval = config.min_interval;
+    last_time = 0;
+    first_time = 0;
+    above = false;
+    samples = 0;
+    last_detection = 0;
+    max_detection = 0;
+}
+
+
+/**
+ * @brief Record a sample and choose the delay until the next one.
+ *
+ * @param temp: The latest reading.
+ * @param now:  The tick count at which it was taken.
+ *
+ * @retval The number of ticks to wait before the next reading.
+ */
+TickType_t Adaptive_Sampler::next_interval(Fixed<4> temp, TickType_t now) {
+    const bool is_above = temp >= config.threshold;
+
+    if (samples == 0) {
+        first_time = now;
+    } else {
+        const TickType_t elapsed = now - last_time;
+
+        // The threshold was crossed at some point since the last sample
+        if (is_above && !above) {
+            last_detection = elapsed;
+            if (elapsed > max_detection) max_detection = elapsed;
+        }
+
+        // Estimate the rate of change, ignoring sensor LSB flicker.
+        // Rises are taken at once, falls are smoothed
+        if (elapsed > 0) {
+            Fixed<4> delta = temp - last_temp;
+            if (delta < Fixed<4>()) delta = -delta;
+            delta = delta > config.noise_band ? delta - config.noise_band : Fixed<4>();
+            int32_t unused = 0;
+            const Fixed<8> instant = Fixed<8>::from_raw(FixedMath::divmod_s32(delta.convert<8>().raw * (int32_t)configTICK_RATE_HZ, (int32_t)elapsed, &unused));
+            rate = instant > rate ? instant : rate + (instant - rate) / 4;
+        }
+    }
+
+    samples++;
+    above = is_above;
+    last_temp = temp;
+    last_time = now;
+
+    // Sample fastest near the threshold. Elsewhere, allow the signal
+    // to move by at most `max_step`, or half the remaining distance
+    Fixed<4> distance = config.threshold - temp;
+    if (distance < Fixed<4>()) distance = -distance;
+
+    TickType_t target = config.max_interval;
+    if (distance <= config.near_band) {
+        target = config.min_interval;
+    } else if (rate.raw > 0) {
+        const Fixed<4> half = distance / 2;
+        const Fixed<4> allowed = half < config.max_step ? half : config.max_step;
+        uint32_t unused = 0;
+        target = FixedMath::divmod_u32((uint32_t)allowed.convert<8>().raw * configTICK_RATE_HZ, (uint32_t)rate.raw, &unused);
+    }
+
+    // Lengthen gradually, shorten immediately
+    if (target > interval * 2) target = interval * 2;
+    if (target < config.min_interval) target = config.min_interval;
+    if (target > config.max_interval) target = config.max_interval;
+    interval = target;
+    return interval;
+}
+
+
+/**
+ * @brief Compare the sampling so far with the fixed rate it replaces.
+ *
+ * @param now: The current tick count.
+ *
+ * @retval The report.
+ */
+Sampler_Report Adaptive_Sampler::get_report(TickType_t now) const {
+    Sampler_Report report;
+    uint32_t unused = 0;
+    report.samples = samples;
+    report.fixed_rate_samples = samples > 0 ? FixedMath::divmod_u32(now - first_time, config.fixed_interval, &unused) + 1 : 0;
+    report.transactions_saved = report.fixed_rate_samples > samples ? (report.fixed_rate_samples - samples) * SAMPLER_BUS_TRANSACTIONS_PER_READ : 0;
+    report.current_interval = interval;
+    report.last_detection_ticks = last_detection;
+    report.max_detection_ticks = max_detection;
+    return report;
+}
+
+
+/**
+ * @brief Print the report, eg. periodically in debug builds.
+ *
+ * @param now: The current tick count.
+ */
+void Adaptive_Sampler::log_report(TickType_t now) const {
+    const Sampler_Report report = get_report(now);
+    printf("[DEBUG] Sampler: %lu reads vs %lu at fixed rate, %lu bus transactions saved, interval %lu ticks\n",
+           (unsigned long)report.samples, (unsigned long)report.fixed_rate_samples,
+           (unsigned long)report.transactions_saved, (unsigned long)report.current_interval);
+    printf("[DEBUG] Sampler: alert detection latency last %lu, max %lu ticks (fixed rate: %lu)\n",
+           (unsigned long)report.last_detection_ticks, (unsigned long)report.max_detection_ticks,
+           (unsigned long)config.fixed_interval);
+}
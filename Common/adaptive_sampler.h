@@ -0,0 +1,92 @@
+/**
+ * RP2040 FreeRTOS Template - App #3
+ * Adaptive sensor sampling interval
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#ifndef ADAPTIVE_SAMPLER_HEADER
+#define ADAPTIVE_SAMPLER_HEADER
+
+
+#include <cstdlib>
+#include <cstdint>
+// FreeRTOS
+#include <FreeRTOS.h>
+#include <task.h>
+// Pico SDK
+#include "pico/stdlib.h"
+// App
+#include "fixed.h"
+
+
+/*
+ * CONSTANTS
+ */
+// Transactions per sensor read: register pointer write, then data read
+#define SAMPLER_BUS_TRANSACTIONS_PER_READ   2
+
+
+/**
+    Tuning for Adaptive_Sampler. Temperatures are in Celsius,
+    intervals in ticks.
+ */
+struct Sampler_Config {
+    TickType_t  min_interval;       // Fastest rate, used near the threshold
+    TickType_t  max_interval;       // Slowest rate, used when the signal is flat
+    TickType_t  fixed_interval;     // The fixed rate being replaced, for the report
+    Fixed<4>    threshold;          // The alert threshold to watch
+    Fixed<4>    near_band;          // Sample at the fastest rate this close to it
+    Fixed<4>    max_step;           // Largest change to allow between samples
+    Fixed<4>    noise_band;         // Changes this small are treated as noise
+};
+
+
+/**
+    Sampling statistics: bus use versus the fixed rate, and the worst
+    case time between the threshold being crossed and a sample seeing it.
+ */
+struct Sampler_Report {
+    uint32_t    samples;
+    uint32_t    fixed_rate_samples;
+    uint32_t    transactions_saved;
+    TickType_t  current_interval;
+    TickType_t  last_detection_ticks;
+    TickType_t  max_detection_ticks;
+};
+
+
+/**
+    Picks the delay before the next sensor read from the signal's rate of
+    change and its distance from the alert threshold. The interval stretches
+    by at most 2x per sample when the signal is stable, and shrinks at once
+    when it moves.
+ */
+class Adaptive_Sampler {
+
+    public:
+        Adaptive_Sampler(const Sampler_Config& config);
+
+        TickType_t      next_interval(Fixed<4> temp, TickType_t now);
+        Sampler_Report  get_report(TickType_t now) const;
+        void            log_report(TickType_t now) const;
+
+    private:
+        Sampler_Config  config;
+
+        Fixed<4>        last_temp;
+        TickType_t      last_time;
+        TickType_t      first_time;
+        TickType_t      interval;
+        Fixed<8>        rate;               // Smoothed |dT/dt|, C per second
+        bool            above;
+
+        uint32_t        samples;
+        TickType_t      last_detection;
+        TickType_t      max_detection;
+};
+
+
+#endif  // ADAPTIVE_SAMPLER_HEADER
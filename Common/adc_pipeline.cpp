@@ -0,0 +1,396 @@
+/**
+ * RP2040 FreeRTOS Template - App #5
+ * High-rate multi-channel ADC acquisition with CIC decimation
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#include "adc_pipeline.h"
+
+
+/*
+ * GLOBALS
+ */
+// The running pipeline, for the DMA IRQ handler
+static ADC_Pipeline* active = nullptr;
+
+
+/*
+ * CIC DECIMATOR
+ */
+
+/**
+ * @brief Constructor: instantiate a decimator with no inputs.
+ */
+CIC_Decimator::CIC_Decimator() {
+    input_count = 0;
+    rate_bits = ADC_CIC_MIN_RATE_BITS;
+    reset();
+}
+
+
+/**
+ * @brief Select the inputs and the decimation rate, and reset the filters.
+ *
+ * @param inputs:    Bit n selects ADC input n.
+ * @param rate_bits: Decimate by 2^rate_bits, from ADC_CIC_MIN_RATE_BITS
+ *                   to ADC_CIC_MAX_RATE_BITS.
+ *
+ * @retval `true` if the settings are valid, otherwise `false`.
+ */
+bool CIC_Decimator::configure(uint8_t inputs, uint32_t rate_bits) {
+    if (inputs == 0 || inputs >= (1 << ADC_PIPELINE_MAX_INPUTS)) return false;
+    if (rate_bits < ADC_CIC_MIN_RATE_BITS || rate_bits > ADC_CIC_MAX_RATE_BITS) return false;
+
+    // Round robin visits the inputs in ascending order
+    input_count = 0;
+    for (uint32_t i = 0 ; i < ADC_PIPELINE_MAX_INPUTS ; ++i) {
+        if (inputs & (1 << i)) order[input_count++] = (uint8_t)i;
+    }
+
+    this->rate_bits = rate_bits;
+    reset();
+    return true;
+}
+
+
+/**
+ * @brief Clear the filters. The first ADC_CIC_ORDER frames after a reset
+ *        ramp up from zero.
+ */
+void CIC_Decimator::reset() {
+    phase = 0;
+    rounds = 0;
+    frames = 0;
+    memset(integrators, 0, sizeof(integrators));
+    memset(delays, 0, sizeof(delays));
+}
+
+
+/**
+ * @brief Filter a run of round-robin samples, and pass on each frame as
+ *        it completes. Runs can split a round anywhere.
+ *
+ * @param samples: The ADC results: bits 0-11 are used.
+ * @param count:   The number of samples.
+ * @param sink:    Called with each frame.
+ * @param context: Passed to `sink`.
+ *
+ * @retval The number of frames passed on.
+ */
+uint32_t __not_in_flash_func(CIC_Decimator::process)(const uint16_t* samples, uint32_t count, ADC_Frame_Sink sink, void* context) {
+    const uint32_t round_count = 1 << rate_bits;
+    const uint32_t shift = ADC_CIC_ORDER * rate_bits - ADC_FRAME_FRACTION_BITS;
+    uint32_t emitted = 0;
+
+    for (uint32_t i = 0 ; i < count ; ++i) {
+        // Integrate at the input rate
+        uint32_t value = samples[i] & 0x0FFF;
+        uint32_t* stage = integrators[order[phase]];
+        for (uint32_t s = 0 ; s < ADC_CIC_ORDER ; ++s) {
+            stage[s] += value;
+            value = stage[s];
+        }
+
+        if (++phase < input_count) continue;
+        phase = 0;
+        if (++rounds < round_count) continue;
+        rounds = 0;
+
+        // Comb at the output rate
+        ADC_Frame frame = {};
+        frame.index = frames++;
+        for (uint32_t n = 0 ; n < input_count ; ++n) {
+            const uint32_t input = order[n];
+            uint32_t output = integrators[input][ADC_CIC_ORDER - 1];
+            for (uint32_t s = 0 ; s < ADC_CIC_ORDER ; ++s) {
+                const uint32_t delayed = delays[input][s];
+                delays[input][s] = output;
+                output -= delayed;
+            }
+
+            frame.values[input] = (uint16_t)(output >> shift);
+        }
+
+        sink(context, frame);
+        emitted++;
+    }
+
+    return emitted;
+}
+
+
+/**
+ * @brief Account for samples that were lost, so that later samples are
+ *        still matched to the right inputs.
+ *
+ * @param count: The number of samples lost.
+ */
+void CIC_Decimator::skip(uint32_t count) {
+    if (input_count == 0) return;
+
+    const uint32_t total = phase + count;
+    phase = total % input_count;
+    rounds = (rounds + total / input_count) & ((1 << rate_bits) - 1);
+}
+
+
+uint32_t CIC_Decimator::get_input_count() const {
+    return input_count;
+}
+
+
+/*
+ * PIPELINE
+ */
+
+/**
+ * @brief Constructor: instantiate an idle pipeline.
+ */
+ADC_Pipeline::ADC_Pipeline() {
+    channels[0] = -1;
+    channels[1] = -1;
+    task = NULL;
+    queue = NULL;
+    filled = 0;
+    processed = 0;
+    overruns = 0;
+    dropped = 0;
+    busy_max_us = 0;
+    busy_total_us = 0;
+}
+
+
+/**
+ * @brief Set up the ADC, DMA and decimation task, and start converting.
+ *
+ * @param config:   The inputs, sample rate and decimation rate.
+ * @param priority: The decimation task's priority. Default: ADC_PIPELINE_PRIORITY.
+ *
+ * @retval `true` if acquisition started, otherwise `false`.
+ */
+bool ADC_Pipeline::begin(const ADC_Pipeline_Config& config, UBaseType_t priority) {
+    if (active != nullptr) return false;
+    if (config.sample_rate == 0 || config.sample_rate > ADC_PIPELINE_MAX_RATE) return false;
+    if (!decimator.configure(config.inputs, config.rate_bits)) return false;
+
+    queue = xQueueCreate(ADC_PIPELINE_QUEUE_LENGTH, sizeof(ADC_Frame));
+    channels[0] = dma_claim_unused_channel(false);
+    channels[1] = dma_claim_unused_channel(false);
+    if (queue == NULL || channels[0] < 0 || channels[1] < 0 ||
+        xTaskCreate(run, "ADC_PIPELINE", ADC_PIPELINE_STACK_DEPTH, this, priority, &task) != pdPASS) {
+        end();
+        return false;
+    }
+
+    filled = 0;
+    processed = 0;
+    overruns = 0;
+    dropped = 0;
+    busy_max_us = 0;
+    busy_total_us = 0;
+
+    // Free-running, round robin from the lowest selected input up
+    adc_init();
+    uint32_t first = ADC_PIPELINE_MAX_INPUTS;
+    for (uint32_t i = 0 ; i < ADC_PIPELINE_MAX_INPUTS ; ++i) {
+        if ((config.inputs & (1 << i)) == 0) continue;
+        if (first == ADC_PIPELINE_MAX_INPUTS) first = i;
+        if (i < 4) {
+            adc_gpio_init(ADC_PIPELINE_FIRST_GPIO + i);
+        } else {
+            adc_set_temp_sensor_enabled(true);
+        }
+    }
+
+    adc_select_input(first);
+    adc_set_round_robin(config.inputs);
+    adc_fifo_setup(true, true, 1, false, false);
+
+    // A divider below one conversion time means back to back
+    const uint32_t period = ADC_PIPELINE_CLOCK_HZ / config.sample_rate;
+    adc_set_clkdiv(config.sample_rate >= ADC_PIPELINE_MAX_RATE ? 0.0f : (float)(period - 1));
+
+    // 16-bit transfers from the FIFO, each channel into its own buffer.
+    // The write address wraps on the buffer size, and the transfer count
+    // reloads when the other channel triggers this one
+    for (uint32_t i = 0 ; i < 2 ; ++i) {
+        dma_channel_config dma_config = dma_channel_get_default_config(channels[i]);
+        channel_config_set_transfer_data_size(&dma_config, DMA_SIZE_16);
+        channel_config_set_read_increment(&dma_config, false);
+        channel_config_set_write_increment(&dma_config, true);
+        channel_config_set_ring(&dma_config, true, ADC_PIPELINE_BUFFER_BITS);
+        channel_config_set_dreq(&dma_config, DREQ_ADC);
+        channel_config_set_chain_to(&dma_config, channels[i ^ 1]);
+        dma_channel_configure(channels[i], &dma_config, buffers[i], &adc_hw->fifo, ADC_PIPELINE_BUFFER_SAMPLES, false);
+        dma_channel_set_irq1_enabled(channels[i], true);
+    }
+
+    // DMA_IRQ_1 is shared with RP2040_Temp, and left to UART_DMA_Rx's use of DMA_IRQ_0
+    active = this;
+    irq_add_shared_handler(DMA_IRQ_1, dma_isr, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    irq_set_enabled(DMA_IRQ_1, true);
+
+    adc_fifo_drain();
+    dma_channel_start(channels[0]);
+    adc_run(true);
+    return true;
+}
+
+
+/**
+ * @brief Stop converting, and release the DMA channels and the task.
+ *        Frames still queued are lost.
+ */
+void ADC_Pipeline::end() {
+    const bool running = active == this;
+    if (running) {
+        adc_run(false);
+        irq_remove_handler(DMA_IRQ_1, dma_isr);
+        active = nullptr;
+    }
+
+    for (uint32_t i = 0 ; i < 2 ; ++i) {
+        if (channels[i] < 0) continue;
+        dma_channel_set_irq1_enabled(channels[i], false);
+        dma_channel_abort(channels[i]);
+        dma_channel_unclaim(channels[i]);
+        channels[i] = -1;
+    }
+
+    if (running) {
+        adc_set_round_robin(0);
+        adc_fifo_drain();
+        adc_set_temp_sensor_enabled(false);
+    }
+
+    if (task != NULL) {
+        vTaskDelete(task);
+        task = NULL;
+    }
+
+    if (queue != NULL) {
+        vQueueDelete(queue);
+        queue = NULL;
+    }
+}
+
+
+/**
+ * @brief Wait for the next frame.
+ *
+ * @param frame: Pointer to the frame to fill.
+ * @param wait:  Ticks to block for. Default: `portMAX_DELAY`.
+ *
+ * @retval `true` if a frame was received, otherwise `false`.
+ */
+bool ADC_Pipeline::receive(ADC_Frame* frame, TickType_t wait) {
+    return queue != NULL && xQueueReceive(queue, frame, wait) == pdPASS;
+}
+
+
+QueueHandle_t ADC_Pipeline::get_queue() const {
+    return queue;
+}
+
+
+/**
+ * @brief Buffers filled by the DMA since `begin()`.
+ */
+uint32_t ADC_Pipeline::get_buffers() const {
+    return filled;
+}
+
+
+/**
+ * @brief Buffers the DMA refilled before they were decimated.
+ */
+uint32_t ADC_Pipeline::get_overruns() const {
+    return overruns;
+}
+
+
+/**
+ * @brief Frames lost because the queue was full.
+ */
+uint32_t ADC_Pipeline::get_dropped() const {
+    return dropped;
+}
+
+
+/**
+ * @brief The longest time spent decimating one buffer.
+ */
+uint32_t ADC_Pipeline::get_busy_max_us() const {
+    return busy_max_us;
+}
+
+
+/**
+ * @brief The total time spent decimating, for the CPU load.
+ */
+uint64_t ADC_Pipeline::get_busy_total_us() const {
+    return busy_total_us;
+}
+
+
+void ADC_Pipeline::run(void* pipeline) {
+    ((ADC_Pipeline*)pipeline)->loop();
+}
+
+
+void ADC_Pipeline::post(void* pipeline, const ADC_Frame& frame) {
+    ADC_Pipeline* p = (ADC_Pipeline*)pipeline;
+    if (xQueueSendToBack(p->queue, &frame, 0) != pdPASS) p->dropped++;
+}
+
+
+/**
+ * @brief The decimation task loop: wait for the DMA ISR, then decimate
+ *        each filled buffer in order.
+ */
+void ADC_Pipeline::loop() {
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        while (processed != filled) {
+            // Two buffers pending means the DMA is refilling the older one
+            const uint32_t pending = filled - processed;
+            if (pending > 1) {
+                overruns += pending - 1;
+                decimator.skip((pending - 1) * ADC_PIPELINE_BUFFER_SAMPLES);
+                processed += pending - 1;
+            }
+
+            // Buffer n (from zero) was filled by channel n % 2
+            const uint32_t start = time_us_32();
+            decimator.process(buffers[processed & 1], ADC_PIPELINE_BUFFER_SAMPLES, post, this);
+            const uint32_t busy = time_us_32() - start;
+            busy_total_us += busy;
+            if (busy > busy_max_us) busy_max_us = busy;
+            processed++;
+        }
+    }
+}
+
+
+/**
+ * @brief Shared DMA IRQ handler: count each filled buffer and wake the
+ *        decimation task.
+ */
+void __not_in_flash_func(ADC_Pipeline::dma_isr)() {
+    if (active == nullptr) return;
+
+    BaseType_t higher_priority_task_woken = pdFALSE;
+    for (uint32_t i = 0 ; i < 2 ; ++i) {
+        if (!dma_channel_get_irq1_status(active->channels[i])) continue;
+
+        dma_channel_acknowledge_irq1(active->channels[i]);
+        active->filled = active->filled + 1;
+        vTaskNotifyGiveFromISR(active->task, &higher_priority_task_woken);
+    }
+
+    portYIELD_FROM_ISR(higher_priority_task_woken);
+}
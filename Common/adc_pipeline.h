@@ -0,0 +1,167 @@
+/**
+ * RP2040 FreeRTOS Template - App #5
+ * High-rate multi-channel ADC acquisition with CIC decimation
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#ifndef ADC_PIPELINE_HEADER
+#define ADC_PIPELINE_HEADER
+
+
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+// FreeRTOS
+#include <FreeRTOS.h>
+#include <task.h>
+#include <queue.h>
+// Pico SDK
+#include "pico/stdlib.h"
+#include "hardware/adc.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+
+
+/*
+ * CONSTANTS
+ */
+// Inputs 0-3 are GPIO 26-29; input 4 is the on-die temperature sensor
+#define ADC_PIPELINE_MAX_INPUTS     5
+#define ADC_PIPELINE_FIRST_GPIO     26
+// Conversions per second, shared by the selected inputs. At the limit
+// the ADC converts back to back, every 96 cycles of its 48MHz clock
+#define ADC_PIPELINE_MAX_RATE       500000
+#define ADC_PIPELINE_CLOCK_HZ       48000000
+// Samples per buffer: a power of two, as each DMA ring wraps on an address bit.
+// 1024 16-bit samples wrap on bit 11, and take 2.048ms to fill at the limit
+#define ADC_PIPELINE_BUFFER_BITS    11
+#define ADC_PIPELINE_BUFFER_SAMPLES ((1 << ADC_PIPELINE_BUFFER_BITS) / 2)
+#define ADC_PIPELINE_QUEUE_LENGTH   16
+#define ADC_PIPELINE_STACK_DEPTH    256
+// Decimation must keep up with the DMA, so it runs above the app's tasks
+#define ADC_PIPELINE_PRIORITY       (configMAX_PRIORITIES - 1)
+
+// The CIC filter's register growth is ORDER * RATE_BITS on top of the
+// ADC's 12 bits, so 32-bit registers allow decimation by up to 64
+#define ADC_CIC_ORDER               3
+#define ADC_CIC_MIN_RATE_BITS       2
+#define ADC_CIC_MAX_RATE_BITS       6
+// Outputs keep four bits below the ADC's LSB, which decimation makes real
+#define ADC_FRAME_FRACTION_BITS     4
+
+
+/**
+    One decimated output per selected input, indexed by input number,
+    in ADC counts with ADC_FRAME_FRACTION_BITS fraction bits: full scale
+    is 65520. Inputs not selected read zero.
+ */
+struct ADC_Frame {
+    uint32_t    index;
+    uint16_t    values[ADC_PIPELINE_MAX_INPUTS];
+};
+
+/**
+    Receives each frame as it is decimated.
+ */
+typedef void (*ADC_Frame_Sink)(void* context, const ADC_Frame& frame);
+
+/**
+    ADC_Pipeline settings.
+ */
+struct ADC_Pipeline_Config {
+    uint8_t     inputs;             // Bit n selects input n
+    uint32_t    sample_rate;        // Conversions per second, all inputs together
+    uint32_t    rate_bits;          // Decimate by 2^rate_bits per input
+};
+
+
+/**
+    A CIC (cascaded integrator-comb) decimator for round-robin ADC
+    samples, one filter per input. Integrators run on every sample, and
+    combs on every 2^rate_bits rounds of the inputs, so the cost is three
+    adds per sample and no multiplies. The registers wrap, which the
+    filter tolerates as long as the output fits. The response is a sinc^3,
+    with nulls at multiples of the output rate. It is portable, so it can
+    be benchmarked on a buffer without the ADC running.
+ */
+class CIC_Decimator {
+
+    public:
+        CIC_Decimator();
+
+        bool            configure(uint8_t inputs, uint32_t rate_bits);
+        void            reset();
+        uint32_t        process(const uint16_t* samples, uint32_t count, ADC_Frame_Sink sink, void* context);
+        void            skip(uint32_t count);
+
+        uint32_t        get_input_count() const;
+
+    private:
+        uint8_t     order[ADC_PIPELINE_MAX_INPUTS];
+        uint32_t    input_count;
+        uint32_t    rate_bits;
+        uint32_t    phase;
+        uint32_t    rounds;
+        uint32_t    frames;
+
+        uint32_t    integrators[ADC_PIPELINE_MAX_INPUTS][ADC_CIC_ORDER];
+        uint32_t    delays[ADC_PIPELINE_MAX_INPUTS][ADC_CIC_ORDER];
+};
+
+
+/**
+    Runs the ADC free at up to 500,000 conversions a second, round robin
+    over the selected inputs. Two DMA channels take turns to fill a pair
+    of buffers, each chaining to the other, so the CPU does nothing per
+    conversion. When a buffer fills, the DMA ISR notifies the pipeline's
+    task, which decimates that buffer while the DMA fills the other one,
+    and queues the frames.
+
+    Each buffer must be decimated before the DMA comes back to it, ie.
+    within one buffer time. A buffer that wasn't is skipped and counted as
+    an overrun. The pipeline owns the ADC, so don't run it alongside
+    `RP2040_Temp`. Inputs 0-3 take over their GPIOs.
+ */
+class ADC_Pipeline {
+
+    public:
+        ADC_Pipeline();
+
+        bool            begin(const ADC_Pipeline_Config& config, UBaseType_t priority = ADC_PIPELINE_PRIORITY);
+        void            end();
+
+        bool            receive(ADC_Frame* frame, TickType_t wait = portMAX_DELAY);
+
+        QueueHandle_t   get_queue() const;
+        uint32_t        get_buffers() const;
+        uint32_t        get_overruns() const;
+        uint32_t        get_dropped() const;
+        uint32_t        get_busy_max_us() const;
+        uint64_t        get_busy_total_us() const;
+
+    private:
+        static void     dma_isr();
+        static void     run(void* pipeline);
+        static void     post(void* pipeline, const ADC_Frame& frame);
+        void            loop();
+
+        alignas(ADC_PIPELINE_BUFFER_SAMPLES * 2) uint16_t buffers[2][ADC_PIPELINE_BUFFER_SAMPLES];
+
+        CIC_Decimator       decimator;
+        int                 channels[2];
+        TaskHandle_t        task;
+        QueueHandle_t       queue;
+
+        volatile uint32_t   filled;
+        uint32_t            processed;
+        uint32_t            overruns;
+        uint32_t            dropped;
+        uint32_t            busy_max_us;
+        uint64_t            busy_total_us;
+};
+
+
+#endif  // ADC_PIPELINE_HEADER
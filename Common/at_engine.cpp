@@ -0,0 +1,242 @@
+/**
+ * RP2040 FreeRTOS Template - App #2
+ * Pipelined AT command engine
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#include "at_engine.h"
+
+
+/*
+ * STATIC FUNCTIONS
+ */
+static bool starts_with(const string& line, const string& prefix) {
+    return !prefix.empty() && line.compare(0, prefix.length(), prefix) == 0;
+}
+
+
+/**
+ * @brief Constructor: instantiate a new engine.
+ *
+ * @param write:         Function that sends bytes to the modem.
+ * @param context:       Passed to `write`.
+ * @param max_in_flight: The most pipelined commands to have outstanding.
+ *                       Default: AT_ENGINE_MAX_IN_FLIGHT.
+ */
+AT_Engine::AT_Engine(AT_Write write, void* context, uint32_t max_in_flight) {
+    this->write = write;
+    write_context = context;
+    this->max_in_flight = max_in_flight > 0 ? max_in_flight : 1;
+    urc_handler = nullptr;
+    urc_context = nullptr;
+    urc_count = 0;
+    timeouts = 0;
+
+    // The common 3GPP URCs
+    urc_prefixes = {"RING", "+CMTI:", "+CMT:", "+CDS:", "+CREG:", "+CGREG:", "+CEREG:", "+CLIP:", "+CUSD:"};
+}
+
+
+/**
+ * @brief Treat lines starting with this text as unsolicited.
+ *
+ * @param prefix: The line prefix, eg. "+QIURC:".
+ */
+void AT_Engine::add_urc(const string& prefix) {
+    urc_prefixes.push_back(prefix);
+}
+
+
+/**
+ * @brief Set the function called with each URC line.
+ *
+ * @param handler: The function.
+ * @param context: Passed to the function. Default: `nullptr`.
+ */
+void AT_Engine::set_urc_handler(AT_Urc handler, void* context) {
+    urc_handler = handler;
+    urc_context = context;
+}
+
+
+/**
+ * @brief Queue a command, and send it if the pipeline allows.
+ *
+ * @param command: The command.
+ * @param now_us:  The current time in microseconds.
+ *
+ * @retval `true` if the command was queued, `false` if the queue is full.
+ */
+bool AT_Engine::submit(const AT_Command& command, uint64_t now_us) {
+    if (queued.size() >= AT_ENGINE_QUEUE_DEPTH) return false;
+
+    Pending pending;
+    pending.command = command;
+    pending.submitted_us = now_us;
+    pending.sent_us = 0;
+    pending.deadline_us = 0;
+    pending.echoed = false;
+    queued.push_back(pending);
+    pump(now_us);
+    return true;
+}
+
+
+/**
+ * @brief Process received bytes. Complete lines are matched as they
+ *        arrive, so the caller may pass any amount at a time.
+ *
+ * @param data:   Pointer to the bytes.
+ * @param length: The number of bytes.
+ * @param now_us: The current time in microseconds.
+ */
+void AT_Engine::feed(const uint8_t* data, uint32_t length, uint64_t now_us) {
+    for (uint32_t i = 0 ; i < length ; ++i) {
+        const char c = (char)data[i];
+        if (c == '\n') {
+            if (!line.empty()) on_line(line, now_us);
+            line.clear();
+        } else if (c != '\r' && line.length() < AT_ENGINE_MAX_LINE) {
+            line += c;
+        }
+    }
+}
+
+
+/**
+ * @brief Expire any command that has run out of time, then send
+ *        queued commands. Call regularly, eg. each time `feed()` is
+ *        called and when the receiver times out.
+ *
+ *        NOTE Lines from a command that has timed out, should they
+ *             arrive later, go to the next outstanding command.
+ *
+ * @param now_us: The current time in microseconds.
+ */
+void AT_Engine::poll(uint64_t now_us) {
+    while (!in_flight.empty() && now_us >= in_flight.front().deadline_us) {
+        timeouts++;
+        complete(AT_Status::TIMEOUT, "", now_us);
+    }
+
+    pump(now_us);
+}
+
+
+uint32_t AT_Engine::get_queued() const {
+    return (uint32_t)queued.size();
+}
+
+uint32_t AT_Engine::get_in_flight() const {
+    return (uint32_t)in_flight.size();
+}
+
+uint32_t AT_Engine::get_urc_count() const {
+    return urc_count;
+}
+
+uint32_t AT_Engine::get_timeouts() const {
+    return timeouts;
+}
+
+
+/**
+ * @brief Send queued commands while the pipeline has room. A command not
+ *        marked `pipeline` waits for an empty pipeline, and nothing is
+ *        sent after it until it completes.
+ */
+void AT_Engine::pump(uint64_t now_us) {
+    while (!queued.empty() && in_flight.size() < max_in_flight) {
+        Pending& next = queued.front();
+        if (!in_flight.empty() && (!next.command.pipeline || !in_flight.back().command.pipeline)) break;
+
+        next.sent_us = now_us;
+        next.deadline_us = now_us + next.command.timeout_us;
+        in_flight.push_back(next);
+        queued.pop_front();
+
+        const string& text = in_flight.back().command.text;
+        write(text.c_str(), (uint32_t)text.length(), write_context);
+        write("\r", 1, write_context);
+    }
+}
+
+
+/**
+ * @brief Route one received line: to the oldest outstanding command if it
+ *        is that command's result code or information, otherwise to the
+ *        URC handler.
+ */
+void AT_Engine::on_line(const string& line, uint64_t now_us) {
+    // Drop command echoes, if the modem has them on. A pipelined
+    // command is echoed as the modem receives it, which may be while an
+    // earlier command is still being answered, so match every command
+    // outstanding, oldest first, and each one once
+    for (Pending& pending : in_flight) {
+        if (!pending.echoed && line == pending.command.text) {
+            pending.echoed = true;
+            return;
+        }
+    }
+
+    if (!in_flight.empty()) {
+        Pending& head = in_flight.front();
+
+        if (line == "OK" || (!head.command.success.empty() && line == head.command.success)) {
+            complete(AT_Status::OK, line, now_us);
+            pump(now_us);
+            return;
+        }
+
+        if (is_error(line)) {
+            complete(AT_Status::ERROR, line, now_us);
+            pump(now_us);
+            return;
+        }
+
+        // A response prefix wins over a URC prefix, eg. "+CREG:"
+        // in reply to "AT+CREG?". Once the response has started, other
+        // lines that aren't URCs are part of it, eg. an SMS body
+        const bool started = head.command.prefix.empty() || !head.result.lines.empty();
+        if (starts_with(line, head.command.prefix) || (started && !is_urc(line))) {
+            head.result.lines.push_back(line);
+            return;
+        }
+    }
+
+    urc_count++;
+    if (urc_handler != nullptr) urc_handler(line, urc_context);
+}
+
+
+/**
+ * @brief Finish the oldest outstanding command and report it.
+ */
+void AT_Engine::complete(AT_Status status, const string& final, uint64_t now_us) {
+    Pending done = in_flight.front();
+    in_flight.pop_front();
+
+    done.result.status = status;
+    done.result.final = final;
+    done.result.latency_us = now_us - done.submitted_us;
+    done.result.response_us = now_us - done.sent_us;
+    if (done.command.done != nullptr) done.command.done(done.result, done.command.context);
+}
+
+
+bool AT_Engine::is_urc(const string& line) const {
+    for (const string& prefix : urc_prefixes) {
+        if (starts_with(line, prefix)) return true;
+    }
+
+    return false;
+}
+
+
+bool AT_Engine::is_error(const string& line) const {
+    return line == "ERROR" || starts_with(line, "+CME ERROR:") || starts_with(line, "+CMS ERROR:")
+        || line == "NO CARRIER" || line == "BUSY" || line == "NO ANSWER" || line == "NO DIALTONE";
+}
@@ -0,0 +1,139 @@
+/**
+ * RP2040 FreeRTOS Template - App #2
+ * Pipelined AT command engine
+ *
+ * Portable: it has no Pico SDK or FreeRTOS dependencies. The caller
+ * supplies the write function and the time, and feeds it received bytes.
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#ifndef AT_ENGINE_HEADER
+#define AT_ENGINE_HEADER
+
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <cstdlib>
+#include <cstdint>
+
+
+using std::string;
+using std::vector;
+using std::deque;
+
+
+/*
+ * CONSTANTS
+ */
+#define AT_ENGINE_QUEUE_DEPTH       16
+#define AT_ENGINE_MAX_IN_FLIGHT     4
+#define AT_ENGINE_MAX_LINE          256
+#define AT_ENGINE_DEFAULT_TIMEOUT_US    1000000
+
+
+/*
+ * ENUMERATIONS
+ */
+enum class AT_Status : uint8_t {
+    OK,
+    ERROR,
+    TIMEOUT
+};
+
+
+/**
+    The outcome of one command.
+ */
+struct AT_Result {
+    AT_Status       status;
+    vector<string>  lines;              // Information lines, in order
+    string          final;              // The result code line
+    uint64_t        latency_us;         // Submission to completion
+    uint64_t        response_us;        // Sending to completion, so excluding time queued
+};
+
+typedef void (*AT_Write)(const char* data, uint32_t length, void* context);
+typedef void (*AT_Done)(const AT_Result& result, void* context);
+typedef void (*AT_Urc)(const string& line, void* context);
+
+
+/**
+    A command to queue. `prefix` marks the information lines that belong
+    to it, eg. "+CSQ:"; if it is empty, any line not recognised as a URC
+    is taken as the response. `success` is a result code to accept as
+    well as "OK", eg. "CONNECT".
+ */
+struct AT_Command {
+    string          text;
+    string          prefix;
+    string          success;
+    uint32_t        timeout_us = AT_ENGINE_DEFAULT_TIMEOUT_US;
+    bool            pipeline = false;   // May be sent before the commands ahead of it complete
+    AT_Done         done = nullptr;
+    void*           context = nullptr;
+};
+
+
+/**
+    Queues AT commands and matches the modem's replies to them as lines
+    stream in. Up to `max_in_flight` commands marked `pipeline` may be
+    outstanding at once; modems answer in order, so replies go to the
+    oldest outstanding command. Unsolicited result codes (URCs) are passed
+    to their own handler as they arrive, and never block or complete a
+    command, even mid-response.
+ */
+class AT_Engine {
+
+    public:
+        AT_Engine(AT_Write write, void* context, uint32_t max_in_flight = AT_ENGINE_MAX_IN_FLIGHT);
+
+        void            add_urc(const string& prefix);
+        void            set_urc_handler(AT_Urc handler, void* context = nullptr);
+
+        bool            submit(const AT_Command& command, uint64_t now_us);
+        void            feed(const uint8_t* data, uint32_t length, uint64_t now_us);
+        void            poll(uint64_t now_us);
+
+        uint32_t        get_queued() const;
+        uint32_t        get_in_flight() const;
+        uint32_t        get_urc_count() const;
+        uint32_t        get_timeouts() const;
+
+    private:
+        struct Pending {
+            AT_Command  command;
+            AT_Result   result;
+            uint64_t    submitted_us;
+            uint64_t    sent_us;
+            uint64_t    deadline_us;
+            bool        echoed;
+        };
+
+        void            pump(uint64_t now_us);
+        void            on_line(const string& line, uint64_t now_us);
+        void            complete(AT_Status status, const string& final, uint64_t now_us);
+        bool            is_urc(const string& line) const;
+        bool            is_error(const string& line) const;
+
+        AT_Write        write;
+        void*           write_context;
+        uint32_t        max_in_flight;
+
+        AT_Urc          urc_handler;
+        void*           urc_context;
+        vector<string>  urc_prefixes;
+
+        deque<Pending>  queued;
+        deque<Pending>  in_flight;
+        string          line;
+
+        uint32_t        urc_count;
+        uint32_t        timeouts;
+};
+
+
+#endif  // AT_ENGINE_HEADER
@@ -0,0 +1,159 @@
+/**
+ * RP2040 FreeRTOS Template - App #3
+ * A queue that sends and receives items in batches
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#ifndef BATCH_QUEUE_HEADER
+#define BATCH_QUEUE_HEADER
+
+
+#include <cstdlib>
+#include <cstdint>
+// FreeRTOS
+#include <FreeRTOS.h>
+#include <task.h>
+
+
+/**
+    A fixed-size FIFO of `T` for passing items from tasks and ISRs to one
+    receiving task. A FreeRTOS queue enters a critical section, and may
+    wake the receiver, for every item. A `Batch_Queue` moves up to a whole
+    batch under one critical section, and wakes the receiver at most once
+    per batch.
+
+    Any number of tasks and ISRs on core 0 may send. Senders never block:
+    `send()` takes as many items as there is room for. One task receives,
+    and may block until items arrive. It waits on notification index 0,
+    so it must not also wait for other notifications on that index.
+    Items are copied inside the critical section, so keep `T` and the
+    batches small. `SIZE` must be a power of two.
+ */
+template <typename T, uint32_t SIZE>
+class Batch_Queue {
+
+    static_assert(SIZE > 0 && (SIZE & (SIZE - 1)) == 0, "Batch_Queue SIZE must be a power of two");
+
+    public:
+        /**
+         * @brief Task only: append up to `count` items, waking the receiver.
+         *
+         * @retval The number of items added: fewer than `count` if the queue filled.
+         */
+        uint32_t send(const T* from, uint32_t count) {
+            taskENTER_CRITICAL();
+            const uint32_t added = put(from, count);
+            const TaskHandle_t waiting = take_receiver(added);
+            taskEXIT_CRITICAL();
+
+            if (waiting != NULL) xTaskNotifyGive(waiting);
+            return added;
+        }
+
+        /**
+         * @brief ISR only: append up to `count` items, waking the receiver.
+         *
+         * @param task_woken: Set to `pdTRUE` if the receiver should run on exit
+         *                    from the ISR: pass it to `portYIELD_FROM_ISR()`.
+         *
+         * @retval The number of items added: fewer than `count` if the queue filled.
+         */
+        uint32_t send_from_isr(const T* from, uint32_t count, BaseType_t* task_woken) {
+            const UBaseType_t state = taskENTER_CRITICAL_FROM_ISR();
+            const uint32_t added = put(from, count);
+            const TaskHandle_t waiting = take_receiver(added);
+            taskEXIT_CRITICAL_FROM_ISR(state);
+
+            if (waiting != NULL) vTaskNotifyGiveFromISR(waiting, task_woken);
+            return added;
+        }
+
+        /**
+         * @brief The receiving task only: remove up to `count` items, waiting
+         *        up to `wait` ticks for the first to arrive.
+         *
+         * @retval The number of items removed, or 0 if the wait timed out.
+         */
+        uint32_t receive(T* to, uint32_t count, TickType_t wait) {
+            TimeOut_t timeout;
+            vTaskSetTimeOutState(&timeout);
+
+            while (true) {
+                taskENTER_CRITICAL();
+                const uint32_t removed = get(to, count);
+                if (removed == 0 && wait > 0) receiver = xTaskGetCurrentTaskHandle();
+                taskEXIT_CRITICAL();
+
+                if (removed > 0 || wait == 0) return removed;
+
+                // Another notification may wake the task early, so check
+                // again rather than assume an item is waiting
+                if (xTaskCheckForTimeOut(&timeout, &wait) == pdTRUE) {
+                    taskENTER_CRITICAL();
+                    receiver = NULL;
+                    const uint32_t late = get(to, count);
+                    taskEXIT_CRITICAL();
+                    return late;
+                }
+
+                ulTaskNotifyTake(pdTRUE, wait);
+            }
+        }
+
+        /**
+         * @brief ISR only: remove up to `count` items without waiting.
+         *
+         * @retval The number of items removed.
+         */
+        uint32_t receive_from_isr(T* to, uint32_t count) {
+            const UBaseType_t state = taskENTER_CRITICAL_FROM_ISR();
+            const uint32_t removed = get(to, count);
+            taskEXIT_CRITICAL_FROM_ISR(state);
+            return removed;
+        }
+
+        uint32_t get_count() const {
+            return head - tail;
+        }
+
+        uint32_t get_space() const {
+            return SIZE - (head - tail);
+        }
+
+    private:
+        // Call with interrupts masked
+        uint32_t put(const T* from, uint32_t count) {
+            const uint32_t h = head;
+            const uint32_t space = SIZE - (h - tail);
+            if (count > space) count = space;
+            for (uint32_t i = 0 ; i < count ; ++i) items[(h + i) & (SIZE - 1)] = from[i];
+            head = h + count;
+            return count;
+        }
+
+        uint32_t get(T* to, uint32_t count) {
+            const uint32_t t = tail;
+            const uint32_t held = head - t;
+            if (count > held) count = held;
+            for (uint32_t i = 0 ; i < count ; ++i) to[i] = items[(t + i) & (SIZE - 1)];
+            tail = t + count;
+            return count;
+        }
+
+        TaskHandle_t take_receiver(uint32_t added) {
+            const TaskHandle_t waiting = added > 0 ? receiver : NULL;
+            if (waiting != NULL) receiver = NULL;
+            return waiting;
+        }
+
+        T                       items[SIZE];
+        volatile uint32_t       head = 0;           // Items ever added...
+        volatile uint32_t       tail = 0;           // ...and removed
+        TaskHandle_t            receiver = NULL;    // Set while the receiver waits
+};
+
+
+#endif  // BATCH_QUEUE_HEADER
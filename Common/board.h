@@ -0,0 +1,208 @@
+/**
+ * RP2040 FreeRTOS Template - App #3
+ * Compile-time board descriptions: pins, buses and device addresses
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#ifndef BOARD_HEADER
+#define BOARD_HEADER
+
+
+#include <cstdlib>
+#include <cstdint>
+// Pico SDK
+#include "pico/stdlib.h"
+#include "hardware/i2c.h"
+
+
+/*
+ * CONSTANTS
+ */
+#define BOARD_GPIO_COUNT            30
+// ADC inputs 0-3 are on GPIO 26-29; input 4 is the on-die sensor
+#define BOARD_ADC_FIRST_GPIO        26
+#define BOARD_ADC_GPIO_INPUTS       4
+
+
+/*
+ * BOARD DESCRIPTIONS
+ *
+ * Each board is a type with `static constexpr` members, so every use
+ * compiles to an immediate constant. Select one for a build with the
+ * `APP_BOARD` CMake setting; `Board` names it. To add a board, copy a
+ * description, add its `APP_BOARD_...` case below, and check it with
+ * `Board_Check`.
+ */
+
+/**
+    The wiring in the README's circuit diagrams: the HT16K33 display and
+    the MCP9808 sensor on I2C1 at GP2 and GP3. The alert LED takes GP26,
+    so ADC input 0 is not available.
+ */
+struct Board_Demo {
+    static constexpr uint32_t   LED_PIN = PICO_DEFAULT_LED_PIN;
+    static constexpr uint32_t   RED_LED_PIN = 20;
+    static constexpr uint32_t   ALERT_LED_PIN = 26;
+    static constexpr uint32_t   ALERT_SENSE_PIN = 16;
+
+    static constexpr uint32_t   I2C_INDEX = 1;
+    static constexpr uint32_t   I2C_SDA_PIN = 2;
+    static constexpr uint32_t   I2C_SCL_PIN = 3;
+    static constexpr uint32_t   I2C_FREQUENCY = 400000;
+
+    // STDIO on UART0, and the UART1 pins the benchmarks claim, though
+    // they run UART1 in internal loopback
+    static constexpr uint32_t   UART_TX_PIN = 0;
+    static constexpr uint32_t   UART_RX_PIN = 1;
+    static constexpr uint32_t   LOOP_UART_TX_PIN = 4;
+    static constexpr uint32_t   LOOP_UART_RX_PIN = 5;
+
+    // Bit n: ADC input n is wired for analog use. Input 3 is the
+    // Pico's VSYS / 3 divider
+    static constexpr uint8_t    ADC_INPUTS = 1 << 3;
+
+    static constexpr uint8_t    DISPLAY_ADDRESS = 0x70;
+    static constexpr uint8_t    SENSOR_ADDRESS = 0x18;
+};
+
+/**
+    The same parts on I2C0 at GP4 and GP5, the SDK's default I2C pins,
+    for carrier boards that use GP2 and GP3 for something else. The
+    display's A0 jumper is bridged.
+ */
+struct Board_I2C0 {
+    static constexpr uint32_t   LED_PIN = PICO_DEFAULT_LED_PIN;
+    static constexpr uint32_t   RED_LED_PIN = 14;
+    static constexpr uint32_t   ALERT_LED_PIN = 15;
+    static constexpr uint32_t   ALERT_SENSE_PIN = 6;
+
+    static constexpr uint32_t   I2C_INDEX = 0;
+    static constexpr uint32_t   I2C_SDA_PIN = 4;
+    static constexpr uint32_t   I2C_SCL_PIN = 5;
+    static constexpr uint32_t   I2C_FREQUENCY = 400000;
+
+    static constexpr uint32_t   UART_TX_PIN = 0;
+    static constexpr uint32_t   UART_RX_PIN = 1;
+    static constexpr uint32_t   LOOP_UART_TX_PIN = 8;
+    static constexpr uint32_t   LOOP_UART_RX_PIN = 9;
+
+    static constexpr uint8_t    ADC_INPUTS = 1 << 3;
+
+    static constexpr uint8_t    DISPLAY_ADDRESS = 0x71;
+    static constexpr uint8_t    SENSOR_ADDRESS = 0x18;
+};
+
+
+/*
+ * CHECKS
+ */
+namespace Board_Rules {
+
+    constexpr bool is_gpio(uint32_t pin) {
+        return pin < BOARD_GPIO_COUNT;
+    }
+
+    // GPIO n can carry SDA or SCL for one I2C block only: n % 4 is
+    // 0 for I2C0 SDA, 1 for I2C0 SCL, 2 for I2C1 SDA and 3 for I2C1 SCL
+    constexpr bool is_i2c_sda(uint32_t pin, uint32_t index) {
+        return pin % 4 == index * 2;
+    }
+
+    constexpr bool is_i2c_scl(uint32_t pin, uint32_t index) {
+        return pin % 4 == index * 2 + 1;
+    }
+
+    // UART0 TX is on GPIO 0, 12, 16 and 28, UART1 TX on 4, 8, 20 and 24;
+    // each RX is on the GPIO above its TX
+    constexpr bool is_uart_tx(uint32_t pin, uint32_t index) {
+        return pin % 4 == 0 && ((pin + 4) / 8) % 2 == index;
+    }
+
+    constexpr bool is_uart_rx(uint32_t pin, uint32_t index) {
+        return pin % 4 == 1 && is_uart_tx(pin - 1, index);
+    }
+
+    // Addresses 0x00-0x07 and 0x78-0x7F are reserved by the I2C specification
+    constexpr bool is_i2c_address(uint8_t address) {
+        return address >= 0x08 && address <= 0x77;
+    }
+
+    template <typename B>
+    constexpr bool pins_distinct() {
+        const uint32_t pins[] = {B::LED_PIN, B::RED_LED_PIN, B::ALERT_LED_PIN, B::ALERT_SENSE_PIN, B::I2C_SDA_PIN, B::I2C_SCL_PIN,
+                                 B::UART_TX_PIN, B::UART_RX_PIN, B::LOOP_UART_TX_PIN, B::LOOP_UART_RX_PIN};
+        for (uint32_t i = 0 ; i < sizeof(pins) / sizeof(pins[0]) ; ++i) {
+            for (uint32_t j = i + 1 ; j < sizeof(pins) / sizeof(pins[0]) ; ++j) {
+                if (pins[i] == pins[j]) return false;
+            }
+        }
+
+        return true;
+    }
+
+    template <typename B>
+    constexpr bool pins_valid() {
+        return is_gpio(B::LED_PIN) && is_gpio(B::RED_LED_PIN) && is_gpio(B::ALERT_LED_PIN) &&
+               is_gpio(B::ALERT_SENSE_PIN) && is_gpio(B::I2C_SDA_PIN) && is_gpio(B::I2C_SCL_PIN) &&
+               is_gpio(B::UART_TX_PIN) && is_gpio(B::UART_RX_PIN) && is_gpio(B::LOOP_UART_TX_PIN) && is_gpio(B::LOOP_UART_RX_PIN);
+    }
+
+    // A pin wired for analog use can't also carry a digital function
+    template <typename B>
+    constexpr bool adc_pins_free() {
+        const uint32_t pins[] = {B::LED_PIN, B::RED_LED_PIN, B::ALERT_LED_PIN, B::ALERT_SENSE_PIN, B::I2C_SDA_PIN, B::I2C_SCL_PIN,
+                                 B::UART_TX_PIN, B::UART_RX_PIN, B::LOOP_UART_TX_PIN, B::LOOP_UART_RX_PIN};
+        for (uint32_t pin : pins) {
+            if (pin >= BOARD_ADC_FIRST_GPIO && (B::ADC_INPUTS >> (pin - BOARD_ADC_FIRST_GPIO)) & 1) return false;
+        }
+
+        return true;
+    }
+}
+
+/**
+    Instantiate to check a board description at compile time.
+ */
+template <typename B>
+struct Board_Check {
+    static_assert(Board_Rules::pins_valid<B>(), "Board pin is not a GPIO");
+    static_assert(Board_Rules::pins_distinct<B>(), "Board pins conflict: two functions share a GPIO");
+    static_assert(B::I2C_INDEX < 2, "Board I2C block must be 0 or 1");
+    static_assert(Board_Rules::is_i2c_sda(B::I2C_SDA_PIN, B::I2C_INDEX), "Board SDA pin can't carry SDA for this I2C block");
+    static_assert(Board_Rules::is_i2c_scl(B::I2C_SCL_PIN, B::I2C_INDEX), "Board SCL pin can't carry SCL for this I2C block");
+    static_assert(B::I2C_FREQUENCY > 0 && B::I2C_FREQUENCY <= 1000000, "Board I2C frequency is out of range");
+    static_assert(Board_Rules::is_i2c_address(B::DISPLAY_ADDRESS), "Board display address is reserved");
+    static_assert(Board_Rules::is_i2c_address(B::SENSOR_ADDRESS), "Board sensor address is reserved");
+    static_assert(B::DISPLAY_ADDRESS != B::SENSOR_ADDRESS, "Board I2C addresses conflict");
+    static_assert(Board_Rules::is_uart_tx(B::UART_TX_PIN, 0) && Board_Rules::is_uart_rx(B::UART_RX_PIN, 0), "Board STDIO pins can't carry UART0");
+    static_assert(Board_Rules::is_uart_tx(B::LOOP_UART_TX_PIN, 1) && Board_Rules::is_uart_rx(B::LOOP_UART_RX_PIN, 1), "Board loopback pins can't carry UART1");
+    static_assert(B::ADC_INPUTS < (1 << BOARD_ADC_GPIO_INPUTS), "Board ADC inputs must be 0-3");
+    static_assert(Board_Rules::adc_pins_free<B>(), "Board pin conflict: an ADC input's GPIO has a digital function");
+
+    static constexpr bool ok = true;
+};
+
+// Every description is checked in every build, not just the one selected
+static_assert(Board_Check<Board_Demo>::ok && Board_Check<Board_I2C0>::ok);
+
+
+/*
+ * SELECTED BOARD
+ *
+ * CMake rejects an `APP_BOARD` it doesn't know, so the default only
+ * applies to builds outside CMake
+ */
+#if defined(APP_BOARD_I2C0)
+typedef Board_I2C0      Board;
+#else
+typedef Board_Demo      Board;
+#endif
+
+// The SDK's I2C instance for the selected board's block
+#define BOARD_I2C_PORT              (Board::I2C_INDEX == 0 ? i2c0 : i2c1)
+
+
+#endif  // BOARD_HEADER
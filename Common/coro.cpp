@@ -0,0 +1,252 @@
+/**
+ * RP2040 FreeRTOS Template - App #2
+ * C++20 coroutine executor for FreeRTOS
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#include "coro.h"
+
+
+namespace Coro {
+
+/*
+ * GLOBALS
+ */
+// Live coroutine frame RAM, for comparison with task stacks
+uint32_t frame_bytes = 0;
+uint32_t frame_count = 0;
+
+
+/*
+ * TASK
+ */
+
+Task Task::promise_type::get_return_object() noexcept {
+    return Task(Handle::from_promise(*this));
+}
+
+void Task::promise_type::unhandled_exception() noexcept {
+    panic("Unhandled exception in coroutine");
+}
+
+/**
+ * @brief Allocate a coroutine frame from the FreeRTOS heap.
+ *
+ * @param size: The frame size, as computed by the compiler.
+ *
+ * @retval Pointer to the frame, or `nullptr` if the heap is exhausted.
+ */
+void* Task::promise_type::operator new(size_t size) noexcept {
+    void* frame = pvPortMalloc(size);
+    if (frame != nullptr) {
+        frame_bytes += size;
+        frame_count += 1;
+    }
+
+    return frame;
+}
+
+void Task::promise_type::operator delete(void* frame, size_t size) noexcept {
+    frame_bytes -= size;
+    frame_count -= 1;
+    vPortFree(frame);
+}
+
+/**
+ * @brief Destroy a coroutine that was never handed to an Executor.
+ */
+Task::~Task() {
+    if (handle) handle.destroy();
+}
+
+
+/*
+ * WAITERS
+ */
+
+bool Sleep::ready() {
+    return (TickType_t)(xTaskGetTickCount() - start) >= period;
+}
+
+TickType_t Sleep::ticks_to_wake(TickType_t now) {
+    const TickType_t elapsed = now - start;
+    return elapsed >= period ? 0 : period - elapsed;
+}
+
+bool Receive::ready() {
+    return xQueueReceive(queue, item, 0) == pdPASS;
+}
+
+bool I2CTransfer::ready() {
+    if (status == 0) status = I2C::transfer_status();
+    if (status > 0 && data != nullptr) {
+        I2C::collect(data, count);
+        data = nullptr;
+    }
+
+    return status != 0;
+}
+
+bool Event::Wait::ready() {
+    if (!event.signalled) return false;
+    event.signalled = false;
+    return true;
+}
+
+
+/*
+ * EVENT
+ */
+
+/**
+ * @brief Signal the Event from task context.
+ */
+void Event::set() {
+    signalled = true;
+    if (executor != nullptr) executor->wake();
+}
+
+/**
+ * @brief Signal the Event from an ISR.
+ *
+ * @param higher_priority_task_woken: Passed to `vTaskNotifyGiveFromISR()`.
+ */
+void Event::set_from_isr(BaseType_t* higher_priority_task_woken) {
+    signalled = true;
+    if (executor != nullptr) executor->wake_from_isr(higher_priority_task_woken);
+}
+
+
+/*
+ * EXECUTOR
+ */
+
+/**
+ * @brief Create the FreeRTOS task that runs the coroutines.
+ *
+ * @param name:        The task name.
+ * @param stack_depth: The task stack size in words. All coroutines share it.
+ * @param priority:    The task priority.
+ *
+ * @retval `true` if the task was created, otherwise `false`.
+ */
+bool Executor::start(const char* name, uint16_t stack_depth, UBaseType_t priority) {
+    return xTaskCreate(run, name, stack_depth, this, priority, &handle) == pdPASS;
+}
+
+/**
+ * @brief Take ownership of a coroutine and schedule its first run.
+ *
+ * @param task: The value returned by calling the coroutine function.
+ *
+ * @retval `true` if the coroutine was scheduled, `false` if its frame
+ *         could not be allocated.
+ */
+bool Executor::spawn(Task&& task) {
+    Task::Handle h = task.release();
+    if (!h) return false;
+
+    h.promise().executor = this;
+    h.promise().start.handle = h;
+    park(&h.promise().start);
+    wake();
+    return true;
+}
+
+/**
+ * @brief Add a suspended coroutine's waiter to the list.
+ *
+ * @param waiter: The waiter to check on each pass.
+ */
+void Executor::park(Waiter* waiter) {
+    waiter->next = waiting;
+    waiting = waiter;
+}
+
+void Executor::wake() {
+    if (handle != NULL) xTaskNotifyGive(handle);
+}
+
+void Executor::wake_from_isr(BaseType_t* higher_priority_task_woken) {
+    if (handle != NULL) vTaskNotifyGiveFromISR(handle, higher_priority_task_woken);
+}
+
+void Executor::run(void* executor) {
+    ((Executor*)executor)->loop();
+}
+
+/**
+ * @brief The Executor task loop: resume every coroutine whose waiter is
+ *        ready, then block until the nearest wake-up time or a notification.
+ */
+void Executor::loop() {
+    while (true) {
+        bool resumed = false;
+
+        // Resume ready coroutines. A resumed coroutine may park a new
+        // waiter at the head of the list, so unlink before resuming
+        Waiter** link = &waiting;
+        while (*link != nullptr) {
+            Waiter* waiter = *link;
+            if (waiter->ready()) {
+                *link = waiter->next;
+                std::coroutine_handle<> h = waiter->handle;
+                h.resume();
+                if (h.done()) h.destroy();
+                resumed = true;
+            } else {
+                link = &waiter->next;
+            }
+        }
+
+        if (resumed) continue;
+
+        // Nothing ready: sleep until the earliest deadline
+        const TickType_t now = xTaskGetTickCount();
+        TickType_t wait = portMAX_DELAY;
+        for (Waiter* waiter = waiting ; waiter != nullptr ; waiter = waiter->next) {
+            const TickType_t ticks = waiter->ticks_to_wake(now);
+            if (ticks < wait) wait = ticks;
+        }
+
+        ulTaskNotifyTake(pdTRUE, wait);
+    }
+}
+
+
+/*
+ * I2C
+ */
+
+/**
+ * @brief Queue an I2C write for a coroutine to `co_await`.
+ *
+ * @param address: The I2C address of the device to write to.
+ * @param data:    Pointer to the bytes to send.
+ * @param count:   The number of bytes to send (max. I2C_FIFO_DEPTH).
+ * @param no_stop: `true` to hold the bus for a following read. Default: `false`.
+ *
+ * @retval The awaitable transfer.
+ */
+I2CTransfer i2c_write(uint8_t address, const uint8_t* data, uint8_t count, bool no_stop) {
+    return I2CTransfer(I2C::start_write(address, data, count, no_stop));
+}
+
+/**
+ * @brief Queue an I2C read for a coroutine to `co_await`.
+ *
+ * @param address: The I2C address of the device to read from.
+ * @param data:    Pointer to byte storage, filled on completion.
+ * @param count:   The number of bytes to read (max. I2C_FIFO_DEPTH).
+ *
+ * @retval The awaitable transfer.
+ */
+I2CTransfer i2c_read(uint8_t address, uint8_t* data, uint8_t count) {
+    return I2CTransfer(I2C::start_read(address, count), data, count);
+}
+
+
+}   // namespace Coro
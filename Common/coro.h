@@ -0,0 +1,246 @@
+/**
+ * RP2040 FreeRTOS Template - App #2
+ * C++20 coroutine executor for FreeRTOS
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#ifndef CORO_HEADER
+#define CORO_HEADER
+
+
+#include <coroutine>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+// FreeRTOS
+#include <FreeRTOS.h>
+#include <task.h>
+#include <queue.h>
+// Pico SDK
+#include "pico/stdlib.h"
+// App
+#include "i2c_utils.h"
+
+
+/*
+ * CONSTANTS
+ */
+// Ticks between checks of polled waiters (queues, I2C)
+#define CORO_POLL_PERIOD_TICKS      1
+
+
+namespace Coro {
+
+class Executor;
+
+
+/*
+ * RAM USAGE
+ */
+extern uint32_t frame_bytes;
+extern uint32_t frame_count;
+
+
+/**
+    Base class of everything a coroutine can `co_await`. A Waiter lives in
+    the suspended coroutine's frame and is linked into its Executor's list
+    until `ready()` reports that the coroutine can be resumed.
+ */
+class Waiter {
+
+    public:
+        bool                await_ready() { return ready(); }
+        void                await_resume() {}
+
+        template <typename P>
+        void                await_suspend(std::coroutine_handle<P> h) {
+            handle = h;
+            h.promise().executor->park(this);
+        }
+
+        virtual bool        ready() = 0;
+        virtual TickType_t  ticks_to_wake(TickType_t now) { return portMAX_DELAY; }
+
+        std::coroutine_handle<>  handle;
+        Waiter*             next = nullptr;
+};
+
+
+/**
+    Always ready: used to schedule a newly spawned coroutine's first run.
+ */
+class Start : public Waiter {
+
+    public:
+        bool                ready() override { return true; }
+};
+
+
+/**
+    The return type of every coroutine run by an Executor. The frame is
+    allocated from the FreeRTOS heap and owned by the Executor once spawned.
+ */
+class Task {
+
+    public:
+        struct promise_type {
+            Executor*           executor = nullptr;
+            Start               start;
+
+            Task                get_return_object() noexcept;
+            std::suspend_always initial_suspend() noexcept { return {}; }
+            std::suspend_always final_suspend() noexcept { return {}; }
+            void                return_void() noexcept {}
+            void                unhandled_exception() noexcept;
+
+            static Task         get_return_object_on_allocation_failure() noexcept { return Task(nullptr); }
+            static void*        operator new(size_t size) noexcept;
+            static void         operator delete(void* frame, size_t size) noexcept;
+        };
+
+        using Handle = std::coroutine_handle<promise_type>;
+
+        explicit Task(Handle h) : handle(h) {}
+        Task(Task&& other) noexcept : handle(other.handle) { other.handle = nullptr; }
+        Task(const Task&) = delete;
+        ~Task();
+
+        Handle              release() { Handle h = handle; handle = nullptr; return h; }
+
+    private:
+        Handle              handle;
+};
+
+
+/**
+    Suspend the coroutine for a number of ticks.
+ */
+class Sleep : public Waiter {
+
+    public:
+        Sleep(TickType_t ticks) : start(xTaskGetTickCount()), period(ticks) {}
+
+        bool                ready() override;
+        TickType_t          ticks_to_wake(TickType_t now) override;
+
+    private:
+        TickType_t          start;
+        TickType_t          period;
+};
+
+
+/**
+    Suspend the coroutine until an item arrives on a FreeRTOS queue.
+    The queue is polled every CORO_POLL_PERIOD_TICKS.
+ */
+class Receive : public Waiter {
+
+    public:
+        Receive(QueueHandle_t queue, void* item) : queue(queue), item(item) {}
+
+        bool                ready() override;
+        TickType_t          ticks_to_wake(TickType_t now) override { return CORO_POLL_PERIOD_TICKS; }
+
+    private:
+        QueueHandle_t       queue;
+        void*               item;
+};
+
+
+/**
+    Suspend the coroutine until an I2C transfer queued by `Coro::i2c_write()`
+    or `Coro::i2c_read()` completes. `co_await` yields `true` on success,
+    `false` if the transfer could not start or was aborted.
+ */
+class I2CTransfer : public Waiter {
+
+    public:
+        I2CTransfer(bool started, uint8_t* data = nullptr, uint8_t count = 0)
+            : data(data), count(count), status(started ? 0 : -1) {}
+
+        bool                ready() override;
+        TickType_t          ticks_to_wake(TickType_t now) override { return CORO_POLL_PERIOD_TICKS; }
+        bool                await_resume() { return status > 0; }
+
+    private:
+        uint8_t*            data;
+        uint8_t             count;
+        int                 status;
+};
+
+
+/**
+    A latching, auto-clearing flag: the coroutine equivalent of a direct
+    task notification. Only one coroutine should wait on an Event at a time.
+    Several `set()` calls before the wait completes count as one.
+ */
+class Event {
+
+    public:
+        class Wait : public Waiter {
+            public:
+                Wait(Event& event) : event(event) {}
+                bool        ready() override;
+
+                template <typename P>
+                void        await_suspend(std::coroutine_handle<P> h) {
+                    event.executor = h.promise().executor;
+                    Waiter::await_suspend(h);
+                }
+
+            private:
+                Event&      event;
+        };
+
+        Wait                wait() { return Wait(*this); }
+        void                set();
+        void                set_from_isr(BaseType_t* higher_priority_task_woken);
+
+    private:
+        Executor* volatile  executor = nullptr;
+        volatile bool       signalled = false;
+};
+
+
+/**
+    Runs any number of coroutines on a single FreeRTOS task. The task sleeps
+    until the nearest timer deadline or until woken by an Event; it polls
+    only while a coroutine is waiting on a queue or I2C transfer.
+
+    NOTE Call `spawn()` before `start()`, or from a coroutine already
+         running on the Executor: the waiter list is not locked.
+ */
+class Executor {
+
+    public:
+        bool                start(const char* name, uint16_t stack_depth, UBaseType_t priority);
+        bool                spawn(Task&& task);
+        void                wake();
+        void                wake_from_isr(BaseType_t* higher_priority_task_woken);
+
+        void                park(Waiter* waiter);
+        TaskHandle_t        handle = NULL;
+
+    private:
+        static void         run(void* executor);
+        void                loop();
+
+        Waiter*             waiting = nullptr;
+};
+
+
+/*
+ * CONVENIENCE AWAITABLES
+ */
+inline Sleep                sleep(TickType_t ticks) { return Sleep(ticks); }
+inline Receive              receive(QueueHandle_t queue, void* item) { return Receive(queue, item); }
+I2CTransfer                 i2c_write(uint8_t address, const uint8_t* data, uint8_t count, bool no_stop = false);
+I2CTransfer                 i2c_read(uint8_t address, uint8_t* data, uint8_t count);
+
+}   // namespace Coro
+
+
+#endif  // CORO_HEADER
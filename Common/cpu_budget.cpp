@@ -0,0 +1,302 @@
+/**
+ * RP2040 FreeRTOS Template - App #3
+ * Per-task CPU budgets, enforced from the tick hook
+ *
+ * Compiled into apps whose FreeRTOS library is built with
+ * `configUSE_CPU_BUDGET` set to 1.
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#include "cpu_budget.h"
+#include "pico/stdlib.h"
+
+
+#if configUSE_CPU_BUDGET
+
+/*
+ * CONSTANTS
+ */
+// A record's progress through a window
+#define BUDGET_OK                   0
+#define BUDGET_OVER                 1   // Overran: the enforcer is to throttle the task
+#define BUDGET_THROTTLED            2
+#define BUDGET_RELEASE              3   // Window over: the enforcer is to restore the task
+
+
+/*
+ * GLOBALS
+ */
+static CPU_Budget_Record    records[CPU_BUDGET_MAX_TASKS];
+static CPU_Budget_Record*   running = nullptr;
+static TaskHandle_t         enforcer = NULL;
+static TickType_t           window_ticks = 0;
+static TickType_t           window_elapsed = 0;
+static bool                 overrun = false;
+
+
+/*
+ * STATIC FUNCTIONS
+ */
+
+/**
+ * @brief Mark a task that has gone over its budget, once per window.
+ */
+static inline void check_budget(CPU_Budget_Record* record) {
+    if (record->state == BUDGET_OK && record->used_us > record->budget_us) {
+        record->state = BUDGET_OVER;
+        record->stats.violations++;
+        overrun = true;
+    }
+}
+
+
+/*
+ * TRACE AND TICK HOOKS
+ *
+ * The trace hooks are called by the kernel inside `vTaskSwitchContext()`,
+ * and the tick hook from the SysTick ISR, both with interrupts masked.
+ * `record` is null for tasks without a budget.
+ */
+extern "C" void cpu_budget_switched_in(void* record) {
+    running = (CPU_Budget_Record*)record;
+    if (running != nullptr) running->since_us = time_us_32();
+}
+
+extern "C" void cpu_budget_switched_out(void* record) {
+    CPU_Budget_Record* r = (CPU_Budget_Record*)record;
+    if (r != nullptr) {
+        r->used_us += time_us_32() - r->since_us;
+        check_budget(r);
+    }
+
+    running = nullptr;
+}
+
+extern "C" void vApplicationTickHook() {
+    if (enforcer == NULL) return;
+
+    // Charge the running task up to now
+    CPU_Budget_Record* r = running;
+    if (r != nullptr) {
+        const uint32_t now = time_us_32();
+        r->used_us += now - r->since_us;
+        r->since_us = now;
+        check_budget(r);
+    }
+
+    // Replenish every budget at the end of the window
+    bool wake = overrun;
+    overrun = false;
+    if (++window_elapsed >= window_ticks) {
+        window_elapsed = 0;
+        for (uint32_t i = 0 ; i < CPU_BUDGET_MAX_TASKS ; ++i) {
+            CPU_Budget_Record& record = records[i];
+            if (record.task == NULL) continue;
+
+            record.stats.windows++;
+            if (record.used_us > record.stats.max_used_us) record.stats.max_used_us = record.used_us;
+            record.used_us = 0;
+
+            if (record.state == BUDGET_OVER) {
+                // The enforcer hasn't reached it yet: nothing to undo
+                record.state = BUDGET_OK;
+            } else if (record.state == BUDGET_THROTTLED) {
+                record.state = BUDGET_RELEASE;
+                wake = true;
+            }
+        }
+    }
+
+    if (wake) vTaskNotifyGiveFromISR(enforcer, NULL);
+}
+
+
+/*
+ * ENFORCER
+ */
+
+/**
+ * @brief Throttle the tasks that have overrun, and restore those
+ *        whose window has ended. The tick hook wakes this task.
+ */
+static void task_enforcer(void* unused_arg) {
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        for (uint32_t i = 0 ; i < CPU_BUDGET_MAX_TASKS ; ++i) {
+            CPU_Budget_Record& record = records[i];
+
+            taskENTER_CRITICAL();
+            const TaskHandle_t task = record.task;
+            const uint8_t state = record.state;
+            if (state == BUDGET_OVER) record.state = BUDGET_THROTTLED;
+            if (state == BUDGET_RELEASE) record.state = BUDGET_OK;
+            taskEXIT_CRITICAL();
+
+            if (task == NULL) continue;
+
+            if (state == BUDGET_OVER) {
+                if (record.action == CPU_Budget_Action::SUSPEND) {
+                    vTaskSuspend(task);
+                } else {
+                    record.priority = uxTaskPriorityGet(task);
+                    vTaskPrioritySet(task, tskIDLE_PRIORITY);
+                }
+            } else if (state == BUDGET_RELEASE) {
+                if (record.action == CPU_Budget_Action::SUSPEND) {
+                    vTaskResume(task);
+                } else {
+                    vTaskPrioritySet(task, record.priority);
+                }
+            }
+        }
+    }
+}
+
+
+namespace CPU_Budget {
+
+/**
+ * @brief Start enforcing budgets.
+ *
+ * @param window_ms: The replenishment window: each budget is per window.
+ * @param priority:  The enforcer task's priority, above every budgeted task.
+ *
+ * @retval `true` if the enforcer is running, otherwise `false`.
+ */
+bool start(uint32_t window_ms, UBaseType_t priority) {
+    if (enforcer != NULL) return true;
+
+    window_ticks = pdMS_TO_TICKS(window_ms);
+    if (window_ticks == 0) window_ticks = 1;
+
+    TaskHandle_t handle = NULL;
+    if (xTaskCreate(task_enforcer, "BUDGET_TASK", CPU_BUDGET_STACK_DEPTH, NULL, priority, &handle) != pdPASS) return false;
+
+    taskENTER_CRITICAL();
+    enforcer = handle;
+    taskEXIT_CRITICAL();
+    return true;
+}
+
+
+/**
+ * @brief Give a task a CPU budget, or change its budget.
+ *
+ * @param task:      The task's handle, or NULL for the calling task.
+ * @param budget_us: The CPU time it may use per window.
+ * @param action:    What happens when it overruns. Default: demotion.
+ *
+ * @retval `true` if the budget is set, `false` if the table is full.
+ */
+bool set(TaskHandle_t task, uint32_t budget_us, CPU_Budget_Action action) {
+    if (task == NULL) task = xTaskGetCurrentTaskHandle();
+
+    taskENTER_CRITICAL();
+    CPU_Budget_Record* record = nullptr;
+    for (uint32_t i = 0 ; i < CPU_BUDGET_MAX_TASKS ; ++i) {
+        if (records[i].task == task) {
+            record = &records[i];
+            break;
+        }
+
+        if (record == nullptr && records[i].task == NULL) record = &records[i];
+    }
+
+    if (record == nullptr) {
+        taskEXIT_CRITICAL();
+        return false;
+    }
+
+    if (record->task != task) {
+        *record = {};
+        record->task = task;
+        record->since_us = time_us_32();
+        vTaskSetThreadLocalStoragePointer(task, CPU_BUDGET_TLS_INDEX, record);
+
+        // The calling task is already switched in, so charge it from now
+        if (xTaskGetSchedulerState() == taskSCHEDULER_RUNNING && task == xTaskGetCurrentTaskHandle()) running = record;
+    }
+
+    record->budget_us = budget_us;
+    record->action = action;
+    taskEXIT_CRITICAL();
+    return true;
+}
+
+
+/**
+ * @brief Take a task's budget away, restoring it if it is throttled.
+ *        Call before deleting a budgeted task.
+ *
+ * @param task: The task's handle, or NULL for the calling task.
+ */
+void remove(TaskHandle_t task) {
+    if (task == NULL) task = xTaskGetCurrentTaskHandle();
+
+    for (uint32_t i = 0 ; i < CPU_BUDGET_MAX_TASKS ; ++i) {
+        CPU_Budget_Record& record = records[i];
+        if (record.task != task) continue;
+
+        taskENTER_CRITICAL();
+        const bool throttled = record.state == BUDGET_THROTTLED || record.state == BUDGET_RELEASE;
+        vTaskSetThreadLocalStoragePointer(task, CPU_BUDGET_TLS_INDEX, NULL);
+        if (running == &record) running = nullptr;
+        record.task = NULL;
+        taskEXIT_CRITICAL();
+
+        if (throttled) {
+            if (record.action == CPU_Budget_Action::SUSPEND) {
+                vTaskResume(task);
+            } else {
+                vTaskPrioritySet(task, record.priority);
+            }
+        }
+
+        return;
+    }
+}
+
+
+/**
+ * @brief Get a copy of a task's budget statistics.
+ */
+CPU_Budget_Stats get_stats(TaskHandle_t task) {
+    CPU_Budget_Stats stats = {};
+    if (task == NULL) task = xTaskGetCurrentTaskHandle();
+
+    taskENTER_CRITICAL();
+    for (uint32_t i = 0 ; i < CPU_BUDGET_MAX_TASKS ; ++i) {
+        if (records[i].task == task) {
+            stats = records[i].stats;
+            break;
+        }
+    }
+
+    taskEXIT_CRITICAL();
+    return stats;
+}
+
+
+/**
+ * @brief Write every budget to STDIO, one CSV line per task:
+ *        `BUDGET,<task>,<budget_us>,<window_us>,<windows>,<violations>,<max_used_us>`
+ */
+void report() {
+    const uint32_t window_us = window_ticks * portTICK_PERIOD_MS * 1000;
+    for (uint32_t i = 0 ; i < CPU_BUDGET_MAX_TASKS ; ++i) {
+        const CPU_Budget_Record& record = records[i];
+        if (record.task == NULL) continue;
+
+        const CPU_Budget_Stats stats = get_stats(record.task);
+        printf("BUDGET,%s,%lu,%lu,%lu,%lu,%lu\n", pcTaskGetName(record.task), (unsigned long)record.budget_us,
+               (unsigned long)window_us, (unsigned long)stats.windows, (unsigned long)stats.violations, (unsigned long)stats.max_used_us);
+    }
+}
+
+}   // namespace CPU_Budget
+
+#endif  // configUSE_CPU_BUDGET
@@ -0,0 +1,103 @@
+/**
+ * RP2040 FreeRTOS Template - App #3
+ * Per-task CPU budgets, enforced from the tick hook
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#ifndef CPU_BUDGET_HEADER
+#define CPU_BUDGET_HEADER
+
+
+#include <cstdlib>
+#include <cstdint>
+// FreeRTOS
+#include <FreeRTOS.h>
+#include <task.h>
+
+
+/*
+ * CONSTANTS
+ */
+#define CPU_BUDGET_MAX_TASKS        8
+// The enforcer sits above every task it may throttle
+#define CPU_BUDGET_PRIORITY         (configMAX_PRIORITIES - 1)
+#define CPU_BUDGET_STACK_DEPTH      256
+
+
+/*
+ * TYPES
+ */
+// What happens to a task that overruns its budget, until the next window
+enum class CPU_Budget_Action : uint8_t {
+    DEMOTE,                         // Drop to the idle priority: it only gets spare time
+    SUSPEND                         // Stop it altogether
+};
+
+/**
+    Per-task budget statistics.
+ */
+struct CPU_Budget_Stats {
+    uint32_t    windows;
+    uint32_t    violations;         // Windows in which the task overran
+    uint32_t    max_used_us;        // The most CPU time taken in a window
+};
+
+
+#if configUSE_CPU_BUDGET
+
+/**
+    One task's budget. Time accrues only while the task is switched in.
+ */
+struct CPU_Budget_Record {
+    TaskHandle_t        task;
+    uint32_t            budget_us;
+    CPU_Budget_Action   action;
+    UBaseType_t         priority;   // To restore after demotion
+    CPU_Budget_Stats    stats;
+    // Working state, updated by the trace and tick hooks
+    uint32_t            since_us;
+    uint32_t            used_us;
+    uint8_t             state;
+};
+
+
+/*
+ * Each budgeted task may use `budget_us` of CPU time in every window
+ * of `window_ms`. The task-switch trace hooks charge tasks for the time
+ * they run; the tick hook charges the running task up to the moment and
+ * replenishes every budget at the end of each window. When a task goes
+ * over, the tick hook wakes an enforcer task, which demotes or suspends
+ * it. At the end of the window the enforcer puts the task back.
+ *
+ * Overruns are caught on a tick, so a task may run up to a tick over.
+ * Don't budget a task that changes its own priority or suspends itself,
+ * or that the EDF supervisor ranks: the enforcer would undo it.
+ */
+namespace CPU_Budget {
+    bool                start(uint32_t window_ms, UBaseType_t priority = CPU_BUDGET_PRIORITY);
+    bool                set(TaskHandle_t task, uint32_t budget_us, CPU_Budget_Action action = CPU_Budget_Action::DEMOTE);
+    void                remove(TaskHandle_t task);
+
+    CPU_Budget_Stats    get_stats(TaskHandle_t task);
+    void                report();
+}
+
+#else
+
+// Budgets compile away when the hooks are not built
+namespace CPU_Budget {
+    inline bool                 start(uint32_t window_ms, UBaseType_t priority = CPU_BUDGET_PRIORITY) { return false; }
+    inline bool                 set(TaskHandle_t task, uint32_t budget_us, CPU_Budget_Action action = CPU_Budget_Action::DEMOTE) { return false; }
+    inline void                 remove(TaskHandle_t task) {}
+
+    inline CPU_Budget_Stats     get_stats(TaskHandle_t task) { return {}; }
+    inline void                 report() {}
+}
+
+#endif  // configUSE_CPU_BUDGET
+
+
+#endif  // CPU_BUDGET_HEADER
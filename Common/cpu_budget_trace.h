@@ -0,0 +1,50 @@
+/**
+ * RP2040 FreeRTOS Template - App #3
+ * FreeRTOS trace hooks for per-task CPU budgets
+ *
+ * Included by FreeRTOSConfig.h, so it is seen by the kernel's C sources:
+ * keep it C and free of SDK headers.
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#ifndef CPU_BUDGET_TRACE_HEADER
+#define CPU_BUDGET_TRACE_HEADER
+
+
+/*
+ * CONSTANTS
+ */
+// The thread-local storage slot that holds each task's budget record:
+// the one after the WCET record's, if that is built
+#if configUSE_WCET_TRACE
+#define CPU_BUDGET_TLS_INDEX        (WCET_TLS_INDEX + 1)
+#else
+#define CPU_BUDGET_TLS_INDEX        0
+#endif
+
+
+#ifndef __ASSEMBLER__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void cpu_budget_switched_in(void* record);
+void cpu_budget_switched_out(void* record);
+
+#ifdef __cplusplus
+}
+#endif
+
+// Expanded inside tasks.c, where `pxCurrentTCB` is in scope. FreeRTOSConfig.h
+// calls these from `traceTASK_SWITCHED_IN()` and `traceTASK_SWITCHED_OUT()`
+#define CPU_BUDGET_SWITCHED_IN()    cpu_budget_switched_in(pxCurrentTCB->pvThreadLocalStoragePointers[CPU_BUDGET_TLS_INDEX])
+#define CPU_BUDGET_SWITCHED_OUT()   cpu_budget_switched_out(pxCurrentTCB->pvThreadLocalStoragePointers[CPU_BUDGET_TLS_INDEX])
+
+#endif  // __ASSEMBLER__
+
+
+#endif  // CPU_BUDGET_TRACE_HEADER
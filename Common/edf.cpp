@@ -0,0 +1,211 @@
+/**
+ * RP2040 FreeRTOS Template - App #2
+ * Earliest-deadline-first scheduling over FreeRTOS priorities
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#include "edf.h"
+
+
+/**
+ * @brief Constructor: instantiate a supervisor with no tasks.
+ */
+EDF_Supervisor::EDF_Supervisor() {
+    count = 0;
+    handle = NULL;
+    running = false;
+}
+
+
+/**
+ * @brief Declare a periodic task. Call before `start()`.
+ *
+ * @param period:   The release period in ticks.
+ * @param deadline: The deadline in ticks after each release.
+ *
+ * @retval The task's index, for its calls to `wait_release()` and
+ *         `complete()`, or -1 if the table is full.
+ */
+int EDF_Supervisor::add(TickType_t period, TickType_t deadline) {
+    if (count >= EDF_MAX_TASKS || running) return -1;
+
+    Job& job = jobs[count];
+    job.task = NULL;
+    job.period = period;
+    job.deadline = deadline;
+    job.next_release = 0;
+    job.abs_deadline = 0;
+    job.priority = EDF_PRIORITY_LOWEST;
+    job.active = false;
+    job.missed = false;
+    job.stats = {0, 0, 0};
+    return (int)count++;
+}
+
+
+/**
+ * @brief Start the supervisor task. The first jobs are released at once.
+ *
+ * @param priority: The supervisor's priority. Default: EDF_SUPERVISOR_PRIORITY.
+ *
+ * @retval `true` if the supervisor was started, otherwise `false`.
+ */
+bool EDF_Supervisor::start(UBaseType_t priority) {
+    const TickType_t now = xTaskGetTickCount();
+    for (uint32_t i = 0 ; i < count ; ++i) jobs[i].next_release = now;
+
+    running = true;
+    if (xTaskCreate(run, "EDF_SUPERVISOR", EDF_SUPERVISOR_STACK_DEPTH, this, priority, &handle) != pdPASS) {
+        running = false;
+        return false;
+    }
+
+    return true;
+}
+
+
+/**
+ * @brief Stop releasing jobs and delete the supervisor task. The tasks
+ *        keep their current priorities.
+ */
+void EDF_Supervisor::stop() {
+    running = false;
+    if (handle != NULL) {
+        vTaskDelete(handle);
+        handle = NULL;
+    }
+}
+
+
+/**
+ * @brief Block the calling task until its next job is released.
+ *        The first call also registers the task.
+ *
+ * @param index: The task's index, from `add()`.
+ */
+void EDF_Supervisor::wait_release(int index) {
+    if (jobs[index].task == NULL) {
+        jobs[index].task = xTaskGetCurrentTaskHandle();
+        if (handle != NULL) xTaskNotifyGive(handle);
+    }
+
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+}
+
+
+/**
+ * @brief Mark the calling task's current job complete, recording whether
+ *        it met its deadline, and have the others re-ranked.
+ *
+ * @param index: The task's index, from `add()`.
+ */
+void EDF_Supervisor::complete(int index) {
+    Job& job = jobs[index];
+    const TickType_t now = xTaskGetTickCount();
+
+    taskENTER_CRITICAL();
+    const TickType_t late = now - job.abs_deadline;
+    if ((int32_t)late > 0) {
+        if (!job.missed) job.stats.misses++;
+        if (late > job.stats.max_lateness) job.stats.max_lateness = late;
+    }
+
+    job.stats.jobs++;
+    job.active = false;
+    job.missed = false;
+    taskEXIT_CRITICAL();
+
+    if (handle != NULL) xTaskNotifyGive(handle);
+}
+
+
+/**
+ * @brief Get a task's deadline statistics.
+ *
+ * @param index: The task's index, from `add()`.
+ */
+EDF_Stats EDF_Supervisor::get_stats(int index) const {
+    return jobs[index].stats;
+}
+
+
+void EDF_Supervisor::run(void* supervisor) {
+    ((EDF_Supervisor*)supervisor)->loop();
+}
+
+
+/**
+ * @brief The supervisor loop: release due jobs, re-rank, then sleep until
+ *        the next release or a completion.
+ */
+void EDF_Supervisor::loop() {
+    while (running) {
+        const TickType_t now = xTaskGetTickCount();
+        TickType_t wait = portMAX_DELAY;
+
+        for (uint32_t i = 0 ; i < count ; ++i) {
+            Job& job = jobs[i];
+
+            // A job still running at its deadline has missed it:
+            // count it now, so an overrun is seen while it happens
+            if (job.active && !job.missed && (int32_t)(now - job.abs_deadline) > 0) {
+                taskENTER_CRITICAL();
+                job.missed = true;
+                job.stats.misses++;
+                taskEXIT_CRITICAL();
+            }
+
+            // Release the next job once the last one is done. An overrun
+            // delays the release; missed periods are skipped, not queued
+            if (!job.active && job.task != NULL && (int32_t)(now - job.next_release) >= 0) {
+                job.active = true;
+                job.abs_deadline = job.next_release + job.deadline;
+                while ((int32_t)(now - job.next_release) >= 0) job.next_release += job.period;
+                xTaskNotifyGive(job.task);
+            }
+
+            // Sleep until the next release or deadline check
+            const TickType_t until = job.active ? job.abs_deadline + 1 - now : job.next_release - now;
+            if ((int32_t)until > 0 && until < wait) wait = until;
+        }
+
+        rank();
+        ulTaskNotifyTake(pdTRUE, wait);
+    }
+
+    vTaskDelete(NULL);
+}
+
+
+/**
+ * @brief Give the active jobs priority bands by absolute deadline.
+ */
+void EDF_Supervisor::rank() {
+    bool ranked[EDF_MAX_TASKS] = {false};
+    UBaseType_t band = EDF_PRIORITY_HIGHEST;
+
+    while (true) {
+        // Earliest unranked deadline. Compare relative to now, so tick
+        // count wrap-around doesn't invert the order
+        const TickType_t now = xTaskGetTickCount();
+        int best = -1;
+        for (uint32_t i = 0 ; i < count ; ++i) {
+            if (!jobs[i].active || ranked[i]) continue;
+            if (best < 0 || (int32_t)(jobs[i].abs_deadline - now) < (int32_t)(jobs[best].abs_deadline - now)) best = (int)i;
+        }
+
+        if (best < 0) break;
+
+        ranked[best] = true;
+        Job& job = jobs[best];
+        if (job.priority != band) {
+            job.priority = band;
+            vTaskPrioritySet(job.task, band);
+        }
+
+        if (band > EDF_PRIORITY_LOWEST) band--;
+    }
+}
@@ -0,0 +1,93 @@
+/**
+ * RP2040 FreeRTOS Template - App #2
+ * Earliest-deadline-first scheduling over FreeRTOS priorities
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#ifndef EDF_HEADER
+#define EDF_HEADER
+
+
+#include <cstdlib>
+#include <cstdint>
+// FreeRTOS
+#include <FreeRTOS.h>
+#include <task.h>
+// Pico SDK
+#include "pico/stdlib.h"
+
+
+/*
+ * CONSTANTS
+ */
+#define EDF_MAX_TASKS               8
+// The supervisor sits above the bands it hands out, so it can always
+// preempt a running job to re-rank the others
+#define EDF_SUPERVISOR_PRIORITY     (configMAX_PRIORITIES - 1)
+#define EDF_PRIORITY_HIGHEST        (configMAX_PRIORITIES - 2)
+#define EDF_PRIORITY_LOWEST         1
+#define EDF_SUPERVISOR_STACK_DEPTH  256
+
+
+/**
+    Per-task deadline statistics.
+ */
+struct EDF_Stats {
+    uint32_t    jobs;
+    uint32_t    misses;
+    TickType_t  max_lateness;
+};
+
+
+/**
+    Runs periodic tasks earliest-deadline-first. Each task declares its
+    period and relative deadline, then loops on `wait_release()`, its job,
+    then `complete()`. A supervisor task releases each job on time and, at
+    every release and completion, ranks the active jobs by absolute
+    deadline: the earliest gets EDF_PRIORITY_HIGHEST, the next the band
+    below, and so on down to EDF_PRIORITY_LOWEST, which the rest share.
+    With configMAX_PRIORITIES at 5 there are three bands, so ordering is
+    exact for up to three active jobs.
+ */
+class EDF_Supervisor {
+
+    public:
+        EDF_Supervisor();
+
+        int             add(TickType_t period, TickType_t deadline);
+        bool            start(UBaseType_t priority = EDF_SUPERVISOR_PRIORITY);
+        void            stop();
+
+        void            wait_release(int index);
+        void            complete(int index);
+
+        EDF_Stats       get_stats(int index) const;
+
+    private:
+        struct Job {
+            TaskHandle_t    task;
+            TickType_t      period;
+            TickType_t      deadline;
+            TickType_t      next_release;
+            TickType_t      abs_deadline;
+            UBaseType_t     priority;
+            bool            active;
+            bool            missed;
+            EDF_Stats       stats;
+        };
+
+        static void     run(void* supervisor);
+        void            loop();
+        void            rank();
+
+        Job             jobs[EDF_MAX_TASKS];
+        uint32_t        count;
+        TaskHandle_t    handle;
+        volatile bool   running;
+};
+
+
+#endif  // EDF_HEADER
@@ -0,0 +1,337 @@
+/**
+ * RP2040 FreeRTOS Template - App #2
+ * Q-format fixed-point arithmetic backed by the SIO divider and interpolators
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#ifndef FIXED_HEADER
+#define FIXED_HEADER
+
+
+#include <cstdlib>
+#include <cstdint>
+#include <cstddef>
+
+
+/*
+ * CONSTANTS
+ */
+// On the RP2040, use the SIO hardware divider and interpolators.
+// Elsewhere, eg. host-side tests and benchmarks, fall back to plain C++
+#if defined(PICO_ON_DEVICE) && PICO_ON_DEVICE
+#define FIXED_ON_TARGET             1
+#else
+#define FIXED_ON_TARGET             0
+#endif
+
+#if FIXED_ON_TARGET
+// Pico SDK
+#include "pico/stdlib.h"
+#include "pico/divider.h"
+#include "hardware/interp.h"
+#include "hardware/sync.h"
+#endif
+
+
+/*
+ * PRIMITIVES
+ */
+namespace FixedMath {
+
+/**
+ * @brief Signed 32-bit division returning quotient and remainder,
+ *        both truncated toward zero as per C.
+ *
+ *        The kernel doesn't save the SIO divider on a context switch, so
+ *        use the SDK's wrappers, which save and restore it if a division
+ *        was in progress, rather than driving it directly.
+ */
+inline int32_t divmod_s32(int32_t a, int32_t b, int32_t* remainder) {
+#if FIXED_ON_TARGET
+    const divmod_result_t result = divmod_s32s32(a, b);
+    *remainder = to_remainder_s32(result);
+    return to_quotient_s32(result);
+#else
+    *remainder = a % b;
+    return a / b;
+#endif
+}
+
+/**
+ * @brief Unsigned 32-bit division returning quotient and remainder.
+ */
+inline uint32_t divmod_u32(uint32_t a, uint32_t b, uint32_t* remainder) {
+#if FIXED_ON_TARGET
+    const divmod_result_t result = divmod_u32u32(a, b);
+    *remainder = to_remainder_u32(result);
+    return to_quotient_u32(result);
+#else
+    *remainder = a % b;
+    return a / b;
+#endif
+}
+
+/**
+ * @brief `(a * b) >> shift` with a 64-bit intermediate, rounding toward
+ *        minus infinity. Shift must be 1-31.
+ *
+ *        The M0+ has a single-cycle 32x32->32 multiplier but no long
+ *        multiply, so on target the product is built from four 16x16
+ *        partial products rather than calling `__aeabi_lmul`.
+ */
+inline int32_t mul_shift(int32_t a, int32_t b, uint32_t shift) {
+#if FIXED_ON_TARGET
+    const bool negative = (a < 0) != (b < 0);
+    const uint32_t ua = a < 0 ? 0 - (uint32_t)a : (uint32_t)a;
+    const uint32_t ub = b < 0 ? 0 - (uint32_t)b : (uint32_t)b;
+    const uint32_t al = ua & 0xFFFF, ah = ua >> 16;
+    const uint32_t bl = ub & 0xFFFF, bh = ub >> 16;
+
+    const uint32_t mid_a = ah * bl;
+    const uint32_t mid = mid_a + al * bh;
+    const uint32_t lo_part = al * bl;
+    uint32_t lo = lo_part + (mid << 16);
+    uint32_t hi = ah * bh + (mid >> 16) + (mid < mid_a ? 0x10000 : 0) + (lo < lo_part ? 1 : 0);
+
+    if (negative) {
+        lo = ~lo + 1;
+        hi = ~hi + (lo == 0 ? 1 : 0);
+    }
+
+    return (int32_t)((lo >> shift) | (hi << (32 - shift)));
+#else
+    return (int32_t)(((int64_t)a * b) >> shift);
+#endif
+}
+
+/**
+ * @brief `(a << shift) / b`, truncated toward zero. Shift must be 0-31.
+ *
+ *        Computed as two 32-bit divisions when the remainder can be
+ *        shifted without overflow, so that both run on the SIO divider.
+ */
+inline int32_t div_shift(int32_t a, int32_t b, uint32_t shift) {
+    const uint32_t ub = b < 0 ? 0 - (uint32_t)b : (uint32_t)b;
+    if (ub <= (0x7FFFFFFFu >> shift)) {
+        int32_t remainder = 0;
+        const int32_t quotient = divmod_s32(a, b, &remainder);
+        int32_t unused = 0;
+        return (int32_t)((uint32_t)quotient << shift) + divmod_s32((int32_t)((uint32_t)remainder << shift), b, &unused);
+    }
+
+    return (int32_t)(((int64_t)a * ((int64_t)1 << shift)) / b);
+}
+
+/**
+ * @brief Sign-extend bits `lsb` to `msb` of `word` and add `base`:
+ *        a single pass through interpolator 1, lane 0, on target.
+ */
+inline int32_t extract_signed(uint32_t word, uint32_t lsb, uint32_t msb, int32_t base) {
+#if FIXED_ON_TARGET
+    // The interpolator isn't saved across context switches or
+    // interrupts, so keep it to ourselves while we use it
+    const uint32_t status = save_and_disable_interrupts();
+    interp_config cfg = interp_default_config();
+    interp_config_set_shift(&cfg, lsb);
+    interp_config_set_mask(&cfg, 0, msb - lsb);
+    interp_config_set_signed(&cfg, true);
+    interp_set_config(interp1, 0, &cfg);
+    interp1->accum[0] = word;
+    interp1->base[0] = (uint32_t)base;
+    const int32_t result = (int32_t)interp1->peek[0];
+    restore_interrupts(status);
+    return result;
+#else
+    const uint32_t width = msb - lsb + 1;
+    const uint32_t field = (word >> lsb) & (width >= 32 ? 0xFFFFFFFF : ((1u << width) - 1));
+    const uint32_t sign = 1u << (width - 1);
+    return (int32_t)((field ^ sign) - sign) + base;
+#endif
+}
+
+/**
+ * @brief Linear blend `a + (b - a) * alpha / 256` for an 8-bit alpha:
+ *        interpolator 0's blend mode on target.
+ */
+inline int32_t blend(int32_t a, int32_t b, uint32_t alpha) {
+#if FIXED_ON_TARGET
+    const uint32_t status = save_and_disable_interrupts();
+    interp_config cfg = interp_default_config();
+    interp_config_set_blend(&cfg, true);
+    interp_set_config(interp0, 0, &cfg);
+    cfg = interp_default_config();
+    interp_config_set_signed(&cfg, true);
+    interp_set_config(interp0, 1, &cfg);
+    interp0->base[0] = (uint32_t)a;
+    interp0->base[1] = (uint32_t)b;
+    interp0->accum[1] = alpha & 0xFF;
+    const int32_t result = (int32_t)interp0->peek[1];
+    restore_interrupts(status);
+    return result;
+#else
+    return a + (int32_t)(((int64_t)(b - a) * (int32_t)(alpha & 0xFF)) >> 8);
+#endif
+}
+
+}   // namespace FixedMath
+
+
+/**
+    A signed Q-format fixed-point number with FRAC fraction bits held
+    in 32 bits, eg. `Fixed<4>` is Q27.4, the MCP9808's native format.
+ */
+template <uint32_t FRAC>
+class Fixed {
+
+    static_assert(FRAC < 31, "Fixed<FRAC>: at least one integer bit is required");
+
+    public:
+        static constexpr uint32_t   FRACTION_BITS = FRAC;
+        static constexpr int32_t    ONE = (int32_t)1 << FRAC;
+
+        constexpr Fixed() : raw(0) {}
+
+        static constexpr Fixed from_raw(int32_t value)  { Fixed f; f.raw = value; return f; }
+        static constexpr Fixed from_int(int32_t value)  { return from_raw(value * ONE); }
+
+        /**
+         * @brief Convert from a fraction `numerator / denominator`,
+         *        eg. `Fixed<8>::from_ratio(706, 1000)` for 0.706.
+         */
+        static Fixed from_ratio(int32_t numerator, int32_t denominator) {
+            return from_raw(FixedMath::div_shift(numerator, denominator, FRAC));
+        }
+
+        /**
+         * @brief Convert a signed bit field with SRC_FRAC fraction bits,
+         *        eg. a sensor register, in a single interpolator pass.
+         */
+        template <uint32_t LSB, uint32_t MSB, uint32_t SRC_FRAC>
+        static Fixed from_field(uint32_t word) {
+            static_assert(MSB >= LSB && MSB < 32, "Fixed::from_field: bad field");
+            const int32_t value = FixedMath::extract_signed(word, LSB, MSB, 0);
+            if constexpr (SRC_FRAC > FRAC) {
+                return from_raw(value >> (SRC_FRAC - FRAC));
+            } else {
+                return from_raw(value * ((int32_t)1 << (FRAC - SRC_FRAC)));
+            }
+        }
+
+        /**
+         * @brief Change format, eg. Q27.4 to Q23.8.
+         */
+        template <uint32_t TO_FRAC>
+        constexpr Fixed<TO_FRAC> convert() const {
+            if constexpr (TO_FRAC > FRAC) {
+                return Fixed<TO_FRAC>::from_raw(raw * ((int32_t)1 << (TO_FRAC - FRAC)));
+            } else {
+                return Fixed<TO_FRAC>::from_raw(raw >> (FRAC - TO_FRAC));
+            }
+        }
+
+        // Integer part, rounded toward minus infinity, and nearest integer
+        constexpr int32_t   to_int() const          { return raw >> FRAC; }
+        constexpr int32_t   round() const           { return (raw + (ONE >> 1)) >> FRAC; }
+        constexpr uint32_t  fraction() const        { return (uint32_t)raw & (ONE - 1); }
+
+        // For logging only: pulls in soft-float on target
+        double              to_double() const       { return (double)raw / ONE; }
+
+        constexpr Fixed     operator-() const               { return from_raw(-raw); }
+        constexpr Fixed     operator+(Fixed other) const    { return from_raw(raw + other.raw); }
+        constexpr Fixed     operator-(Fixed other) const    { return from_raw(raw - other.raw); }
+        Fixed&              operator+=(Fixed other)         { raw += other.raw; return *this; }
+        Fixed&              operator-=(Fixed other)         { raw -= other.raw; return *this; }
+
+        Fixed operator*(Fixed other) const {
+            if constexpr (FRAC == 0) return from_raw(raw * other.raw);
+            else return from_raw(FixedMath::mul_shift(raw, other.raw, FRAC));
+        }
+
+        Fixed operator/(Fixed other) const {
+            return from_raw(FixedMath::div_shift(raw, other.raw, FRAC));
+        }
+
+        constexpr Fixed operator*(int32_t scalar) const { return from_raw(raw * scalar); }
+
+        Fixed operator/(int32_t scalar) const {
+            int32_t unused = 0;
+            return from_raw(FixedMath::divmod_s32(raw, scalar, &unused));
+        }
+
+        constexpr bool      operator==(Fixed other) const   { return raw == other.raw; }
+        constexpr bool      operator!=(Fixed other) const   { return raw != other.raw; }
+        constexpr bool      operator<(Fixed other) const    { return raw < other.raw; }
+        constexpr bool      operator<=(Fixed other) const   { return raw <= other.raw; }
+        constexpr bool      operator>(Fixed other) const    { return raw > other.raw; }
+        constexpr bool      operator>=(Fixed other) const   { return raw >= other.raw; }
+
+        /**
+         * @brief Write the value as decimal text, eg. `-12.34`, truncated
+         *        to the requested number of decimal places (max. 9).
+         *
+         * @retval The number of characters written, excluding the NUL.
+         */
+        size_t to_chars(char* buffer, size_t size, uint32_t decimals) const {
+            char digits[24];
+            size_t count = 0;
+
+            // Scale to an integer number of 10^-decimals units
+            uint32_t scale = 1;
+            for (uint32_t i = 0 ; i < decimals ; ++i) scale *= 10;
+            const bool negative = raw < 0;
+            const uint32_t magnitude = negative ? 0 - (uint32_t)raw : (uint32_t)raw;
+            uint32_t units = (magnitude >> FRAC) * scale + (uint32_t)(((uint64_t)(magnitude & (ONE - 1)) * scale) >> FRAC);
+            const bool show_sign = negative && units > 0;
+
+            // Peel off digits with the divider, least significant first
+            do {
+                uint32_t digit = 0;
+                units = FixedMath::divmod_u32(units, 10, &digit);
+                digits[count++] = (char)('0' + digit);
+                if (count == decimals) digits[count++] = '.';
+            } while (units > 0 || (decimals > 0 && count <= decimals + 1));
+
+            if (show_sign) digits[count++] = '-';
+
+            size_t written = 0;
+            while (count > 0 && written + 1 < size) buffer[written++] = digits[--count];
+            if (size > 0) buffer[written] = 0;
+            return written;
+        }
+
+        int32_t raw;
+};
+
+
+/**
+    A lookup table of N + 1 samples spread evenly over [0, N << STEP_BITS),
+    read with linear interpolation between neighbouring entries. The
+    interpolation weight has eight bits of precision, the width of the
+    RP2040 interpolator's blend alpha.
+ */
+template <uint32_t FRAC, size_t N, uint32_t STEP_BITS>
+class Fixed_Lut {
+
+    static_assert(STEP_BITS >= 8, "Fixed_Lut: the step must span at least 8 bits");
+
+    public:
+        constexpr Fixed_Lut(const int32_t (&samples)[N + 1]) : table(samples) {}
+
+        Fixed<FRAC> lookup(int32_t x) const {
+            if (x <= 0) return Fixed<FRAC>::from_raw(table[0]);
+            const uint32_t index = (uint32_t)x >> STEP_BITS;
+            if (index >= N) return Fixed<FRAC>::from_raw(table[N]);
+            const uint32_t alpha = ((uint32_t)x >> (STEP_BITS - 8)) & 0xFF;
+            return Fixed<FRAC>::from_raw(FixedMath::blend(table[index], table[index + 1], alpha));
+        }
+
+    private:
+        const int32_t (&table)[N + 1];
+};
+
+
+#endif  // FIXED_HEADER
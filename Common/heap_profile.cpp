@@ -0,0 +1,412 @@
+/**
+ * RP2040 FreeRTOS Template - App #3
+ * Per-call-site heap allocation profiling
+ *
+ * Built into the FreeRTOS library when the project is configured
+ * with `-DHEAP_PROFILE=ON`, which also wraps `operator new` and
+ * `operator delete` at link time, as the Pico SDK wraps `malloc()`.
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#include "heap_profile.h"
+#include <cstring>
+#include <new>
+#include <malloc.h>
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+
+
+#if configUSE_HEAP_PROFILE
+
+// The wrapped symbols are mangled for a 32-bit `size_t`
+static_assert(sizeof(size_t) == 4, "Heap_Profile wraps the 32-bit operator new symbols");
+
+
+/*
+ * CONSTANTS
+ */
+#define HEAP_PROFILE_NO_SITE        0xFFFF
+// Tags the header of each profiled block
+#define HEAP_PROFILE_TAG            0x4850
+// The single-core kernel port takes neither OS spin lock. The SMP
+// port takes both for its kernel locks, so would collide with this
+#define HEAP_PROFILE_SPIN_LOCK      PICO_SPINLOCK_ID_OS2
+
+
+/*
+ * TYPES
+ */
+// Precedes each block from `operator new`. Eight bytes, so the
+// block keeps the allocator's alignment
+struct Block_Header {
+    uint32_t    size;
+    uint16_t    site;
+    uint16_t    tag;
+};
+
+// A kernel block, held until `vPortFree()` so its free can be charged
+struct Kernel_Block {
+    void*       block;
+    uint32_t    size;
+    uint16_t    site;
+};
+
+
+/*
+ * GLOBALS
+ */
+static Heap_Site            sites[HEAP_PROFILE_MAX_SITES];
+static Kernel_Block         blocks[HEAP_PROFILE_MAX_BLOCKS];
+static Heap_Profile_Totals  totals;
+static uint32_t             untracked = 0;
+static uint64_t             reported_us = 0;
+
+// The linker's bounds of the code in flash
+extern "C" char             __logical_binary_start[];
+extern "C" char             __etext[];
+
+
+/*
+ * STATIC FUNCTIONS
+ */
+
+static inline uint32_t lock() {
+    return spin_lock_blocking(spin_lock_instance(HEAP_PROFILE_SPIN_LOCK));
+}
+
+static inline void unlock(uint32_t state) {
+    spin_unlock(spin_lock_instance(HEAP_PROFILE_SPIN_LOCK), state);
+}
+
+
+/**
+ * @brief Is a stack word a return address: an odd (Thumb) address in
+ *        flash code that follows a `BL` or a `BLX`?
+ */
+static bool is_return_address(uint32_t word) {
+    if ((word & 1) == 0) return false;
+
+    const uint32_t address = word & ~1u;
+    if (address < (uintptr_t)__logical_binary_start + 4 || address >= (uintptr_t)__etext) return false;
+
+    const uint16_t* code = (const uint16_t*)(uintptr_t)address;
+    if ((code[-2] & 0xF800) == 0xF000 && (code[-1] & 0xD000) == 0xD000) return true;
+    return (code[-1] & 0xFF87) == 0x4780;
+}
+
+
+/**
+ * @brief Fill in the call chain behind an allocation. There are no frame
+ *        pointers to follow, so scan the stack above the allocator's
+ *        frame for return addresses, starting with the one it was called
+ *        with. A stale word can pass for a return address, so the outer
+ *        frames are a good guide rather than a certainty.
+ */
+static void __attribute__((noinline)) get_frames(uint32_t* frames, uint32_t site) {
+    frames[0] = site & ~1u;
+    uint32_t count = 1;
+
+    volatile uint32_t marker = 0;
+    const uint32_t* word = (const uint32_t*)&marker;
+    const uint32_t* end = word + HEAP_PROFILE_SCAN_WORDS;
+    if ((uintptr_t)end > SRAM_END) end = (const uint32_t*)SRAM_END;
+
+    bool found = false;
+    for ( ; word < end && count < HEAP_PROFILE_FRAMES ; ++word) {
+        if (!found) {
+            found = (*word | 1) == (site | 1);
+        } else if (is_return_address(*word)) {
+            frames[count++] = *word & ~1u;
+        }
+    }
+
+    while (count < HEAP_PROFILE_FRAMES) frames[count++] = 0;
+}
+
+
+/**
+ * @brief Identify the allocating context: the task, or `main` before
+ *        the scheduler starts, `isr` or `core1`.
+ */
+static TaskHandle_t get_task(const char** name) {
+    if (get_core_num() != 0) {
+        *name = "core1";
+        return NULL;
+    }
+
+    if (__get_current_exception() != 0) {
+        *name = "isr";
+        return NULL;
+    }
+
+    if (xTaskGetSchedulerState() == taskSCHEDULER_NOT_STARTED) {
+        *name = "main";
+        return NULL;
+    }
+
+    TaskHandle_t task = xTaskGetCurrentTaskHandle();
+    *name = pcTaskGetName(task);
+    return task;
+}
+
+
+/**
+ * @brief Hash a site's call chain and task into the 32-bit key its
+ *        probe compares. The name tells apart the contexts that have
+ *        no task handle.
+ */
+static uint32_t get_key(const uint32_t* frames, TaskHandle_t task, const char* name) {
+    uint32_t key = 2166136261u;
+    for (uint32_t i = 0 ; i < HEAP_PROFILE_FRAMES ; ++i) key = (key ^ frames[i]) * 16777619u;
+    key = (key ^ (uint32_t)(uintptr_t)task) * 16777619u;
+    for (uint32_t i = 0 ; i < HEAP_PROFILE_NAME_LEN - 1 && name[i] != 0 ; ++i) key = (key ^ (uint8_t)name[i]) * 16777619u;
+    return key ^ (key >> 16);
+}
+
+
+/**
+ * @brief Charge an allocation to its site, adding the site if it is new.
+ *
+ * @retval The site's index, or `HEAP_PROFILE_NO_SITE` if the table is full.
+ */
+static uint16_t __attribute__((noinline)) record_alloc(uint32_t size, uint32_t site) {
+    uint32_t frames[HEAP_PROFILE_FRAMES];
+    get_frames(frames, site);
+
+    const char* name = nullptr;
+    TaskHandle_t task = get_task(&name);
+
+    // Open addressing on a key hashed before the lock is taken, so each
+    // probe with interrupts masked is one word compare. The full record
+    // is compared only when the key matches
+    const uint32_t key = get_key(frames, task, name);
+    uint32_t index = key % HEAP_PROFILE_MAX_SITES;
+
+    const uint32_t state = lock();
+    totals.allocs++;
+    totals.live_bytes += size;
+    if (totals.live_bytes > totals.peak_bytes) totals.peak_bytes = totals.live_bytes;
+
+    for (uint32_t probe = 0 ; probe < HEAP_PROFILE_MAX_SITES ; ++probe) {
+        Heap_Site& record = sites[index];
+        if (record.allocs == 0) {
+            memcpy(record.frames, frames, sizeof(frames));
+            record.key = key;
+            record.task = task;
+            strncpy(record.name, name, HEAP_PROFILE_NAME_LEN - 1);
+            totals.sites++;
+        } else if (record.key != key || record.task != task || memcmp(record.frames, frames, sizeof(frames)) != 0
+                   || strncmp(record.name, name, HEAP_PROFILE_NAME_LEN - 1) != 0) {
+            index = (index + 1) % HEAP_PROFILE_MAX_SITES;
+            continue;
+        }
+
+        record.allocs++;
+        record.bytes += size;
+        record.live_bytes += size;
+        unlock(state);
+        return (uint16_t)index;
+    }
+
+    totals.dropped++;
+    unlock(state);
+    return HEAP_PROFILE_NO_SITE;
+}
+
+
+static void record_free(uint16_t site, uint32_t size) {
+    const uint32_t state = lock();
+    totals.frees++;
+    totals.live_bytes -= size;
+    if (site != HEAP_PROFILE_NO_SITE) {
+        sites[site].frees++;
+        sites[site].live_bytes -= size;
+    }
+
+    unlock(state);
+}
+
+
+/*
+ * OPERATOR NEW AND DELETE
+ *
+ * `-DHEAP_PROFILE=ON` links with `--wrap` for each of these symbols,
+ * so every caller reaches the `__wrap_` function, which calls on to
+ * the original through `__real_`. Aligned `new` and `delete` are left
+ * to the library: they allocate and free through `aligned_alloc()`.
+ */
+extern "C" {
+    void*   __real__Znwj(size_t size);
+    void    __real__ZdlPv(void* block);
+}
+
+static void* __attribute__((noinline)) profiled_new(size_t size, void* site) {
+    Block_Header* header = (Block_Header*)__real__Znwj(size + sizeof(Block_Header));
+    if (header == nullptr) return nullptr;
+
+    header->size = size;
+    header->site = record_alloc(size, (uint32_t)(uintptr_t)site);
+    header->tag = HEAP_PROFILE_TAG;
+    return header + 1;
+}
+
+static void profiled_delete(void* block) {
+    if (block == nullptr) return;
+
+    Block_Header* header = (Block_Header*)block - 1;
+    assert(header->tag == HEAP_PROFILE_TAG);
+    record_free(header->site, header->size);
+    __real__ZdlPv(header);
+}
+
+extern "C" {
+    void* __wrap__Znwj(size_t size) {
+        return profiled_new(size, __builtin_return_address(0));
+    }
+
+    void* __wrap__Znaj(size_t size) {
+        return profiled_new(size, __builtin_return_address(0));
+    }
+
+    void* __wrap__ZnwjRKSt9nothrow_t(size_t size, const std::nothrow_t& unused_tag) {
+        return profiled_new(size, __builtin_return_address(0));
+    }
+
+    void* __wrap__ZnajRKSt9nothrow_t(size_t size, const std::nothrow_t& unused_tag) {
+        return profiled_new(size, __builtin_return_address(0));
+    }
+
+    void __wrap__ZdlPv(void* block) {
+        profiled_delete(block);
+    }
+
+    void __wrap__ZdaPv(void* block) {
+        profiled_delete(block);
+    }
+
+    void __wrap__ZdlPvj(void* block, size_t unused_size) {
+        profiled_delete(block);
+    }
+
+    void __wrap__ZdaPvj(void* block, size_t unused_size) {
+        profiled_delete(block);
+    }
+
+    void __wrap__ZdlPvRKSt9nothrow_t(void* block, const std::nothrow_t& unused_tag) {
+        profiled_delete(block);
+    }
+
+    void __wrap__ZdaPvRKSt9nothrow_t(void* block, const std::nothrow_t& unused_tag) {
+        profiled_delete(block);
+    }
+}
+
+
+/*
+ * TRACE HOOKS
+ *
+ * Called by the kernel from `pvPortMalloc()` and `vPortFree()`, with the
+ * scheduler suspended. Kernel blocks have no header, so each is held in
+ * `blocks` until it is freed. Any that don't fit are counted, and stay
+ * in the live bytes.
+ */
+extern "C" void heap_profile_malloc(void* block, size_t size, void* site) {
+    if (block == nullptr) return;
+
+    const uint16_t index = record_alloc(size, (uint32_t)(uintptr_t)site);
+    const uint32_t state = lock();
+    for (uint32_t i = 0 ; i < HEAP_PROFILE_MAX_BLOCKS ; ++i) {
+        if (blocks[i].block == nullptr) {
+            blocks[i] = {block, (uint32_t)size, index};
+            unlock(state);
+            return;
+        }
+    }
+
+    untracked++;
+    unlock(state);
+}
+
+extern "C" void heap_profile_free(void* block) {
+    if (block == nullptr) return;
+
+    uint32_t state = lock();
+    for (uint32_t i = 0 ; i < HEAP_PROFILE_MAX_BLOCKS ; ++i) {
+        if (blocks[i].block == block) {
+            const Kernel_Block freed = blocks[i];
+            blocks[i].block = nullptr;
+            unlock(state);
+            record_free(freed.site, freed.size);
+            return;
+        }
+    }
+
+    unlock(state);
+}
+
+
+namespace Heap_Profile {
+
+/**
+ * @brief Get a copy of the totals across every site.
+ */
+Heap_Profile_Totals get_totals() {
+    const uint32_t state = lock();
+    const Heap_Profile_Totals copy = totals;
+    unlock(state);
+    return copy;
+}
+
+
+/**
+ * @brief Write the totals, then every site, to STDIO as CSV lines, for
+ *        `Tools/heap_report.py`. The rates cover the time since the last
+ *        report, so a steady-state hotspot stands out from start-up work:
+ *        `HEAP,<interval_ms>,<allocs>,<frees>,<live_bytes>,<peak_bytes>,<sites>,<dropped>,<untracked>,<heap_in_use>`
+ *        `HEAP_SITE,<task>,<allocs>,<frees>,<bytes>,<live_bytes>,<allocs_per_s>,<bytes_per_s>,<frame 0>,...`
+ *        Direct `malloc()` calls are not profiled, so a warning gives
+ *        the whole heap's use, allocator overhead included, to compare.
+ */
+void report() {
+    const uint64_t now = time_us_64();
+    const uint64_t interval_us = now - reported_us > 0 ? now - reported_us : 1;
+    reported_us = now;
+
+    uint32_t state = lock();
+    const Heap_Profile_Totals copy = totals;
+    const uint32_t untracked_copy = untracked;
+    unlock(state);
+
+    const struct mallinfo info = mallinfo();
+    printf("[WARNING] Heap_Profile: direct malloc() and free() calls are not counted. Heap in use: %lu bytes, profiled: %lu\n",
+           (unsigned long)info.uordblks, (unsigned long)copy.live_bytes);
+    printf("HEAP,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu\n", (unsigned long)(interval_us / 1000),
+           (unsigned long)copy.allocs, (unsigned long)copy.frees, (unsigned long)copy.live_bytes, (unsigned long)copy.peak_bytes,
+           (unsigned long)copy.sites, (unsigned long)copy.dropped, (unsigned long)untracked_copy, (unsigned long)info.uordblks);
+
+    for (uint32_t i = 0 ; i < HEAP_PROFILE_MAX_SITES ; ++i) {
+        // Copy the site, and mark the counts reported, before printing
+        // to STDIO, which may itself allocate
+        state = lock();
+        const Heap_Site site = sites[i];
+        sites[i].reported_allocs = site.allocs;
+        sites[i].reported_bytes = site.bytes;
+        unlock(state);
+
+        if (site.allocs == 0) continue;
+
+        const uint32_t allocs_per_s = (uint32_t)((uint64_t)(site.allocs - site.reported_allocs) * 1000000 / interval_us);
+        const uint32_t bytes_per_s = (uint32_t)((uint64_t)(site.bytes - site.reported_bytes) * 1000000 / interval_us);
+        printf("HEAP_SITE,%s,%lu,%lu,%lu,%lu,%lu,%lu", site.name, (unsigned long)site.allocs, (unsigned long)site.frees,
+               (unsigned long)site.bytes, (unsigned long)site.live_bytes, (unsigned long)allocs_per_s, (unsigned long)bytes_per_s);
+        for (uint32_t j = 0 ; j < HEAP_PROFILE_FRAMES ; ++j) printf(",0x%08lx", (unsigned long)site.frames[j]);
+        printf("\n");
+    }
+}
+
+}   // namespace Heap_Profile
+
+#endif  // configUSE_HEAP_PROFILE
@@ -0,0 +1,100 @@
+/**
+ * RP2040 FreeRTOS Template - App #3
+ * Per-call-site heap allocation profiling
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#ifndef HEAP_PROFILE_HEADER
+#define HEAP_PROFILE_HEADER
+
+
+#include <cstdlib>
+#include <cstdint>
+// FreeRTOS
+#include <FreeRTOS.h>
+#include <task.h>
+
+
+/*
+ * CONSTANTS
+ */
+#define HEAP_PROFILE_MAX_SITES      64
+// Return addresses kept per site, innermost first
+#define HEAP_PROFILE_FRAMES         4
+// How far up the stack to look for the outer return addresses
+#define HEAP_PROFILE_SCAN_WORDS     64
+// Kernel blocks tracked until they are freed
+#define HEAP_PROFILE_MAX_BLOCKS     32
+#define HEAP_PROFILE_NAME_LEN       12
+
+
+/*
+ * TYPES
+ */
+/**
+    Totals across every site.
+ */
+struct Heap_Profile_Totals {
+    uint32_t    allocs;
+    uint32_t    frees;
+    uint32_t    live_bytes;
+    uint32_t    peak_bytes;
+    uint32_t    sites;
+    uint32_t    dropped;            // Allocations with no room for their site
+};
+
+
+#if configUSE_HEAP_PROFILE
+
+/**
+    The allocations made from one call chain by one task. Bytes are those
+    requested, so they exclude the allocator's own overhead.
+ */
+struct Heap_Site {
+    uint32_t        frames[HEAP_PROFILE_FRAMES];
+    uint32_t        key;                // Hash of the frames, task and name
+    TaskHandle_t    task;
+    char            name[HEAP_PROFILE_NAME_LEN];
+    uint32_t        allocs;
+    uint32_t        frees;
+    uint32_t        bytes;
+    uint32_t        live_bytes;
+    // Counts at the last report, for the rates
+    uint32_t        reported_allocs;
+    uint32_t        reported_bytes;
+};
+
+
+/*
+ * Every `new`, `new[]` and kernel `pvPortMalloc()` is charged to its call
+ * site and the task that made it. The direct caller is often inside the
+ * standard library, eg. `std::string`'s growth function, so the stack is
+ * scanned for the return addresses beyond it: up to four are kept, enough
+ * to reach the app code behind most container and string allocations.
+ * Resolve them with `Tools/heap_report.py`.
+ *
+ * `malloc()` and `free()` called directly, by app code or by newlib,
+ * are not seen: the Pico SDK already wraps them at link time, and a
+ * second wrap can't be layered. `report()` warns of this, and gives the
+ * heap bytes in use alongside the profiled ones, so the gap shows.
+ */
+namespace Heap_Profile {
+    Heap_Profile_Totals get_totals();
+    void                report();
+}
+
+#else
+
+// Profiling compiles away unless the project is configured for it
+namespace Heap_Profile {
+    inline Heap_Profile_Totals  get_totals() { return {}; }
+    inline void                 report() {}
+}
+
+#endif  // configUSE_HEAP_PROFILE
+
+
+#endif  // HEAP_PROFILE_HEADER
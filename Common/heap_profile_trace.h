@@ -0,0 +1,40 @@
+/**
+ * RP2040 FreeRTOS Template - App #3
+ * FreeRTOS trace hooks for heap profiling
+ *
+ * Included by FreeRTOSConfig.h, so it is seen by the kernel's C sources:
+ * keep it C and free of SDK headers.
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#ifndef HEAP_PROFILE_TRACE_HEADER
+#define HEAP_PROFILE_TRACE_HEADER
+
+
+#ifndef __ASSEMBLER__
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void heap_profile_malloc(void* block, size_t size, void* site);
+void heap_profile_free(void* block);
+
+#ifdef __cplusplus
+}
+#endif
+
+// Expanded inside `pvPortMalloc()` and `vPortFree()`, so the return
+// address is the caller of the kernel allocator, eg. `xTaskCreate()`
+#define traceMALLOC(block, size)    heap_profile_malloc(block, size, __builtin_return_address(0))
+#define traceFREE(block, size)      heap_profile_free(block)
+
+#endif  // __ASSEMBLER__
+
+
+#endif  // HEAP_PROFILE_TRACE_HEADER
@@ -0,0 +1,269 @@
+/**
+ * RP2040 FreeRTOS Template - App #4
+ * Microsecond one-shot timers on the RP2040 hardware alarms
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#include "hr_timer.h"
+
+
+/*
+ * GLOBALS
+ */
+// One deadline-ordered list per claimed alarm
+struct HR_Alarm {
+    uint32_t    alarm_num;
+    uint32_t    pending;
+    HR_Timer*   head;
+};
+
+static HR_Alarm alarms[HR_TIMER_MAX_ALARMS];
+static uint32_t alarm_count = 0;
+static int8_t   slot_of_alarm[HR_TIMER_MAX_ALARMS] = {-1, -1, -1, -1};
+
+
+/**
+ * @brief Claim hardware alarms for the timer service. Call once, before
+ *        any timer is started.
+ *
+ * @param count: The number of alarms to claim. Default: HR_TIMER_ALARM_COUNT.
+ *
+ * @retval `true` if at least one alarm was claimed, otherwise `false`.
+ */
+bool HR_Timer::init(uint32_t count) {
+    if (alarm_count > 0) return true;
+    if (count > HR_TIMER_MAX_ALARMS) count = HR_TIMER_MAX_ALARMS;
+
+    for (uint32_t i = 0 ; i < count ; ++i) {
+        const int alarm_num = hardware_alarm_claim_unused(false);
+        if (alarm_num < 0) break;
+
+        alarms[alarm_count] = {(uint32_t)alarm_num, 0, nullptr};
+        slot_of_alarm[alarm_num] = (int8_t)alarm_count;
+        hardware_alarm_set_callback((uint)alarm_num, alarm_isr);
+        alarm_count++;
+    }
+
+    #ifdef DEBUG
+    printf("[DEBUG] HR timer alarms claimed: %lu\n", (unsigned long)alarm_count);
+    #endif
+    return alarm_count > 0;
+}
+
+
+/**
+ * @brief Constructor: instantiate an idle timer with no action.
+ */
+HR_Timer::HR_Timer() {
+    callback = nullptr;
+    context = nullptr;
+    task = NULL;
+    notify_index = HR_TIMER_NOTIFY_INDEX;
+    deadline = 0;
+    fired = 0;
+    next = nullptr;
+    slot = 0;
+    active = false;
+}
+
+
+/**
+ * @brief Run a function in the alarm ISR on expiry.
+ *
+ * @param callback: The function to call.
+ * @param context:  A value passed to the function. Default: `nullptr`.
+ */
+void HR_Timer::set_callback(HR_Timer_Callback callback, void* context) {
+    this->callback = callback;
+    this->context = context;
+    task = NULL;
+}
+
+
+/**
+ * @brief Give a task notification on expiry.
+ *
+ * @param task:  The task to notify.
+ * @param index: The notification array index. Default: HR_TIMER_NOTIFY_INDEX.
+ */
+void HR_Timer::set_notify(TaskHandle_t task, UBaseType_t index) {
+    this->task = task;
+    notify_index = index;
+    callback = nullptr;
+}
+
+
+/**
+ * @brief Start, or restart, the timer for an absolute time.
+ *
+ * @param deadline_us: The expiry time in microseconds since boot.
+ *                     A time already passed expires at once.
+ *
+ * @retval `true` if the timer was started, `false` if no alarms are claimed.
+ */
+bool HR_Timer::start_at(uint64_t deadline_us) {
+    if (alarm_count == 0) return false;
+
+    const uint32_t irq_state = save_and_disable_interrupts();
+    if (active) unlink();
+
+    // Use the least busy alarm
+    uint32_t best = 0;
+    for (uint32_t i = 1 ; i < alarm_count ; ++i) {
+        if (alarms[i].pending < alarms[best].pending) best = i;
+    }
+
+    // Insert in deadline order, after any equal deadlines
+    deadline = deadline_us;
+    slot = (uint8_t)best;
+    active = true;
+    HR_Timer** link = &alarms[best].head;
+    while (*link != nullptr && (*link)->deadline <= deadline_us) link = &(*link)->next;
+    next = *link;
+    *link = this;
+    alarms[best].pending++;
+
+    // Only a new earliest deadline needs the alarm moved
+    if (alarms[best].head == this) program(best);
+    restore_interrupts(irq_state);
+    return true;
+}
+
+
+/**
+ * @brief Start, or restart, the timer relative to now.
+ *
+ * @param delay_us: The delay in microseconds.
+ *
+ * @retval `true` if the timer was started, `false` if no alarms are claimed.
+ */
+bool HR_Timer::start_in(uint32_t delay_us) {
+    return start_at(time_us_64() + delay_us);
+}
+
+
+/**
+ * @brief Stop the timer if it is running.
+ */
+void HR_Timer::cancel() {
+    const uint32_t irq_state = save_and_disable_interrupts();
+    if (active) {
+        const bool was_head = alarms[slot].head == this;
+        unlink();
+        if (was_head) program(slot);
+    }
+
+    restore_interrupts(irq_state);
+}
+
+
+bool HR_Timer::is_active() const {
+    return active;
+}
+
+
+/**
+ * @brief The deadline the timer was last started for, in us since boot.
+ */
+uint64_t HR_Timer::get_deadline() const {
+    return deadline;
+}
+
+
+/**
+ * @brief When the timer was last dispatched, in us since boot.
+ *        Subtract the deadline to get the lateness.
+ */
+uint64_t HR_Timer::get_fired() const {
+    return fired;
+}
+
+
+/**
+ * @brief Remove the timer from its alarm's list.
+ *        Call with interrupts disabled.
+ */
+void HR_Timer::unlink() {
+    HR_Timer** link = &alarms[slot].head;
+    while (*link != nullptr && *link != this) link = &(*link)->next;
+    if (*link == this) {
+        *link = next;
+        alarms[slot].pending--;
+    }
+
+    next = nullptr;
+    active = false;
+}
+
+
+/**
+ * @brief Set an alarm for the earliest deadline on its list.
+ *        Call with interrupts disabled.
+ *
+ * @param slot: The alarm's index in the claimed set.
+ */
+void HR_Timer::program(uint32_t slot) {
+    HR_Alarm& alarm = alarms[slot];
+    if (alarm.head == nullptr) {
+        hardware_alarm_cancel(alarm.alarm_num);
+        return;
+    }
+
+    // The SDK won't fire for a time that has already passed, so raise
+    // the IRQ by hand: expiry always runs in the alarm ISR
+    if (hardware_alarm_set_target(alarm.alarm_num, from_us_since_boot(alarm.head->deadline))) {
+        hardware_alarm_force_irq(alarm.alarm_num);
+    }
+}
+
+
+/**
+ * @brief Run the timer's expiry action. Called in the alarm ISR.
+ */
+void HR_Timer::dispatch(BaseType_t* higher_priority_task_woken) {
+    if (callback != nullptr) {
+        callback(this, context, higher_priority_task_woken);
+    } else if (task != NULL) {
+        vTaskNotifyGiveIndexedFromISR(task, notify_index, higher_priority_task_woken);
+    }
+}
+
+
+/**
+ * @brief Hardware alarm ISR: dispatch every expired timer on the
+ *        alarm's list, then set the alarm for the next one.
+ *
+ * @param alarm_num: The hardware alarm that fired.
+ */
+void HR_Timer::alarm_isr(uint alarm_num) {
+    const int8_t index = slot_of_alarm[alarm_num & (HR_TIMER_MAX_ALARMS - 1)];
+    if (index < 0) return;
+
+    HR_Alarm& alarm = alarms[index];
+    BaseType_t higher_priority_task_woken = pdFALSE;
+
+    while (true) {
+        // Take the head if it is due. Timers are started from tasks
+        // and other ISRs too, so mask interrupts while unlinking
+        const uint32_t irq_state = save_and_disable_interrupts();
+        HR_Timer* timer = alarm.head;
+        const uint64_t now = time_us_64();
+        if (timer == nullptr || timer->deadline > now) {
+            program((uint32_t)index);
+            restore_interrupts(irq_state);
+            break;
+        }
+
+        timer->unlink();
+        timer->fired = now;
+        restore_interrupts(irq_state);
+
+        // The action may restart this or any other timer
+        timer->dispatch(&higher_priority_task_woken);
+    }
+
+    portYIELD_FROM_ISR(higher_priority_task_woken);
+}
@@ -0,0 +1,86 @@
+/**
+ * RP2040 FreeRTOS Template - App #4
+ * Microsecond one-shot timers on the RP2040 hardware alarms
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#ifndef HR_TIMER_HEADER
+#define HR_TIMER_HEADER
+
+
+#include <cstdlib>
+#include <cstdint>
+// FreeRTOS
+#include <FreeRTOS.h>
+#include <task.h>
+// Pico SDK
+#include "pico/stdlib.h"            // Includes `hardware_timer.h`
+#include "hardware/sync.h"
+
+
+/*
+ * CONSTANTS
+ */
+// Hardware alarms to claim. The SDK's default alarm pool, which backs
+// `sleep_ms()` and `add_alarm_in_ms()`, keeps one of the four
+#define HR_TIMER_ALARM_COUNT        2
+#define HR_TIMER_MAX_ALARMS         4
+#define HR_TIMER_NOTIFY_INDEX       0
+
+
+class HR_Timer;
+
+/**
+    Called in the alarm ISR. Pass anything woken via FreeRTOS `...FromISR()`
+    calls in `higher_priority_task_woken`; the ISR yields on exit.
+ */
+typedef void (*HR_Timer_Callback)(HR_Timer* timer, void* context, BaseType_t* higher_priority_task_woken);
+
+
+/**
+    A one-shot timer with a microsecond deadline. On expiry it either calls
+    a function in the alarm ISR or gives a task notification. Timers are
+    spread across the claimed hardware alarms; each alarm keeps its timers
+    in deadline order and is always set for the earliest. A callback may
+    restart its own timer to run periodically without drift.
+ */
+class HR_Timer {
+
+    public:
+        HR_Timer();
+
+        static bool     init(uint32_t alarm_count = HR_TIMER_ALARM_COUNT);
+
+        void            set_callback(HR_Timer_Callback callback, void* context = nullptr);
+        void            set_notify(TaskHandle_t task, UBaseType_t index = HR_TIMER_NOTIFY_INDEX);
+        bool            start_at(uint64_t deadline_us);
+        bool            start_in(uint32_t delay_us);
+        void            cancel();
+
+        bool            is_active() const;
+        uint64_t        get_deadline() const;
+        uint64_t        get_fired() const;
+
+    private:
+        static void     alarm_isr(uint alarm_num);
+        static void     program(uint32_t slot);
+        void            unlink();
+        void            dispatch(BaseType_t* higher_priority_task_woken);
+
+        HR_Timer_Callback   callback;
+        void*               context;
+        TaskHandle_t        task;
+        UBaseType_t         notify_index;
+
+        uint64_t            deadline;
+        uint64_t            fired;
+        HR_Timer*           next;
+        uint8_t             slot;
+        volatile bool       active;
+};
+
+
+#endif  // HR_TIMER_HEADER
@@ -27,7 +27,7 @@ const uint32_t POS[4] = {0, 2, 6, 8};
 /**
  * @brief Basic driver for HT16K33-based display.
  *
- * @param address: The display's I2C address. Default: 0x70.
+ * @param address: The display's I2C address. Default: the board's.
  */
 HT16K33_Segment::HT16K33_Segment(uint32_t address) {
     if (address == 0x00 || address > 0xFF) address = HT16K33_ADDRESS;
@@ -166,6 +166,8 @@ HT16K33_Segment& HT16K33_Segment::set_alpha(char chr, uint32_t digit, bool has_d
  * @brief Write the display buffer out to I2C.
  */
 void HT16K33_Segment::draw() {
+    const uint32_t start_us = time_us_32();
+
     // Set up the buffer holding the data to be
     // transmitted to the LED
     uint8_t tx_buffer[17];
@@ -179,5 +181,7 @@ void HT16K33_Segment::draw() {
 
     // Write out the transmit buffer
     I2C::write_block(i2c_addr, tx_buffer, sizeof(tx_buffer));
+    Metrics::add(Metrics::Counter::HT16K33_DRAWS);
+    Metrics::observe(Metrics::Histogram::HT16K33_DRAW_US, time_us_32() - start_us);
 }
 
@@ -25,6 +25,7 @@
 #include "pico/binary_info.h"
 #include "hardware/i2c.h"
 // App
+#include "board.h"
 #include "i2c_utils.h"
 #include "utils.h"
 
@@ -39,6 +40,7 @@
 #define HT16K33_GENERIC_DISPLAY_ADDRESS     0x00
 #define HT16K33_GENERIC_CMD_BRIGHTNESS      0xE0
 #define HT16K33_GENERIC_CMD_BLINK           0x81
+// The display's address with its jumpers open. Boards set the address in use
 #define HT16K33_ADDRESS                     0x70
 
 #define HT16K33_SEGMENT_COLON_ROW           0x04
@@ -53,7 +55,7 @@
 class HT16K33_Segment {
 
     public:
-        HT16K33_Segment(uint32_t address = HT16K33_ADDRESS);
+        HT16K33_Segment(uint32_t address = Board::DISPLAY_ADDRESS);
 
         void                init();
         void                power_on(bool turn_on = true);
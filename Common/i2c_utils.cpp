@@ -12,17 +12,34 @@
 
 namespace I2C {
 
+/**
+ * @brief Publish the outcome of a blocking transfer.
+ *
+ * @param kind:     Metrics::Counter::I2C_WRITES or Metrics::Counter::I2C_READS.
+ * @param result:   The SDK call's return value: bytes moved, or an error code.
+ * @param start_us: `time_us_32()` when the transfer began.
+ */
+static void record_blocking(Metrics::Counter kind, int result, uint32_t start_us) {
+    Metrics::observe(Metrics::Histogram::I2C_TRANSFER_US, time_us_32() - start_us);
+    Metrics::add(kind);
+    if (result < 0) {
+        Metrics::add(Metrics::Counter::I2C_ERRORS);
+    } else {
+        Metrics::add(Metrics::Counter::I2C_BYTES, (uint32_t)result);
+    }
+}
+
 /**
  * @brief Set up the I2C block.
  *
- * Takes values from #defines set in `i2c_utils.h`
+ * Takes the block, pins and speed from the selected board in `board.h`
  */
 void setup() {
-    i2c_init(I2C_PORT, I2C_FREQUENCY);
-    gpio_set_function(SDA_GPIO, GPIO_FUNC_I2C);
-    gpio_set_function(SCL_GPIO, GPIO_FUNC_I2C);
-    gpio_pull_up(SDA_GPIO);
-    gpio_pull_up(SCL_GPIO);
+    i2c_init(BOARD_I2C_PORT, Board::I2C_FREQUENCY);
+    gpio_set_function(Board::I2C_SDA_PIN, GPIO_FUNC_I2C);
+    gpio_set_function(Board::I2C_SCL_PIN, GPIO_FUNC_I2C);
+    gpio_pull_up(Board::I2C_SDA_PIN);
+    gpio_pull_up(Board::I2C_SCL_PIN);
 }
 
 /**
@@ -32,7 +49,9 @@ void setup() {
  * @param byte:    The byte to send.
  */
 void write_byte(uint8_t address, uint8_t byte) {
-    i2c_write_blocking(I2C_PORT, address, &byte, 1, false);
+    const uint32_t start_us = time_us_32();
+    const int result = i2c_write_blocking(BOARD_I2C_PORT, address, &byte, 1, false);
+    record_blocking(Metrics::Counter::I2C_WRITES, result, start_us);
 }
 
 /**
@@ -43,7 +62,9 @@ void write_byte(uint8_t address, uint8_t byte) {
  * @param count:   The number of bytes to send.
  */
 void write_block(uint8_t address, uint8_t *data, uint8_t count) {
-    i2c_write_blocking(I2C_PORT, address, data, count, false);
+    const uint32_t start_us = time_us_32();
+    const int result = i2c_write_blocking(BOARD_I2C_PORT, address, data, count, false);
+    record_blocking(Metrics::Counter::I2C_WRITES, result, start_us);
 }
 
 /**
@@ -54,7 +75,112 @@ void write_block(uint8_t address, uint8_t *data, uint8_t count) {
  * @param count:   The number of bytes to read.
  */
 void read_block(uint8_t address, uint8_t *data, uint8_t count) {
-    i2c_read_blocking(I2C_PORT, address, data, count, false);
+    const uint32_t start_us = time_us_32();
+    const int result = i2c_read_blocking(BOARD_I2C_PORT, address, data, count, false);
+    record_blocking(Metrics::Counter::I2C_READS, result, start_us);
+}
+
+/**
+ * @brief Address a device and clear the previous transfer's status bits.
+ *
+ * @param address: The I2C address of the target device.
+ *
+ * @retval The I2C block's registers.
+ */
+static i2c_hw_t* begin_transfer(uint8_t address) {
+    i2c_hw_t* hw = i2c_get_hw(BOARD_I2C_PORT);
+    hw->enable = 0;
+    hw->tar = address;
+    hw->enable = 1;
+    (void)hw->clr_stop_det;
+    (void)hw->clr_tx_abrt;
+    return hw;
+}
+
+/**
+ * @brief Queue a write of up to I2C_FIFO_DEPTH bytes and return at once.
+ *        Poll `transfer_status()` for completion.
+ *
+ * @param address: The I2C address of the device to write to.
+ * @param data:    Pointer to the bytes to send.
+ * @param count:   The number of bytes to send.
+ * @param no_stop: `true` to hold the bus for a following read. Default: `false`.
+ *
+ * @retval `true` if the transfer was queued, otherwise `false`.
+ */
+bool start_write(uint8_t address, const uint8_t *data, uint8_t count, bool no_stop) {
+    if (count == 0 || count > I2C_FIFO_DEPTH) return false;
+    i2c_hw_t* hw = begin_transfer(address);
+
+    for (uint8_t i = 0 ; i < count ; ++i) {
+        const bool last = (i == count - 1);
+        hw->data_cmd = (i == 0 && BOARD_I2C_PORT->restart_on_next ? I2C_IC_DATA_CMD_RESTART_BITS : 0) |
+                       (last && !no_stop ? I2C_IC_DATA_CMD_STOP_BITS : 0) |
+                       data[i];
+    }
+
+    BOARD_I2C_PORT->restart_on_next = no_stop;
+    Metrics::add(Metrics::Counter::I2C_QUEUED);
+    return true;
+}
+
+/**
+ * @brief Queue a read of up to I2C_FIFO_DEPTH bytes and return at once.
+ *        Poll `transfer_status()` for completion, then call `collect()`.
+ *
+ * @param address: The I2C address of the device to read from.
+ * @param count:   The number of bytes to read.
+ *
+ * @retval `true` if the transfer was queued, otherwise `false`.
+ */
+bool start_read(uint8_t address, uint8_t count) {
+    if (count == 0 || count > I2C_FIFO_DEPTH) return false;
+    i2c_hw_t* hw = begin_transfer(address);
+
+    for (uint8_t i = 0 ; i < count ; ++i) {
+        hw->data_cmd = (i == 0 && BOARD_I2C_PORT->restart_on_next ? I2C_IC_DATA_CMD_RESTART_BITS : 0) |
+                       (i == count - 1 ? I2C_IC_DATA_CMD_STOP_BITS : 0) |
+                       I2C_IC_DATA_CMD_CMD_BITS;
+    }
+
+    BOARD_I2C_PORT->restart_on_next = false;
+    Metrics::add(Metrics::Counter::I2C_QUEUED);
+    return true;
+}
+
+/**
+ * @brief Check on a transfer queued by `start_write()` or `start_read()`.
+ *        A write that holds the bus (`no_stop`) completes when its bytes
+ *        have left the FIFO.
+ *
+ * @retval 0 if the transfer is in progress, 1 if it completed,
+ *         or -1 if the device failed to acknowledge.
+ */
+int transfer_status() {
+    i2c_hw_t* hw = i2c_get_hw(BOARD_I2C_PORT);
+    if (hw->raw_intr_stat & I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS) {
+        (void)hw->clr_tx_abrt;
+        BOARD_I2C_PORT->restart_on_next = false;
+        Metrics::add(Metrics::Counter::I2C_ERRORS);
+        return -1;
+    }
+
+    if (hw->raw_intr_stat & I2C_IC_RAW_INTR_STAT_STOP_DET_BITS) return 1;
+    if (BOARD_I2C_PORT->restart_on_next && hw->txflr == 0) return 1;
+    return 0;
+}
+
+/**
+ * @brief Copy the bytes of a completed `start_read()` out of the FIFO.
+ *
+ * @param data:  Pointer to byte storage.
+ * @param count: The number of bytes read.
+ */
+void collect(uint8_t *data, uint8_t count) {
+    i2c_hw_t* hw = i2c_get_hw(BOARD_I2C_PORT);
+    for (uint8_t i = 0 ; i < count && hw->rxflr > 0 ; ++i) {
+        data[i] = (uint8_t)hw->data_cmd;
+    }
 }
 
 
@@ -25,16 +25,16 @@
 #include "pico/binary_info.h"
 #include "hardware/i2c.h"
 // App
+#include "board.h"
 #include "utils.h"
+#include "metrics.h"
 
 
 /*
  * CONSTANTS
  */
-#define I2C_PORT                i2c1
-#define I2C_FREQUENCY           400000
-#define SDA_GPIO                2
-#define SCL_GPIO                3
+// Longest transfer the non-blocking calls can queue: the I2C FIFO depth
+#define I2C_FIFO_DEPTH          16
 
 
 /*
@@ -46,6 +46,10 @@ namespace I2C {
     void        write_block(uint8_t address, uint8_t *data, uint8_t count);
     void        read_block(uint8_t address, uint8_t *data, uint8_t count);
     int         read_noblock(uint8_t address, uint8_t *data, uint8_t count);
+    bool        start_write(uint8_t address, const uint8_t *data, uint8_t count, bool no_stop = false);
+    bool        start_read(uint8_t address, uint8_t count);
+    int         transfer_status();
+    void        collect(uint8_t *data, uint8_t count);
 }
 
 
@@ -0,0 +1,225 @@
+/**
+ * RP2040 FreeRTOS Template - App #3
+ * Background work run from the FreeRTOS idle hook
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#include "idle_work.h"
+
+
+namespace Idle_Work {
+
+/*
+ * TYPES
+ */
+struct Idle_Item {
+    Idle_Function       function;
+    void*               context;
+    uint32_t            priority;
+    uint32_t            budget_us;
+    uint32_t            period_us;      // 0 for an item that only runs on request
+    uint32_t            due_us;         // When the next period falls due
+    volatile uint32_t   requests;       // Made so far...
+    uint32_t            served;         // ...and taken up by a run
+    volatile uint32_t   requested_us;   // When the oldest unserved request was made
+    bool                more;           // The last run has more to do
+    Idle_Item_Stats     stats;
+};
+
+
+/*
+ * GLOBALS
+ */
+static Idle_Item            items[IDLE_WORK_MAX_ITEMS] = {};
+static volatile uint32_t    item_count = 0;
+static uint32_t             deadline_us = 0;
+
+
+/*
+ * STATIC FUNCTIONS
+ */
+
+/**
+ * @brief Has an item's period passed?
+ */
+static inline bool period_due(const Idle_Item& item, uint32_t now) {
+    return item.period_us > 0 && (int32_t)(now - item.due_us) >= 0;
+}
+
+
+/*
+ * FUNCTIONS
+ */
+
+/**
+ * @brief Register an item. Call before the scheduler starts, or from a
+ *        task on core 0.
+ *
+ * @param function:  The work to do.
+ * @param context:   Passed to `function`.
+ * @param priority:  Among items, higher runs first, as for tasks.
+ * @param budget_us: The time each run should take at most.
+ * @param period_ms: Run this often as well as on request, or 0.
+ *
+ * @retval The item's ID, or IDLE_WORK_NONE if the table is full.
+ */
+int32_t add(Idle_Function function, void* context, uint32_t priority, uint32_t budget_us, uint32_t period_ms) {
+    const uint32_t index = item_count;
+    if (index >= IDLE_WORK_MAX_ITEMS) return IDLE_WORK_NONE;
+
+    Idle_Item& item = items[index];
+    item = {};
+    item.function = function;
+    item.context = context;
+    item.priority = priority;
+    item.budget_us = budget_us;
+    item.period_us = period_ms * 1000;
+    item.due_us = time_us_32() + item.period_us;
+
+    // Publish the item only once it is complete: the hook may run at any time
+    __compiler_memory_barrier();
+    item_count = index + 1;
+    return (int32_t)index;
+}
+
+
+/**
+ * @brief Ask for an item to run at the next idle moment. Requests made
+ *        before it runs are merged. Safe from tasks and ISRs on core 0.
+ *
+ * @param item: The ID returned by `add()`.
+ */
+void request(int32_t item) {
+    if (item < 0 || (uint32_t)item >= item_count) return;
+
+    Idle_Item& target = items[item];
+    const uint32_t state = save_and_disable_interrupts();
+    if (target.requests == target.served) target.requested_us = time_us_32();
+    target.requests = target.requests + 1;
+    restore_interrupts(state);
+}
+
+
+/**
+ * @brief Is the running item still within its budget?
+ */
+bool has_time() {
+    return (int32_t)(time_us_32() - deadline_us) < 0;
+}
+
+
+/**
+ * @brief Run the highest-priority item that is due, once.
+ *        `vApplicationIdleHook()` calls this.
+ *
+ * @retval `true` if an item ran, otherwise `false`.
+ */
+bool run() {
+    const uint32_t count = item_count;
+    uint32_t now = time_us_32();
+    Idle_Item* next = nullptr;
+    for (uint32_t i = 0 ; i < count ; ++i) {
+        Idle_Item& item = items[i];
+        if (!item.more && item.requests == item.served && !period_due(item, now)) continue;
+        if (next == nullptr || item.priority > next->priority) next = &item;
+    }
+
+    if (next == nullptr) return false;
+
+    // Take up any requests, and note when the work fell due, unless
+    // this run only continues the last one
+    bool fresh = false;
+    uint32_t due = now;
+    const uint32_t state = save_and_disable_interrupts();
+    if (next->requests != next->served) {
+        next->served = next->requests;
+        due = next->requested_us;
+        fresh = true;
+    }
+
+    restore_interrupts(state);
+
+    if (period_due(*next, now)) {
+        if (!fresh || (int32_t)(next->due_us - due) < 0) due = next->due_us;
+        fresh = true;
+
+        // Skip any periods missed, rather than run back to back
+        next->due_us += next->period_us;
+        if ((int32_t)(now - next->due_us) >= 0) next->due_us = now + next->period_us;
+    }
+
+    const uint32_t latency = now - due;
+    now = time_us_32();
+    deadline_us = now + next->budget_us;
+    next->more = next->function(next->context);
+    const uint32_t elapsed = time_us_32() - now;
+
+    // Tasks may read the statistics, so update them in one step
+    Idle_Item_Stats& stats = next->stats;
+    const uint32_t status = save_and_disable_interrupts();
+    stats.runs++;
+    if (elapsed > next->budget_us) stats.overruns++;
+    if (elapsed > stats.max_run_us) stats.max_run_us = elapsed;
+    if (fresh) {
+        stats.latencies++;
+        stats.total_latency_us += latency;
+        if (latency > stats.max_latency_us) stats.max_latency_us = latency;
+    }
+
+    restore_interrupts(status);
+    return true;
+}
+
+
+uint32_t get_count() {
+    return item_count;
+}
+
+
+/**
+ * @brief Get a copy of an item's run and latency statistics.
+ */
+Idle_Item_Stats get_stats(int32_t item) {
+    Idle_Item_Stats copy = {};
+    if (item < 0 || (uint32_t)item >= item_count) return copy;
+
+    const uint32_t state = save_and_disable_interrupts();
+    copy = items[item].stats;
+    restore_interrupts(state);
+    return copy;
+}
+
+
+void reset_stats(int32_t item) {
+    if (item < 0 || (uint32_t)item >= item_count) return;
+
+    const uint32_t state = save_and_disable_interrupts();
+    items[item].stats = {};
+    restore_interrupts(state);
+}
+
+
+/**
+ * @brief The RAM one item takes, to set against a task's stack and TCB.
+ */
+uint32_t get_item_size() {
+    return sizeof(Idle_Item);
+}
+
+
+}   // namespace Idle_Work
+
+
+/*
+ * FREERTOS HOOKS
+ */
+#if configUSE_IDLE_HOOK == 1
+
+extern "C" void vApplicationIdleHook() {
+    Idle_Work::run();
+}
+
+#endif
@@ -0,0 +1,75 @@
+/**
+ * RP2040 FreeRTOS Template - App #3
+ * Background work run from the FreeRTOS idle hook
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#ifndef IDLE_WORK_HEADER
+#define IDLE_WORK_HEADER
+
+
+#include <cstdlib>
+#include <cstdint>
+// FreeRTOS
+#include <FreeRTOS.h>
+#include <task.h>
+// Pico SDK
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+
+
+/*
+ * CONSTANTS
+ */
+#define IDLE_WORK_MAX_ITEMS         8
+#define IDLE_WORK_NONE              -1
+
+
+/*
+ * TYPES
+ */
+// Do a bounded amount of work. Return `true` if there is more to do
+// now, and the item runs again at the next idle moment
+typedef bool (*Idle_Function)(void* context);
+
+struct Idle_Item_Stats {
+    uint32_t    runs;
+    uint32_t    overruns;           // Runs that took longer than the budget
+    uint32_t    max_run_us;
+    uint32_t    latencies;          // Runs that started a request or a period...
+    uint32_t    max_latency_us;     // ...and the time from it falling due to starting
+    uint64_t    total_latency_us;
+};
+
+
+/*
+ * Idle work items replace housekeeping tasks -- log draining, flash
+ * batching, stats aggregation -- that would each need a stack and TCB.
+ * They run on the idle task's stack, from `vApplicationIdleHook()`, so
+ * only when no task is ready. Build with `configUSE_IDLE_HOOK` set to 1
+ * and a `configMINIMAL_STACK_SIZE` big enough for the deepest item.
+ *
+ * An item runs when it has been requested, when its period has passed,
+ * or when its last run said it had more to do. Each call of the hook
+ * runs one item: the highest-priority one that is due. The item gets a
+ * time budget, and should check `has_time()` between steps and return
+ * `true` to carry on later. Going over budget is counted, not stopped.
+ * Items must never block, and run on core 0 only.
+ */
+namespace Idle_Work {
+    int32_t         add(Idle_Function function, void* context, uint32_t priority, uint32_t budget_us, uint32_t period_ms = 0);
+    void            request(int32_t item);
+    bool            has_time();
+    bool            run();
+
+    uint32_t        get_count();
+    Idle_Item_Stats get_stats(int32_t item);
+    void            reset_stats(int32_t item);
+    uint32_t        get_item_size();
+}
+
+
+#endif  // IDLE_WORK_HEADER
@@ -0,0 +1,39 @@
+/**
+ * RP2040 FreeRTOS Template - App #3
+ * NVIC priority map for every interrupt the apps use
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#include "irq_priority.h"
+
+
+namespace IRQ_Priority {
+
+/**
+ * @brief Set the NVIC priority of every interrupt the apps and the SDK
+ *        use. NVIC priorities are per core, so call this on core 0
+ *        before the scheduler starts; `Zero_Latency::add()` sets up core 1.
+ */
+void apply() {
+    // HR_Timer takes whichever alarms the SDK's default pool leaves
+    for (uint32_t alarm = 0 ; alarm < 4 ; ++alarm) {
+        irq_set_priority(TIMER_IRQ_0 + alarm,
+                         alarm == PICO_TIME_DEFAULT_ALARM_POOL_HARDWARE_ALARM_NUM ? IRQ_PRIORITY_ALARM_POOL : IRQ_PRIORITY_TIMER);
+    }
+
+    irq_set_priority(DMA_IRQ_0, IRQ_PRIORITY_DMA);
+    irq_set_priority(DMA_IRQ_1, IRQ_PRIORITY_DMA);
+    irq_set_priority(UART0_IRQ, IRQ_PRIORITY_UART);
+    irq_set_priority(UART1_IRQ, IRQ_PRIORITY_UART);
+    irq_set_priority(IO_IRQ_BANK0, IRQ_PRIORITY_GPIO);
+    irq_set_priority(I2C0_IRQ, IRQ_PRIORITY_I2C);
+    irq_set_priority(I2C1_IRQ, IRQ_PRIORITY_I2C);
+    irq_set_priority(SIO_IRQ_PROC0, IRQ_PRIORITY_DOORBELL);
+    irq_set_priority(USBCTRL_IRQ, IRQ_PRIORITY_USB);
+}
+
+
+}   // namespace IRQ_Priority
@@ -0,0 +1,53 @@
+/**
+ * RP2040 FreeRTOS Template - App #3
+ * NVIC priority map for every interrupt the apps use
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#ifndef IRQ_PRIORITY_HEADER
+#define IRQ_PRIORITY_HEADER
+
+
+#include <cstdlib>
+#include <cstdint>
+// Pico SDK
+#include "pico/stdlib.h"
+#include "hardware/irq.h"
+
+
+/*
+ * CONSTANTS
+ */
+// The Cortex-M0+ NVIC implements the top two priority bits: 0x00 is
+// the highest, 0xC0 the lowest.
+//
+// The FreeRTOS ARM_CM0 port has no BASEPRI, so its critical sections
+// mask every interrupt on core 0. Core 0 priorities therefore only
+// order ISRs against each other. Anything that must not wait for the
+// kernel runs on core 1 in the zero-latency class -- see zero_latency.h
+
+// Zero-latency class: core 1 only. Never calls FreeRTOS
+#define IRQ_PRIORITY_ZERO_LATENCY       0x00
+
+// Kernel-aware classes: core 0. May call `...FromISR()` APIs
+#define IRQ_PRIORITY_TIMER              0x40    // HR_Timer alarms: microsecond deadlines
+#define IRQ_PRIORITY_DMA                0x40    // UART ring restart: must beat the ring wrap
+#define IRQ_PRIORITY_UART               0x80
+#define IRQ_PRIORITY_GPIO               0x80
+#define IRQ_PRIORITY_I2C                0x80
+#define IRQ_PRIORITY_DOORBELL           0x80    // Core 1 to core 0 SIO FIFO
+#define IRQ_PRIORITY_ALARM_POOL         0x80    // SDK `sleep_ms()` and `add_alarm_in_ms()`
+#define IRQ_PRIORITY_USB                0xC0    // STDIO over USB
+// PendSV and SysTick: FreeRTOS always sets these to the lowest priority
+#define IRQ_PRIORITY_KERNEL             0xC0
+
+
+namespace IRQ_Priority {
+    void    apply();
+}
+
+
+#endif  // IRQ_PRIORITY_HEADER
@@ -0,0 +1,264 @@
+/**
+ * RP2040 FreeRTOS Template - App #5
+ * Work-stealing jobs across both cores
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#include "jobs.h"
+
+
+/*
+ * TYPES
+ */
+struct Job_Group {
+    volatile int32_t    pending;
+};
+
+
+/*
+ * JOB DEQUE
+ */
+
+/**
+ * @brief Owner only: add a job at the bottom.
+ *
+ * @retval `true` if the job was added, `false` if the deque is full.
+ */
+bool __not_in_flash_func(Job_Deque::push)(const Job& job) {
+    const int32_t b = bottom.load(std::memory_order_relaxed);
+    if (b - top.load(std::memory_order_acquire) >= JOBS_DEQUE_SIZE) return false;
+
+    jobs[b & (JOBS_DEQUE_SIZE - 1)] = job;
+    bottom.store(b + 1, std::memory_order_release);
+    return true;
+}
+
+/**
+ * @brief Owner only: take the newest job. The owner claims the slot by
+ *        lowering `bottom` before it reads `top`, and the fence makes
+ *        sure a thief sees one or the other. Only for the last job might
+ *        both claim it, and then `top` decides.
+ *
+ * @retval `true` if `job` was filled, `false` if the deque is empty.
+ */
+bool __not_in_flash_func(Job_Deque::pop)(Job& job) {
+    const int32_t b = bottom.load(std::memory_order_relaxed) - 1;
+    bottom.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const int32_t t = top.load(std::memory_order_relaxed);
+
+    if (t > b) {
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return false;
+    }
+
+    job = jobs[b & (JOBS_DEQUE_SIZE - 1)];
+    if (t < b) return true;
+
+    const bool won = advance_top(t);
+    bottom.store(b + 1, std::memory_order_relaxed);
+    return won;
+}
+
+/**
+ * @brief Any other core: take the oldest job. The copy is only kept if
+ *        `top` has not moved since it was read; if it has, the owner
+ *        may since have reused the slot.
+ *
+ * @retval `true` if `job` was filled, `false` if the deque is empty or
+ *         another core took the job first.
+ */
+bool __not_in_flash_func(Job_Deque::steal)(Job& job) {
+    const int32_t t = top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const int32_t b = bottom.load(std::memory_order_acquire);
+    if (t >= b) return false;
+
+    job = jobs[t & (JOBS_DEQUE_SIZE - 1)];
+    return advance_top(t);
+}
+
+/**
+ * @brief Compare-and-swap `top` from `expected` to `expected + 1`. The
+ *        spinlock also masks interrupts, so the window is a few cycles.
+ */
+bool __not_in_flash_func(Job_Deque::advance_top)(int32_t expected) {
+    const uint32_t state = spin_lock_blocking(lock);
+    const bool swapped = top.load(std::memory_order_relaxed) == expected;
+    if (swapped) top.store(expected + 1, std::memory_order_relaxed);
+    spin_unlock(lock, state);
+    return swapped;
+}
+
+
+namespace Jobs {
+
+/*
+ * GLOBALS
+ */
+static Job_Deque            deques[JOBS_CORES];
+static spin_lock_t*         lock = nullptr;
+static bool                 started = false;
+
+// The task using the job system. The kernel is built without mutexes,
+// so a binary semaphore guards it and nested calls are spotted by hand
+static SemaphoreHandle_t    owner_semaphore = NULL;
+static TaskHandle_t         owner = NULL;
+
+// Statistics. Each core writes only its own
+static volatile uint32_t    executed[JOBS_CORES] = {0};
+static volatile uint32_t    stolen[JOBS_CORES] = {0};
+
+
+/*
+ * EXECUTION
+ */
+
+/**
+ * @brief Run a job and count it off its group. The spinlock makes the
+ *        decrement atomic between the cores.
+ */
+static void __not_in_flash_func(run)(const Job& job, uint32_t core) {
+    job.function(job.context, job.begin, job.end);
+    executed[core] = executed[core] + 1;
+
+    const uint32_t state = spin_lock_blocking(lock);
+    job.group->pending = job.group->pending - 1;
+    spin_unlock(lock, state);
+}
+
+/**
+ * @brief Run one job: the newest of this core's own, or else the oldest
+ *        of another core's.
+ *
+ * @retval `true` if a job was run, `false` if there were none.
+ */
+static bool __not_in_flash_func(run_one)(uint32_t core) {
+    Job job;
+    if (deques[core].pop(job)) {
+        run(job, core);
+        return true;
+    }
+
+    for (uint32_t other = 0 ; other < JOBS_CORES ; ++other) {
+        if (other == core || !deques[other].steal(job)) continue;
+        stolen[core] = stolen[core] + 1;
+        run(job, core);
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * @brief Core 1's worker, called from the Zero_Latency loop.
+ */
+static bool __not_in_flash_func(worker)() {
+    return run_one(1);
+}
+
+
+/*
+ * API
+ */
+
+/**
+ * @brief Claim a spinlock and give core 1 its worker, launching core 1
+ *        if need be. Call once, from a task on core 0.
+ *
+ * @retval `true` if the job system is running, otherwise `false`.
+ */
+bool start() {
+    if (started) return true;
+
+    const int lock_num = spin_lock_claim_unused(false);
+    if (lock_num < 0) return false;
+    owner_semaphore = xSemaphoreCreateBinary();
+    if (owner_semaphore == NULL) return false;
+    xSemaphoreGive(owner_semaphore);
+
+    lock = spin_lock_instance((uint)lock_num);
+    for (uint32_t i = 0 ; i < JOBS_CORES ; ++i) deques[i].set_lock(lock);
+
+    Zero_Latency::start();
+    Zero_Latency::set_worker(worker);
+    started = true;
+    return true;
+}
+
+/**
+ * @brief Process `count` items in chunks of `chunk`, on both cores, and
+ *        return when all are done. The chunks are queued on the calling
+ *        core, which works through them from the end while the other
+ *        core steals from the start. Without `start()`, the caller
+ *        processes every chunk itself.
+ *
+ * @param count:    The number of items.
+ * @param chunk:    The items per job: enough that each job takes at
+ *                  least tens of microseconds.
+ * @param function: The job.
+ * @param context:  Passed to every job.
+ */
+void __not_in_flash_func(parallel_for)(uint32_t count, uint32_t chunk, Job_Function function, void* context) {
+    if (count == 0) return;
+    if (chunk == 0) chunk = 1;
+    if (!started) {
+        function(context, 0, count);
+        return;
+    }
+
+    // Core 1 only runs jobs, and core 0 only runs them in the owner's
+    // `parallel_for()`, so a call from either of those is nested
+    const uint32_t core = get_core_num();
+    const bool outer = core == 0 && owner != xTaskGetCurrentTaskHandle();
+    if (outer) {
+        xSemaphoreTake(owner_semaphore, portMAX_DELAY);
+        owner = xTaskGetCurrentTaskHandle();
+    }
+
+    Job_Group group = {(int32_t)((count + chunk - 1) / chunk)};
+    for (uint32_t begin = 0 ; begin < count ; begin += chunk) {
+        const uint32_t end = count - begin > chunk ? begin + chunk : count;
+        const Job job = {function, context, begin, end, &group};
+
+        // A full deque means both cores are busy: do one job here and retry
+        while (!deques[core].push(job)) run_one(core);
+        __sev();
+    }
+
+    // Help until the group is done. The other core may still be running
+    // the last jobs, so let core 0's other tasks have the time
+    while (group.pending > 0) {
+        if (run_one(core)) continue;
+        if (core == 0) {
+            taskYIELD();
+        } else {
+            tight_loop_contents();
+        }
+    }
+
+    if (outer) {
+        owner = NULL;
+        xSemaphoreGive(owner_semaphore);
+    }
+}
+
+/**
+ * @brief The number of jobs a core has run.
+ */
+uint32_t get_executed(uint32_t core) {
+    return core < JOBS_CORES ? executed[core] : 0;
+}
+
+/**
+ * @brief The number of jobs a core has taken from another core.
+ */
+uint32_t get_stolen(uint32_t core) {
+    return core < JOBS_CORES ? stolen[core] : 0;
+}
+
+
+}   // namespace Jobs
@@ -0,0 +1,97 @@
+/**
+ * RP2040 FreeRTOS Template - App #5
+ * Work-stealing jobs across both cores
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#ifndef JOBS_HEADER
+#define JOBS_HEADER
+
+
+#include <cstdlib>
+#include <cstdint>
+#include <atomic>
+// FreeRTOS
+#include <FreeRTOS.h>
+#include <task.h>
+#include <semphr.h>
+// Pico SDK
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+// App
+#include "zero_latency.h"
+
+
+/*
+ * CONSTANTS
+ */
+// Jobs each core can have queued. Must be a power of two
+#define JOBS_DEQUE_SIZE             64
+#define JOBS_CORES                  2
+
+
+/*
+ * TYPES
+ */
+// A job processes items `begin` to `end - 1` of whatever `context` points to
+typedef void (*Job_Function)(void* context, uint32_t begin, uint32_t end);
+
+struct Job_Group;
+
+struct Job {
+    Job_Function    function;
+    void*           context;
+    uint32_t        begin;
+    uint32_t        end;
+    Job_Group*      group;
+};
+
+
+/**
+    A Chase-Lev work-stealing deque of fixed size. Its owner pushes and
+    pops at the bottom; other cores steal from the top. The Cortex-M0+
+    has no compare-and-swap, so the one contended step -- advancing `top`
+    -- is made atomic with an SIO hardware spinlock. Every other access is
+    a plain 32-bit load or store, which the core performs atomically.
+ */
+class Job_Deque {
+
+    static_assert((JOBS_DEQUE_SIZE & (JOBS_DEQUE_SIZE - 1)) == 0, "JOBS_DEQUE_SIZE must be a power of two");
+
+    public:
+        void            set_lock(spin_lock_t* spin_lock) { lock = spin_lock; }
+
+        bool            push(const Job& job);
+        bool            pop(Job& job);
+        bool            steal(Job& job);
+
+    private:
+        Job                     jobs[JOBS_DEQUE_SIZE];
+        std::atomic<int32_t>    top {0};            // Advanced by thieves and the owner, under `lock`
+        std::atomic<int32_t>    bottom {0};         // Written by the owner only
+        spin_lock_t*            lock = nullptr;
+
+        bool            advance_top(int32_t expected);
+};
+
+
+/*
+ * Jobs run on whichever core is free: the calling task's core 0 and
+ * core 1, where they share the Zero_Latency loop -- see zero_latency.h.
+ * Zero-latency ISRs still preempt them. A job may run on core 1, so it
+ * must not call FreeRTOS, but it may call `parallel_for()` itself.
+ * Only one task uses the job system at a time; others wait their turn.
+ */
+namespace Jobs {
+    bool        start();
+    void        parallel_for(uint32_t count, uint32_t chunk, Job_Function function, void* context);
+
+    uint32_t    get_executed(uint32_t core);
+    uint32_t    get_stolen(uint32_t core);
+}
+
+
+#endif  // JOBS_HEADER
@@ -0,0 +1,246 @@
+/**
+ * RP2040 FreeRTOS Template - App #3
+ * Fixed-memory KLL streaming quantile sketch
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#ifndef KLL_HEADER
+#define KLL_HEADER
+
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <bit>
+#include <type_traits>
+
+
+/*
+ * CONSTANTS
+ */
+// Larger K is more accurate: rank error is roughly 1.7 / K^0.9
+#define KLL_DEFAULT_K               128
+// Enough levels for 2^32 items at the default K
+#define KLL_MAX_LEVELS              28
+// Quantile ranks are in basis points: 5000 is the median
+#define KLL_RANK_ONE                10000
+
+
+/**
+    A KLL quantile sketch (Karnin, Lang and Liberty, 2016) in a fixed
+    array. Level h holds items that each stand for 2^h inputs. When the
+    array fills, the lowest level at or over its capacity is sorted and
+    every other item, from a random start, moves up a level. Capacities
+    shrink by 2/3 per level below the top, which bounds the array at
+    3K + 4 * MAX_LEVELS items however many values are added.
+
+    Updates are O(1) except when they trigger a compaction. The cost of
+    compactions, amortised over the updates, is O(log K) per update.
+    Sketches built with the same K merge level by level, so snapshots
+    from different windows or units can be combined.
+
+    `T` is an integer type, eg. the raw value of a `Fixed<>`.
+ */
+template <typename T, uint32_t K = KLL_DEFAULT_K, uint32_t MAX_LEVELS = KLL_MAX_LEVELS>
+class KLL_Sketch {
+
+    static_assert(std::is_integral_v<T>, "KLL_Sketch items must be integers");
+    static_assert(K >= 8, "KLL_Sketch K must be at least 8");
+    static_assert(MAX_LEVELS + std::bit_width(K) >= 34, "KLL_Sketch needs more levels for this K");
+
+    public:
+        static constexpr uint32_t CAPACITY = 3 * K + 4 * MAX_LEVELS;
+
+        static_assert(CAPACITY < 65536, "KLL_Sketch K is too large");
+
+        KLL_Sketch(uint32_t seed = 1) {
+            random = seed != 0 ? seed : 1;
+            reset();
+        }
+
+        /**
+         * @brief Discard every value, eg. at the start of a new window.
+         */
+        void reset() {
+            count = 0;
+            level_count = 1;
+            levels[0] = CAPACITY;
+            levels[1] = CAPACITY;
+            min_value = 0;
+            max_value = 0;
+        }
+
+        /**
+         * @brief Add a value.
+         */
+        void update(T value) {
+            if (levels[0] == 0) compress();
+            levels[0]--;
+            items[levels[0]] = value;
+            track(value, value);
+            count++;
+        }
+
+        /**
+         * @brief Add every value summarised by another sketch.
+         */
+        void merge(const KLL_Sketch& other) {
+            if (other.count == 0) return;
+            while (level_count < other.level_count) add_level();
+
+            for (uint32_t h = 0 ; h < other.level_count ; ++h) {
+                for (uint32_t i = other.levels[h] ; i < other.levels[h + 1] ; ++i) insert(h, other.items[i]);
+            }
+
+            track(other.min_value, other.max_value);
+            count += other.count;
+        }
+
+        /**
+         * @brief Estimate a quantile. Sorts each level in place, which
+         *        doesn't change what the sketch holds.
+         *
+         * @param rank: The rank in basis points, 0 to KLL_RANK_ONE.
+         *
+         * @retval The estimated value at that rank, or 0 if the sketch is empty.
+         */
+        T get_quantile(uint32_t rank) {
+            if (count == 0) return 0;
+            if (rank == 0) return min_value;
+            if (rank >= KLL_RANK_ONE) return max_value;
+
+            // Compaction preserves total weight, so it equals `count`
+            const uint64_t target = ((uint64_t)count * rank + KLL_RANK_ONE - 1) / KLL_RANK_ONE;
+            uint16_t cursor[MAX_LEVELS];
+            for (uint32_t h = 0 ; h < level_count ; ++h) {
+                std::sort(items + levels[h], items + levels[h + 1]);
+                cursor[h] = (uint16_t)levels[h];
+            }
+
+            // Merge the sorted levels, summing weights to the target
+            uint64_t weight = 0;
+            while (true) {
+                int32_t next = -1;
+                for (uint32_t h = 0 ; h < level_count ; ++h) {
+                    if (cursor[h] < levels[h + 1] && (next < 0 || items[cursor[h]] < items[cursor[next]])) next = (int32_t)h;
+                }
+
+                if (next < 0) return max_value;
+                weight += (uint64_t)1 << next;
+                const T value = items[cursor[next]++];
+                if (weight >= target) return value;
+            }
+        }
+
+        uint32_t get_count() const                  { return count; }
+        T get_min() const                           { return min_value; }
+        T get_max() const                           { return max_value; }
+        uint32_t get_retained() const               { return CAPACITY - levels[0]; }
+        uint32_t get_level_count() const            { return level_count; }
+        uint32_t get_level_size(uint32_t h) const   { return h < level_count ? levels[h + 1] - levels[h] : 0; }
+        const T* get_level(uint32_t h) const        { return items + levels[h]; }
+
+        /**
+         * @brief Write the sketch to STDIO as one line, for `Tools/kll_merge.py`:
+         *        `KLL,<unit>,<K>,<count>,<min>,<max>,<levels>,<level sizes>...,<items>...`
+         *
+         * @param unit: The source's identity, eg. the board ID.
+         */
+        void write_snapshot(const char* unit) const {
+            printf("KLL,%s,%lu,%lu,%li,%li,%lu", unit, (unsigned long)K, (unsigned long)count,
+                   (long)min_value, (long)max_value, (unsigned long)level_count);
+            for (uint32_t h = 0 ; h < level_count ; ++h) printf(",%lu", (unsigned long)get_level_size(h));
+            for (uint32_t i = levels[0] ; i < CAPACITY ; ++i) printf(",%li", (long)items[i]);
+            printf("\n");
+        }
+
+    private:
+        T           items[CAPACITY];
+        // Level h is items[levels[h]] to items[levels[h + 1] - 1]. Free space is below level 0
+        uint32_t    levels[MAX_LEVELS + 1];
+        uint32_t    level_count;
+        uint32_t    count;
+        T           min_value;
+        T           max_value;
+        uint32_t    random;
+
+        void track(T low, T high) {
+            if (count == 0 || low < min_value) min_value = low;
+            if (count == 0 || high > max_value) max_value = high;
+        }
+
+        /**
+         * @brief The most items level h may hold: K at the top, two thirds
+         *        of the level above below that, and never fewer than two.
+         */
+        uint32_t capacity(uint32_t h) const {
+            uint32_t cap = K;
+            for (uint32_t depth = level_count - 1 - h ; depth > 0 && cap > 2 ; --depth) cap = (cap * 2 + 2) / 3;
+            return cap < 2 ? 2 : cap;
+        }
+
+        void add_level() {
+            if (level_count == MAX_LEVELS) return;
+            level_count++;
+            levels[level_count] = CAPACITY;
+        }
+
+        /**
+         * @brief Free space by compacting the lowest level at capacity.
+         *        The array only fills when the levels together reach
+         *        their capacities, so there is always one to compact.
+         */
+        void compress() {
+            for (uint32_t h = 0 ; h < level_count ; ++h) {
+                if (levels[h + 1] - levels[h] < capacity(h)) continue;
+                if (h + 1 == level_count) add_level();
+                compact(h);
+                return;
+            }
+        }
+
+        /**
+         * @brief Sort level h and promote every other item to level h + 1,
+         *        which is adjacent above it. An odd item out stays behind.
+         *        The levels below then shift up into the space released.
+         */
+        void compact(uint32_t h) {
+            const uint32_t start = levels[h];
+            const uint32_t end = levels[h + 1];
+            std::sort(items + start, items + end);
+
+            random ^= random << 13;
+            random ^= random >> 17;
+            random ^= random << 5;
+            const uint32_t offset = random & 1;
+
+            // The pairs start after any odd item. Fill from the top down:
+            // each destination is at or above every source still unread
+            const uint32_t first = start + ((end - start) & 1);
+            const uint32_t half = (end - first) / 2;
+            for (uint32_t i = half ; i > 0 ; --i) items[first + half + i - 1] = items[first + 2 * (i - 1) + offset];
+
+            memmove(items + levels[0] + half, items + levels[0], (first - levels[0]) * sizeof(T));
+            for (uint32_t i = 0 ; i <= h ; ++i) levels[i] += half;
+            levels[h + 1] = end - half;
+        }
+
+        /**
+         * @brief Add one item to the top of level h, for merging.
+         */
+        void insert(uint32_t h, T value) {
+            if (levels[0] == 0) compress();
+            const uint32_t end = levels[h + 1];
+            memmove(items + levels[0] - 1, items + levels[0], (end - levels[0]) * sizeof(T));
+            items[end - 1] = value;
+            for (uint32_t i = 0 ; i <= h ; ++i) levels[i]--;
+        }
+};
+
+
+#endif  // KLL_HEADER
@@ -20,6 +20,7 @@ using std::string;
 MCP9808::MCP9808(uint32_t address) {
     if (address == 0x00 || address > 0xFF) address = MCP9808_I2CADDR_DEFAULT;
     i2c_addr = address;
+    config_msb = 0;
     
     // Set defaults
     limit_lower = DEFAULT_TEMP_LOWER_LIMIT_C;
@@ -71,13 +72,42 @@ bool MCP9808::begin() {
  * @retval The temperature in Celsius.
  */
 double MCP9808::read_temp() {
+    return read_temp_fixed().to_double();
+}
+
+
+/**
+ * @brief Read the temperature without floating-point arithmetic.
+ *
+ * @retval The temperature in Celsius, to 1/16 of a degree.
+ */
+Fixed<4> MCP9808::read_temp_fixed() {
+    return read_sample().temp;
+}
+
+
+/**
+ * @brief Read the temperature and the alert flags that accompany it.
+ *
+ * @retval The temperature in Celsius, and MCP9808_FLAG_* bits.
+ */
+MCP9808_Sample MCP9808::read_sample() {
     // Read sensor and return its value in degrees celsius.
     uint8_t temp_data[2] = {0};
     I2C::write_byte(i2c_addr, MCP9808_REG_AMBIENT_TEMP);
     I2C::read_block(i2c_addr, temp_data, 2);
 
-    // Scale and convert to signed value.
-    return get_temp(temp_data);
+    // Scale and convert to signed value; keep the flag bits
+    MCP9808_Sample sample;
+    sample.temp = get_temp(temp_data);
+    sample.flags = (temp_data[0] >> 5) & MCP9808_FLAGS_ALL;
+
+    // Q4 to millidegrees: x 1000 / 16
+    Metrics::add(Metrics::Counter::MCP9808_READS);
+    Metrics::set(Metrics::Gauge::MCP9808_TEMPERATURE, sample.temp.raw * 125 / 2);
+    Metrics::set(Metrics::Gauge::MCP9808_FLAGS, sample.flags);
+    if (sample.flags != 0) Metrics::add(Metrics::Counter::MCP9808_ALERT_READS);
+    return sample;
 }
 
 
@@ -94,6 +124,7 @@ void MCP9808::clear_alert(bool do_enable) {
     I2C::read_block(i2c_addr, &config_data[1], 2);
 
     // Set LSB bit 5 to clear the interrupt, and write it back
+    config_msb = config_data[1];
     config_data[0] = MCP9808_REG_CONFIG;
     config_data[2] = 0x21;
 
@@ -117,6 +148,24 @@ void MCP9808::clear_alert(bool do_enable) {
 }
 
 
+/**
+ * @brief Switch the enabled alert output between comparator mode, in
+ *        which it tracks the temperature and needs no clearing, and
+ *        interrupt mode, in which it latches until cleared. Either way,
+ *        any latched interrupt is cleared by the same single write.
+ *
+ *        NOTE Call `begin()` first: it caches the CONFIG MSB.
+ *
+ * @param comparator: `true` for comparator mode, `false` for interrupt mode.
+ */
+void MCP9808::set_alert_mode(bool comparator) {
+    uint8_t config_data[3] = {MCP9808_REG_CONFIG, config_msb, 0};
+    config_data[2] = MCP9808_CONFIG_CLR_ALRT_INT | MCP9808_CONFIG_ENABLE_ALRT;
+    if (!comparator) config_data[2] |= MCP9808_CONFIG_ALRT_MODE;
+    I2C::write_block(i2c_addr, config_data, 3);
+}
+
+
 /**
  * @brief Set the sensor upper threshold temperature.
  *
@@ -178,20 +227,20 @@ void MCP9808::set_temp_limit(uint8_t temp_register, uint16_t temp) {
 
     I2C::write_byte(i2c_addr, temp_register);
     I2C::read_block(i2c_addr, data, 2);
-    double temp_cel = get_temp(data);
-    printf("[DEBUG] %s: %.01f\n", reg_name.c_str(), temp_cel);
+    char temp_cel[12];
+    get_temp(data).to_chars(temp_cel, sizeof(temp_cel), 1);
+    printf("[DEBUG] %s: %s\n", reg_name.c_str(), temp_cel);
     #endif
 }
 
 
 /**
- * @brief Calculate the temperature.
+ * @brief Calculate the temperature. Bits 0-12 of a temperature register
+ *        hold a two's complement value in 1/16ths of a degree.
  *
  * @retval The temperature in Celsius.
  */
-double MCP9808::get_temp(uint8_t* data) {
+Fixed<4> MCP9808::get_temp(uint8_t* data) {
     const uint32_t temp_raw = (data[0] << 8) | data[1];
-    double temp_cel = (temp_raw & 0x0FFF) / 16.0;
-    if (temp_raw & 0x1000) temp_cel = 256.0 - temp_cel;
-    return temp_cel;
+    return Fixed<4>::from_field<0, 12, 4>(temp_raw);
 }
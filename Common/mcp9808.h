@@ -25,14 +25,16 @@
 #include "pico/binary_info.h"
 #include "hardware/i2c.h"
 // App
+#include "board.h"
 #include "i2c_utils.h"
+#include "fixed.h"
 #include "utils.h"
 
 
 /*
  * PROTOTYPES
  */
-// Default I2C address for device
+// The device's address with A0-A2 low. Boards set the address in use
 #define MCP9808_I2CADDR_DEFAULT     0x18
 
 // Register addresses
@@ -49,10 +51,25 @@
 #define MCP9808_CONFIG_ALRT_POL     0x02
 #define MCP9808_CONFIG_ALRT_MODE    0x01
 
+// Alert flags carried in bits 13-15 of every ambient temperature read
+#define MCP9808_FLAG_LOWER          0x01
+#define MCP9808_FLAG_UPPER          0x02
+#define MCP9808_FLAG_CRIT           0x04
+#define MCP9808_FLAGS_ALL           0x07
+
 #define DEFAULT_TEMP_LOWER_LIMIT_C  10
 #define DEFAULT_TEMP_UPPER_LIMIT_C  25
 #define DEFAULT_TEMP_CRIT_LIMIT_C   50
 
+/**
+    A temperature reading plus the sensor's alert flags at the time.
+ */
+struct MCP9808_Sample {
+    Fixed<4>    temp;
+    uint8_t     flags;
+};
+
+
 /**
     A very basic driver for the I2C-connected MCP9808 temperature sensor.
  */
@@ -60,11 +77,14 @@ class MCP9808 {
 
     public:
         // Constructor
-        MCP9808(uint32_t i2c_address = MCP9808_I2CADDR_DEFAULT);
+        MCP9808(uint32_t i2c_address = Board::SENSOR_ADDRESS);
 
         bool        begin();
         double      read_temp();
+        Fixed<4>    read_temp_fixed();
+        MCP9808_Sample  read_sample();
         void        clear_alert(bool do_enable);
+        void        set_alert_mode(bool comparator);
         void        set_upper_limit(uint16_t upper_temp = DEFAULT_TEMP_UPPER_LIMIT_C);
         void        set_lower_limit(uint16_t lower_temp = DEFAULT_TEMP_LOWER_LIMIT_C);
         void        set_critical_limit(uint16_t critical_temp = DEFAULT_TEMP_CRIT_LIMIT_C);
@@ -75,9 +95,10 @@ class MCP9808 {
         uint16_t    limit_upper;
     
     private:
-        double      get_temp(uint8_t* data);
+        Fixed<4>    get_temp(uint8_t* data);
 
         uint8_t     i2c_addr;
+        uint8_t     config_msb;
 };
 
 
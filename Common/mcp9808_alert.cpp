@@ -0,0 +1,81 @@
+/**
+ * RP2040 FreeRTOS Template - App #3
+ * MCP9808 alert state machine
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#include "mcp9808_alert.h"
+
+
+/**
+ * @brief Constructor: instantiate a new alert state machine.
+ *
+ * @param sensor: The MCP9808 whose alert output is managed.
+ */
+MCP9808_Alert::MCP9808_Alert(MCP9808& sensor) : sensor(sensor) {
+    state = Alert_State::ARMED;
+}
+
+
+/**
+ * @brief Put the sensor into interrupt mode, clearing any latched
+ *        interrupt, and wait for the pin to assert.
+ */
+void MCP9808_Alert::arm() {
+    sensor.set_alert_mode(false);
+    state = Alert_State::ARMED;
+}
+
+
+/**
+ * @brief Record that the alert pin asserted. Makes no I2C transactions,
+ *        so it may be called from any task.
+ */
+void MCP9808_Alert::trigger() {
+    if (state == Alert_State::ARMED) state = Alert_State::TRIGGERED;
+}
+
+
+/**
+ * @brief Advance the state machine with the flags from the latest sample.
+ *        Call from the task that reads the sensor.
+ *
+ * @param flags: The `MCP9808_Sample` flags.
+ *
+ * @retval RAISED when the alert has been taken over in comparator mode,
+ *         CLEARED when the temperature is back in its window and the
+ *         sensor has been re-armed, otherwise NONE.
+ */
+Alert_Event MCP9808_Alert::update(uint8_t flags) {
+    switch (state) {
+        case Alert_State::TRIGGERED:
+            // One write both acknowledges the latched interrupt and stops
+            // it re-latching while the temperature stays out of range
+            sensor.set_alert_mode(true);
+            state = Alert_State::ACTIVE;
+            return Alert_Event::RAISED;
+        case Alert_State::ACTIVE:
+            if ((flags & MCP9808_FLAGS_ALL) == 0) {
+                arm();
+                return Alert_Event::CLEARED;
+            }
+            break;
+        default:
+            break;
+    }
+
+    return Alert_Event::NONE;
+}
+
+
+/**
+ * @brief Get the current alert state.
+ *
+ * @retval The state.
+ */
+Alert_State MCP9808_Alert::get_state() const {
+    return state;
+}
@@ -0,0 +1,61 @@
+/**
+ * RP2040 FreeRTOS Template - App #3
+ * MCP9808 alert state machine
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#ifndef MCP9808_ALERT_HEADER
+#define MCP9808_ALERT_HEADER
+
+
+#include <cstdlib>
+#include <cstdint>
+// App
+#include "mcp9808.h"
+
+
+/*
+ * ENUMERATIONS
+ */
+enum class Alert_State : uint8_t {
+    ARMED,          // Interrupt mode: waiting for the pin to assert
+    TRIGGERED,      // Pin asserted: waiting for the reader to take over
+    ACTIVE          // Comparator mode: tracking the flags in each sample
+};
+
+enum class Alert_Event : uint8_t {
+    NONE,
+    RAISED,
+    CLEARED
+};
+
+
+/**
+    Drives the MCP9808 alert output between its two modes. While ARMED,
+    the sensor is in interrupt mode, so even a brief excursion latches the
+    pin. Once the alert is raised, the sensor is switched to comparator
+    mode and the alert is cleared when the flags that come with every
+    temperature read show the temperature back inside its window. Each
+    transition is one CONFIG write, made by the task that reads the
+    sensor, so the bus is only ever driven from that task.
+ */
+class MCP9808_Alert {
+
+    public:
+        MCP9808_Alert(MCP9808& sensor);
+
+        void            arm();
+        void            trigger();
+        Alert_Event     update(uint8_t flags);
+        Alert_State     get_state() const;
+
+    private:
+        MCP9808&                sensor;
+        volatile Alert_State    state;
+};
+
+
+#endif  // MCP9808_ALERT_HEADER
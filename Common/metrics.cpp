@@ -0,0 +1,178 @@
+/**
+ * RP2040 FreeRTOS Template - App #3
+ * Counters, gauges and histograms for driver hot paths
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#include "metrics.h"
+
+
+namespace Metrics {
+
+/*
+ * GLOBALS
+ */
+Shard                   shards[METRICS_SHARDS] = {};
+volatile int32_t        gauges[(uint32_t)Gauge::COUNT] = {0};
+
+struct Metric_Info {
+    const char* name;
+    const char* help;
+};
+
+#define METRICS_INFO(id, name, help) {name, help},
+static const Metric_Info counter_info[] = { METRICS_COUNTERS(METRICS_INFO) };
+static const Metric_Info gauge_info[] = { METRICS_GAUGES(METRICS_INFO) };
+static const Metric_Info histogram_info[] = { METRICS_HISTOGRAMS(METRICS_INFO) };
+#undef METRICS_INFO
+
+// Each counter, gauge and histogram is exported as one metric family
+#define METRICS_FAMILIES    ((uint32_t)Counter::COUNT + (uint32_t)Gauge::COUNT + (uint32_t)Histogram::COUNT)
+
+// The exporter's view: shard values at its last visit, and running totals
+static Shard            seen[METRICS_SHARDS] = {};
+static uint64_t         counter_totals[(uint32_t)Counter::COUNT] = {0};
+static uint64_t         bucket_totals[(uint32_t)Histogram::COUNT][METRICS_BUCKETS] = {{0}};
+static uint64_t         sum_totals[(uint32_t)Histogram::COUNT] = {0};
+
+static uint32_t         export_period_ms = 0;
+
+
+/**
+ * @brief Fold each shard's change since the last call into the totals.
+ *        Shards are read without locking: each 32-bit load is atomic,
+ *        and unsigned subtraction absorbs wrap-around. Call from one
+ *        task only -- `write_openmetrics()` calls it.
+ */
+void collect() {
+    for (uint32_t s = 0 ; s < METRICS_SHARDS ; ++s) {
+        const Shard& shard = shards[s];
+        Shard& last = seen[s];
+
+        for (uint32_t i = 0 ; i < (uint32_t)Counter::COUNT ; ++i) {
+            const uint32_t now = shard.counters[i];
+            counter_totals[i] += now - last.counters[i];
+            last.counters[i] = now;
+        }
+
+        for (uint32_t i = 0 ; i < (uint32_t)Histogram::COUNT ; ++i) {
+            for (uint32_t b = 0 ; b < METRICS_BUCKETS ; ++b) {
+                const uint32_t now = shard.buckets[i][b];
+                bucket_totals[i][b] += now - last.buckets[i][b];
+                last.buckets[i][b] = now;
+            }
+
+            const uint32_t now = shard.sums[i];
+            sum_totals[i] += now - last.sums[i];
+            last.sums[i] = now;
+        }
+    }
+}
+
+
+/**
+ * @brief Write one metric family in the OpenMetrics text format.
+ *
+ * @param family: Counters first, then gauges, then histograms.
+ */
+static void write_family(uint32_t family) {
+    if (family < (uint32_t)Counter::COUNT) {
+        const uint32_t i = family;
+        printf("# TYPE %s counter\n# HELP %s %s\n%s_total %llu\n",
+               counter_info[i].name, counter_info[i].name, counter_info[i].help,
+               counter_info[i].name, (unsigned long long)counter_totals[i]);
+        return;
+    }
+
+    family -= (uint32_t)Counter::COUNT;
+    if (family < (uint32_t)Gauge::COUNT) {
+        const uint32_t i = family;
+        printf("# TYPE %s gauge\n# HELP %s %s\n%s %li\n",
+               gauge_info[i].name, gauge_info[i].name, gauge_info[i].help,
+               gauge_info[i].name, (long)gauges[i]);
+        return;
+    }
+
+    const uint32_t i = family - (uint32_t)Gauge::COUNT;
+    const char* name = histogram_info[i].name;
+    printf("# TYPE %s histogram\n# HELP %s %s\n", name, name, histogram_info[i].help);
+
+    // Buckets are cumulative. Bucket b holds values up to 2^b - 1
+    uint64_t count = 0;
+    for (uint32_t b = 0 ; b < METRICS_BUCKETS - 1 ; ++b) {
+        count += bucket_totals[i][b];
+        printf("%s_bucket{le=\"%lu\"} %llu\n", name, (unsigned long)((1u << b) - 1), (unsigned long long)count);
+    }
+
+    count += bucket_totals[i][METRICS_BUCKETS - 1];
+    printf("%s_bucket{le=\"+Inf\"} %llu\n%s_sum %llu\n%s_count %llu\n",
+           name, (unsigned long long)count,
+           name, (unsigned long long)sum_totals[i],
+           name, (unsigned long long)count);
+}
+
+
+/**
+ * @brief Write a snapshot of every metric to STDIO in the OpenMetrics
+ *        text format, ending with `# EOF`.
+ */
+void write_openmetrics() {
+    collect();
+    for (uint32_t i = 0 ; i < METRICS_FAMILIES ; ++i) write_family(i);
+    printf("# EOF\n");
+}
+
+
+/**
+ * @brief Write the next part of a snapshot: one metric family, so that
+ *        a snapshot can be spread over short runs, eg. of idle work. The
+ *        first call collects, and the last writes `# EOF`.
+ *
+ * @retval `true` if there is more of the snapshot to write, otherwise `false`.
+ */
+bool write_openmetrics_next() {
+    static uint32_t next = 0;
+    if (next == 0) collect();
+
+    write_family(next++);
+    if (next < METRICS_FAMILIES) return true;
+
+    printf("# EOF\n");
+    next = 0;
+    return false;
+}
+
+
+/**
+ * @brief The exporter task: write a snapshot every `export_period_ms`.
+ */
+static void task_exporter(void* unused_arg) {
+    TickType_t last_wake = xTaskGetTickCount();
+    while (true) {
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(export_period_ms));
+        write_openmetrics();
+    }
+}
+
+
+/**
+ * @brief Start a task that writes a snapshot periodically.
+ *
+ * @param period_ms: The time between snapshots.
+ * @param priority:  The exporter task's priority.
+ *
+ * @retval `true` if the task was created, otherwise `false`.
+ */
+bool start_exporter(uint32_t period_ms, UBaseType_t priority) {
+    if (export_period_ms > 0) return true;
+    export_period_ms = period_ms;
+    if (xTaskCreate(task_exporter, "METRICS_TASK", METRICS_EXPORTER_STACK, NULL, priority, NULL) == pdPASS) return true;
+    export_period_ms = 0;
+    return false;
+}
+
+
+}   // namespace Metrics
@@ -0,0 +1,135 @@
+/**
+ * RP2040 FreeRTOS Template - App #3
+ * Counters, gauges and histograms for driver hot paths
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#ifndef METRICS_HEADER
+#define METRICS_HEADER
+
+
+#include <cstdlib>
+#include <cstdint>
+// FreeRTOS
+#include <FreeRTOS.h>
+#include <task.h>
+// Pico SDK
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+
+
+/*
+ * CONSTANTS
+ */
+// One shard per core, so each core only ever writes its own
+#define METRICS_SHARDS              2
+// Log2 histogram buckets: 0, 1, 2-3, 4-7 ... the last takes everything larger
+#define METRICS_BUCKETS             16
+#define METRICS_EXPORTER_STACK      512
+
+
+/*
+ * METRIC DECLARATIONS
+ */
+// Add a metric with a line in one of these lists: X(id, name, help).
+// Names follow OpenMetrics conventions; counters gain `_total` on export
+#define METRICS_COUNTERS(X) \
+    X(I2C_WRITES,           "i2c_writes",                       "Blocking I2C writes") \
+    X(I2C_READS,            "i2c_reads",                        "Blocking I2C reads") \
+    X(I2C_BYTES,            "i2c_bytes",                        "Bytes moved by blocking I2C transfers") \
+    X(I2C_QUEUED,           "i2c_queued",                       "Non-blocking I2C transfers queued") \
+    X(I2C_ERRORS,           "i2c_errors",                       "I2C transfers the device did not acknowledge") \
+    X(MCP9808_READS,        "mcp9808_reads",                    "MCP9808 temperature reads") \
+    X(MCP9808_ALERT_READS,  "mcp9808_alert_reads",              "MCP9808 reads with an alert flag set") \
+    X(HT16K33_DRAWS,        "ht16k33_draws",                    "HT16K33 display buffer writes") \
+    X(TREND_WARNINGS,       "trend_warnings",                   "Early warnings of the upper temperature limit")
+
+#define METRICS_GAUGES(X) \
+    X(MCP9808_TEMPERATURE,  "mcp9808_temperature_millicelsius", "Last MCP9808 temperature") \
+    X(MCP9808_FLAGS,        "mcp9808_alert_flags",              "Last MCP9808 alert flag bits") \
+    X(TREND_TIME_TO_LIMIT,  "trend_time_to_limit_milliseconds", "Projected time to the upper limit, or -1 if none")
+
+#define METRICS_HISTOGRAMS(X) \
+    X(I2C_TRANSFER_US,      "i2c_transfer_microseconds",        "Blocking I2C transfer time") \
+    X(HT16K33_DRAW_US,      "ht16k33_draw_microseconds",        "HT16K33 display update time")
+
+
+namespace Metrics {
+
+#define METRICS_ID(id, name, help) id,
+enum class Counter : uint32_t {
+    METRICS_COUNTERS(METRICS_ID)
+    COUNT
+};
+
+enum class Gauge : uint32_t {
+    METRICS_GAUGES(METRICS_ID)
+    COUNT
+};
+
+enum class Histogram : uint32_t {
+    METRICS_HISTOGRAMS(METRICS_ID)
+    COUNT
+};
+#undef METRICS_ID
+
+
+/**
+    One core's share of the registry. 32-bit values wrap; the exporter
+    folds the change since its last visit into 64-bit totals.
+ */
+struct Shard {
+    uint32_t    counters[(uint32_t)Counter::COUNT];
+    uint32_t    buckets[(uint32_t)Histogram::COUNT][METRICS_BUCKETS];
+    uint32_t    sums[(uint32_t)Histogram::COUNT];
+};
+
+extern Shard                shards[METRICS_SHARDS];
+extern volatile int32_t     gauges[(uint32_t)Gauge::COUNT];
+
+
+/*
+ * UPDATES
+ *
+ * Safe from any task or ISR on either core. An update touches only the
+ * calling core's shard, with interrupts held off for the few cycles of
+ * the read-modify-write, so it never waits on another updater.
+ */
+
+inline void add(Counter id, uint32_t count = 1) {
+    const uint32_t state = save_and_disable_interrupts();
+    shards[get_core_num()].counters[(uint32_t)id] += count;
+    restore_interrupts(state);
+}
+
+inline void set(Gauge id, int32_t value) {
+    gauges[(uint32_t)id] = value;
+}
+
+inline void observe(Histogram id, uint32_t value) {
+    uint32_t bucket = value == 0 ? 0 : 32 - __builtin_clz(value);
+    if (bucket >= METRICS_BUCKETS) bucket = METRICS_BUCKETS - 1;
+
+    const uint32_t state = save_and_disable_interrupts();
+    Shard& shard = shards[get_core_num()];
+    shard.buckets[(uint32_t)id][bucket] += 1;
+    shard.sums[(uint32_t)id] += value;
+    restore_interrupts(state);
+}
+
+
+/*
+ * EXPORT
+ */
+void    collect();
+void    write_openmetrics();
+bool    write_openmetrics_next();
+bool    start_exporter(uint32_t period_ms, UBaseType_t priority);
+
+}   // namespace Metrics
+
+
+#endif  // METRICS_HEADER
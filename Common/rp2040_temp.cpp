@@ -0,0 +1,170 @@
+/**
+ * RP2040 FreeRTOS Template - App #3
+ * DMA-driven capture of the RP2040's on-die temperature sensor
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#include "rp2040_temp.h"
+
+
+/*
+ * GLOBALS
+ */
+// The sensor's reader, for the DMA IRQ handler
+static RP2040_Temp* reader = nullptr;
+
+
+/**
+ * @brief Constructor: instantiate an idle reader.
+ */
+RP2040_Temp::RP2040_Temp() {
+    channels[0] = -1;
+    channels[1] = -1;
+    filtered_sum = 0;
+    buffer_count = 0;
+}
+
+
+/**
+ * @brief Set up the ADC and DMA, and start converting.
+ *
+ * @retval `true` if capture started, otherwise `false`.
+ */
+bool RP2040_Temp::begin() {
+    if (reader != nullptr) return false;
+
+    channels[0] = dma_claim_unused_channel(false);
+    channels[1] = dma_claim_unused_channel(false);
+    if (channels[0] < 0 || channels[1] < 0) {
+        end();
+        return false;
+    }
+
+    // Free-running, round robin over the sensor input alone. Each result
+    // goes to the FIFO, which raises a DREQ as soon as it holds one
+    adc_init();
+    adc_set_temp_sensor_enabled(true);
+    adc_select_input(RP2040_TEMP_ADC_INPUT);
+    adc_set_round_robin(1 << RP2040_TEMP_ADC_INPUT);
+    adc_fifo_setup(true, true, 1, false, false);
+    adc_set_clkdiv((float)(48000000 / RP2040_TEMP_SAMPLE_RATE - 1));
+
+    // 16-bit transfers from the FIFO, each channel into its own buffer.
+    // The write address wraps on the buffer size, and the transfer count
+    // reloads when the other channel triggers this one, so nothing needs
+    // to be reprogrammed between buffers
+    for (uint32_t i = 0 ; i < 2 ; ++i) {
+        dma_channel_config config = dma_channel_get_default_config(channels[i]);
+        channel_config_set_transfer_data_size(&config, DMA_SIZE_16);
+        channel_config_set_read_increment(&config, false);
+        channel_config_set_write_increment(&config, true);
+        channel_config_set_ring(&config, true, RP2040_TEMP_BUFFER_BITS);
+        channel_config_set_dreq(&config, DREQ_ADC);
+        channel_config_set_chain_to(&config, channels[i ^ 1]);
+        dma_channel_configure(channels[i], &config, buffers[i], &adc_hw->fifo, RP2040_TEMP_BUFFER_SAMPLES, false);
+        dma_channel_set_irq1_enabled(channels[i], true);
+    }
+
+    // DMA_IRQ_1, so that UART_DMA_Rx can manage DMA_IRQ_0 as its own
+    reader = this;
+    irq_add_shared_handler(DMA_IRQ_1, dma_isr, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    irq_set_enabled(DMA_IRQ_1, true);
+
+    dma_channel_start(channels[0]);
+    adc_run(true);
+    return true;
+}
+
+
+/**
+ * @brief Stop converting and release the DMA channels.
+ */
+void RP2040_Temp::end() {
+    const bool running = reader == this;
+    if (running) {
+        adc_run(false);
+        irq_remove_handler(DMA_IRQ_1, dma_isr);
+        reader = nullptr;
+    }
+
+    for (uint32_t i = 0 ; i < 2 ; ++i) {
+        if (channels[i] < 0) continue;
+        dma_channel_set_irq1_enabled(channels[i], false);
+        dma_channel_abort(channels[i]);
+        dma_channel_unclaim(channels[i]);
+        channels[i] = -1;
+    }
+
+    if (running) {
+        adc_fifo_drain();
+        adc_set_temp_sensor_enabled(false);
+    }
+
+    buffer_count = 0;
+}
+
+
+/**
+ * @brief Whether the filter has seen enough buffers to settle.
+ */
+bool RP2040_Temp::is_ready() const {
+    return buffer_count >= (1 << RP2040_TEMP_FILTER_SHIFT);
+}
+
+
+/**
+ * @brief Convert the filtered sum to a temperature:
+ *        T = 27 - (V - 0.706) / 0.001721, with V the mean voltage.
+ *
+ * @retval The temperature in Celsius.
+ */
+Fixed<4> RP2040_Temp::read_temp() const {
+    // Sum of 2^n 12-bit samples: the mean voltage is
+    // sum * Vref / 2^(n + 12), here in microvolts
+    const int32_t uv = (int32_t)(((uint64_t)filtered_sum * RP2040_TEMP_VREF_UV) >> RP2040_TEMP_SUM_BITS);
+    int32_t unused = 0;
+    const int32_t delta = FixedMath::divmod_s32((uv - RP2040_TEMP_V27_UV) * Fixed<4>::ONE, RP2040_TEMP_SLOPE_UV, &unused);
+    return Fixed<4>::from_raw(27 * Fixed<4>::ONE - delta);
+}
+
+
+/**
+ * @brief The number of buffers filled since `begin()`.
+ */
+uint32_t RP2040_Temp::get_buffers() const {
+    return buffer_count;
+}
+
+
+/**
+ * @brief Sum a full buffer and fold it into the filter. Called in the
+ *        DMA ISR, while the other channel fills the other buffer.
+ */
+void __not_in_flash_func(RP2040_Temp::buffer_done)(uint32_t index) {
+    const uint16_t* samples = buffers[index];
+    uint32_t sum = 0;
+    for (uint32_t i = 0 ; i < RP2040_TEMP_BUFFER_SAMPLES ; ++i) sum += samples[i] & 0x0FFF;
+
+    // Start the filter at the first sum, rather than let it climb from zero
+    const uint32_t last = filtered_sum;
+    filtered_sum = buffer_count == 0 ? sum : (uint32_t)((int32_t)last + (((int32_t)sum - (int32_t)last) >> RP2040_TEMP_FILTER_SHIFT));
+    buffer_count = buffer_count + 1;
+}
+
+
+/**
+ * @brief Shared DMA IRQ handler: process whichever buffer just filled.
+ */
+void __not_in_flash_func(RP2040_Temp::dma_isr)() {
+    if (reader == nullptr) return;
+
+    for (uint32_t i = 0 ; i < 2 ; ++i) {
+        if (!dma_channel_get_irq1_status(reader->channels[i])) continue;
+
+        dma_channel_acknowledge_irq1(reader->channels[i]);
+        reader->buffer_done(i);
+    }
+}
@@ -0,0 +1,84 @@
+/**
+ * RP2040 FreeRTOS Template - App #3
+ * DMA-driven capture of the RP2040's on-die temperature sensor
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#ifndef RP2040_TEMP_HEADER
+#define RP2040_TEMP_HEADER
+
+
+#include <cstdlib>
+#include <cstdint>
+// Pico SDK
+#include "pico/stdlib.h"
+#include "hardware/adc.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+// App
+#include "fixed.h"
+
+
+/*
+ * CONSTANTS
+ */
+// The sensor is ADC input 4, which has no GPIO
+#define RP2040_TEMP_ADC_INPUT       4
+// Conversions per second, from the ADC's 48MHz clock
+#define RP2040_TEMP_SAMPLE_RATE     10000
+// Samples per buffer: a power of two, as each DMA ring wraps on an address bit.
+// 256 16-bit samples wrap on bit 9, and take 25.6ms to fill
+#define RP2040_TEMP_BUFFER_BITS     9
+#define RP2040_TEMP_BUFFER_SAMPLES  ((1 << RP2040_TEMP_BUFFER_BITS) / 2)
+#define RP2040_TEMP_SUM_BITS        (RP2040_TEMP_BUFFER_BITS - 1 + 12)
+// Each buffer's sum moves the filtered sum 1/2^n of the way: 8 buffers, or
+// about 200ms, to cover 63% of a step
+#define RP2040_TEMP_FILTER_SHIFT    3
+// Sensor transfer function from the RP2040 datasheet, in microvolts
+#define RP2040_TEMP_VREF_UV         3300000
+#define RP2040_TEMP_V27_UV          706000
+#define RP2040_TEMP_SLOPE_UV        1721
+
+
+/**
+    Reads the RP2040's own temperature sensor with no CPU work per
+    conversion. The ADC converts continuously. Two DMA channels take turns
+    to copy its FIFO into a pair of buffers, each chaining to the other,
+    so no conversions are lost while a buffer is handed over. Each channel
+    raises an interrupt when its buffer fills. The ISR adds the samples
+    up and folds the sum into an exponential filter, so a reading is the
+    oversampled, filtered value. Ready about 200ms after `begin()`.
+
+    The sensor is on the die, so it reads high when the chip is busy, and
+    its slope and offset vary from part to part: expect a few degrees of
+    error without calibration. There is one sensor, so one instance.
+ */
+class RP2040_Temp {
+
+    public:
+        RP2040_Temp();
+
+        bool            begin();
+        void            end();
+
+        bool            is_ready() const;
+        Fixed<4>        read_temp() const;
+
+        uint32_t        get_buffers() const;
+
+    private:
+        static void     dma_isr();
+        void            buffer_done(uint32_t index);
+
+        alignas(RP2040_TEMP_BUFFER_SAMPLES * 2) uint16_t buffers[2][RP2040_TEMP_BUFFER_SAMPLES];
+
+        int                 channels[2];
+        volatile uint32_t   filtered_sum;
+        volatile uint32_t   buffer_count;
+};
+
+
+#endif  // RP2040_TEMP_HEADER
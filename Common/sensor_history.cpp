@@ -0,0 +1,225 @@
+/**
+ * RP2040 FreeRTOS Template - App #3
+ * A ring of past sensor readings, exportable as CSV or binary files
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#include "sensor_history.h"
+
+
+static_assert((SENSOR_HISTORY_CAPACITY & (SENSOR_HISTORY_CAPACITY - 1)) == 0, "SENSOR_HISTORY_CAPACITY must be a power of two");
+static_assert(SENSOR_HISTORY_HEADROOM > 0 && SENSOR_HISTORY_HEADROOM < SENSOR_HISTORY_CAPACITY, "SENSOR_HISTORY_HEADROOM must leave room to freeze and to add");
+
+
+/*
+ * STATIC FUNCTIONS
+ */
+
+/**
+ * @brief Write `value` as exactly `digits` decimal digits, zero-padded.
+ */
+static void put_digits(char* at, uint32_t value, uint32_t digits) {
+    for (uint32_t i = digits ; i > 0 ; --i) {
+        at[i - 1] = (char)('0' + value % 10);
+        value /= 10;
+    }
+}
+
+
+/**
+ * @brief Constructor: an empty history.
+ */
+Sensor_History::Sensor_History() {
+    total = 0;
+    frozen_first = 0;
+    frozen_count = 0;
+    dropped = 0;
+}
+
+
+/**
+ * @brief Add a reading, replacing the oldest if the history is full,
+ *        unless that is a frozen reading: then drop the new one.
+ */
+void Sensor_History::add(const History_Record& record) {
+    // The slot to fill holds reading `total` - SENSOR_HISTORY_CAPACITY.
+    // `freeze()` only ever moves `frozen_first` on, so a stale value
+    // seen here drops more readings, never overwrites a frozen one
+    if (frozen_count > 0 && total - frozen_first >= SENSOR_HISTORY_CAPACITY) {
+        dropped = dropped + 1;
+        return;
+    }
+
+    records[total & (SENSOR_HISTORY_CAPACITY - 1)] = record;
+    total = total + 1;
+}
+
+
+/**
+ * @brief The number of readings held.
+ */
+uint32_t Sensor_History::get_count() const {
+    const uint32_t count = total;
+    return count < SENSOR_HISTORY_CAPACITY ? count : SENSOR_HISTORY_CAPACITY;
+}
+
+
+/**
+ * @brief Get a reading held.
+ *
+ * @param index: From 0, the oldest, to `get_count()` - 1.
+ */
+History_Record Sensor_History::get(uint32_t index) const {
+    return records[(total - get_count() + index) & (SENSOR_HISTORY_CAPACITY - 1)];
+}
+
+
+/**
+ * @brief Fix the readings that the CSV and binary readers render: the
+ *        latest, leaving SENSOR_HISTORY_HEADROOM slots for new ones.
+ */
+void Sensor_History::freeze() {
+    const uint32_t count = total;
+    const uint32_t limit = SENSOR_HISTORY_CAPACITY - SENSOR_HISTORY_HEADROOM;
+    const uint32_t held = count < limit ? count : limit;
+    frozen_first = count - held;
+    frozen_count = held;
+}
+
+
+uint32_t Sensor_History::get_frozen_count() const {
+    return frozen_count;
+}
+
+
+/**
+ * @brief The number of readings dropped, since boot, because the ring
+ *        was full of frozen ones.
+ */
+uint32_t Sensor_History::get_dropped_count() const {
+    return dropped;
+}
+
+
+uint32_t Sensor_History::get_csv_size() const {
+    return sizeof(SENSOR_HISTORY_CSV_HEADER) - 1 + frozen_count * SENSOR_HISTORY_CSV_ROW_SIZE;
+}
+
+
+uint32_t Sensor_History::get_binary_size() const {
+    return SENSOR_HISTORY_HEADER_SIZE + frozen_count * SENSOR_HISTORY_RECORD_SIZE;
+}
+
+
+/**
+ * @brief Render part of the frozen readings as CSV.
+ *
+ * @param history: The Sensor_History.
+ * @param offset:  The first byte to render.
+ * @param buffer:  Where to put the bytes.
+ * @param length:  The number of bytes, within `get_csv_size()`.
+ */
+void Sensor_History::read_csv(void* history, uint32_t offset, uint8_t* buffer, uint32_t length) {
+    const Sensor_History* h = (const Sensor_History*)history;
+    const uint32_t header_size = sizeof(SENSOR_HISTORY_CSV_HEADER) - 1;
+    char row[SENSOR_HISTORY_CSV_ROW_SIZE];
+
+    while (length > 0) {
+        const char* from = SENSOR_HISTORY_CSV_HEADER;
+        uint32_t start = offset;
+        uint32_t size = header_size;
+        if (offset >= header_size) {
+            const uint32_t index = (offset - header_size) / SENSOR_HISTORY_CSV_ROW_SIZE;
+            start = (offset - header_size) - index * SENSOR_HISTORY_CSV_ROW_SIZE;
+            size = SENSOR_HISTORY_CSV_ROW_SIZE;
+            h->make_csv_row(index, row);
+            from = row;
+        }
+
+        const uint32_t count = size - start < length ? size - start : length;
+        memcpy(buffer, from + start, count);
+        buffer += count;
+        offset += count;
+        length -= count;
+    }
+}
+
+
+/**
+ * @brief Render part of the frozen readings in the binary format.
+ *
+ * @param history: The Sensor_History.
+ * @param offset:  The first byte to render.
+ * @param buffer:  Where to put the bytes.
+ * @param length:  The number of bytes, within `get_binary_size()`.
+ */
+void Sensor_History::read_binary(void* history, uint32_t offset, uint8_t* buffer, uint32_t length) {
+    const Sensor_History* h = (const Sensor_History*)history;
+    uint8_t block[SENSOR_HISTORY_HEADER_SIZE];
+
+    while (length > 0) {
+        uint32_t start = offset;
+        uint32_t size = SENSOR_HISTORY_HEADER_SIZE;
+        if (offset < SENSOR_HISTORY_HEADER_SIZE) {
+            // Magic, version, record size, record count, then four zero bytes
+            memset(block, 0, sizeof(block));
+            memcpy(block, SENSOR_HISTORY_MAGIC, 4);
+            block[4] = SENSOR_HISTORY_VERSION;
+            block[6] = SENSOR_HISTORY_RECORD_SIZE;
+            for (uint32_t i = 0 ; i < 4 ; ++i) block[8 + i] = (uint8_t)(h->frozen_count >> (i * 8));
+        } else {
+            const uint32_t index = (offset - SENSOR_HISTORY_HEADER_SIZE) / SENSOR_HISTORY_RECORD_SIZE;
+            start = (offset - SENSOR_HISTORY_HEADER_SIZE) - index * SENSOR_HISTORY_RECORD_SIZE;
+            size = SENSOR_HISTORY_RECORD_SIZE;
+            h->make_binary_record(index, block);
+        }
+
+        const uint32_t count = size - start < length ? size - start : length;
+        memcpy(buffer, block + start, count);
+        buffer += count;
+        offset += count;
+        length -= count;
+    }
+}
+
+
+/**
+ * @brief Format a frozen reading as a CSV row, eg. `0000012345,+023.5625,0,0\r\n`.
+ *        A Q4 fraction is an exact four-digit decimal.
+ */
+void Sensor_History::make_csv_row(uint32_t index, char* row) const {
+    const History_Record& record = records[(frozen_first + index) & (SENSOR_HISTORY_CAPACITY - 1)];
+    const int32_t raw = record.temp_raw;
+    const uint32_t magnitude = raw < 0 ? (uint32_t)-raw : (uint32_t)raw;
+    const uint32_t whole = magnitude >> 4;
+
+    put_digits(row, record.time_ms, 10);
+    row[10] = ',';
+    row[11] = raw < 0 ? '-' : '+';
+    put_digits(row + 12, whole > 999 ? 999 : whole, 3);
+    row[15] = '.';
+    put_digits(row + 16, (magnitude & 0x0F) * 625, 4);
+    row[20] = ',';
+    row[21] = (char)('0' + (record.flags & 0x07));
+    row[22] = ',';
+    row[23] = record.on_die ? '1' : '0';
+    row[24] = '\r';
+    row[25] = '\n';
+}
+
+
+/**
+ * @brief Encode a frozen reading as eight little-endian bytes: time in
+ *        ms (4), Q4 temperature (2), alert flags (1), on-die (1).
+ */
+void Sensor_History::make_binary_record(uint32_t index, uint8_t* record) const {
+    const History_Record& from = records[(frozen_first + index) & (SENSOR_HISTORY_CAPACITY - 1)];
+    for (uint32_t i = 0 ; i < 4 ; ++i) record[i] = (uint8_t)(from.time_ms >> (i * 8));
+    record[4] = (uint8_t)from.temp_raw;
+    record[5] = (uint8_t)((uint16_t)from.temp_raw >> 8);
+    record[6] = from.flags;
+    record[7] = from.on_die;
+}
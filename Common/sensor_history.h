@@ -0,0 +1,93 @@
+/**
+ * RP2040 FreeRTOS Template - App #3
+ * A ring of past sensor readings, exportable as CSV or binary files
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#ifndef SENSOR_HISTORY_HEADER
+#define SENSOR_HISTORY_HEADER
+
+
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+
+
+/*
+ * CONSTANTS
+ */
+// 16KB of RAM: at one record every ten seconds, 5.7 hours
+#define SENSOR_HISTORY_CAPACITY     2048
+// Slots kept free of a freeze, for the readings that arrive while an
+// export is shown: at one every ten seconds, 85 minutes
+#define SENSOR_HISTORY_HEADROOM     512
+
+// Binary export: a 16-byte header, then 8-byte little-endian records
+#define SENSOR_HISTORY_MAGIC        "RPTH"
+#define SENSOR_HISTORY_VERSION      1
+#define SENSOR_HISTORY_HEADER_SIZE  16
+#define SENSOR_HISTORY_RECORD_SIZE  8
+// CSV export: a header line, then fixed-width rows such as
+// `0000012345,+023.5625,0,0` so any byte offset maps to a row
+#define SENSOR_HISTORY_CSV_HEADER   "time_ms,temp_c,flags,on_die\r\n"
+#define SENSOR_HISTORY_CSV_ROW_SIZE 26
+
+
+/**
+    One reading. The temperature is Q4, ie. 1/16C.
+ */
+struct History_Record {
+    uint32_t    time_ms;
+    int16_t     temp_raw;
+    uint8_t     flags;
+    uint8_t     on_die;
+};
+
+
+/**
+    Keeps the last SENSOR_HISTORY_CAPACITY readings. One task adds them.
+
+    For export, `freeze()` fixes the latest readings held at that moment,
+    up to SENSOR_HISTORY_CAPACITY - SENSOR_HISTORY_HEADROOM of them. The
+    CSV and binary readers then render any byte range of them, computed
+    as asked for, so an export needs no buffer of its own. The readers
+    have the `VFAT_Reader` signature, to back files on a `Virtual_FAT`.
+    Readings still arrive while frozen, and fill the headroom. Once it is
+    full, they are dropped rather than overwrite a frozen reading, until
+    the next `freeze()`.
+ */
+class Sensor_History {
+
+    public:
+        Sensor_History();
+
+        void            add(const History_Record& record);
+        uint32_t        get_count() const;
+        History_Record  get(uint32_t index) const;
+
+        void            freeze();
+        uint32_t        get_frozen_count() const;
+        uint32_t        get_dropped_count() const;
+        uint32_t        get_csv_size() const;
+        uint32_t        get_binary_size() const;
+
+        static void     read_csv(void* history, uint32_t offset, uint8_t* buffer, uint32_t length);
+        static void     read_binary(void* history, uint32_t offset, uint8_t* buffer, uint32_t length);
+
+    private:
+        void            make_csv_row(uint32_t index, char* row) const;
+        void            make_binary_record(uint32_t index, uint8_t* record) const;
+
+        History_Record      records[SENSOR_HISTORY_CAPACITY];
+        volatile uint32_t   total;
+
+        uint32_t            frozen_first;
+        uint32_t            frozen_count;
+        uint32_t            dropped;
+};
+
+
+#endif  // SENSOR_HISTORY_HEADER
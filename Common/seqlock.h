@@ -0,0 +1,114 @@
+/**
+ * RP2040 FreeRTOS Template - App #3
+ * Sequence-locked shared state for multi-word values
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#ifndef SEQLOCK_HEADER
+#define SEQLOCK_HEADER
+
+
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <atomic>
+#include <type_traits>
+
+
+/**
+    Shares a value that is too big to store in one go, such as a struct
+    or a `double`. There is one writer at a time, and any number of readers
+    in tasks, ISRs or on the other core. The writer never waits. A reader
+    copies the value and retries if a write overlapped the copy.
+
+    A plain seqlock makes readers wait for a write to finish. Under a
+    preemptive kernel, a high-priority reader can interrupt the writer
+    and then spin forever. So this keeps two copies and updates them in
+    turn. The sequence number tells readers which copy is not being
+    written. A reader only retries if the writer has moved on to the
+    other copy during the read, which needs the writer to run.
+
+    Copies are made a 32-bit word at a time, which the Cortex-M0+ does
+    atomically. Acquire and release ordering provides the barriers.
+ */
+template <typename T>
+class Seq_Lock {
+
+    static_assert(std::is_trivially_copyable_v<T>, "Seq_Lock values must be trivially copyable");
+
+    static constexpr uint32_t WORDS = (sizeof(T) + 3) / 4;
+
+    public:
+        Seq_Lock(const T& value = T()) {
+            store(0, value);
+            store(1, value);
+        }
+
+        /**
+         * @brief Publish a new value. Callers must not write concurrently.
+         */
+        void write(const T& value) {
+            uint32_t s = sequence.load(std::memory_order_relaxed);
+
+            // Odd: readers use copy 1 while copy 0 changes
+            sequence.store(++s, std::memory_order_release);
+            std::atomic_thread_fence(std::memory_order_release);
+            store(0, value);
+
+            // Even: readers use copy 0 while copy 1 changes
+            sequence.store(++s, std::memory_order_release);
+            std::atomic_thread_fence(std::memory_order_release);
+            store(1, value);
+        }
+
+        /**
+         * @brief Read the latest complete value.
+         */
+        T read() const {
+            uint32_t unused = 0;
+            return read(unused);
+        }
+
+        /**
+         * @brief Read the latest complete value, and count the retries.
+         *
+         * @param retries: Incremented for every copy a write overlapped.
+         */
+        T read(uint32_t& retries) const {
+            uint32_t words[WORDS];
+            while (true) {
+                const uint32_t s = sequence.load(std::memory_order_acquire);
+                const std::atomic<uint32_t>* from = copies[s & 1];
+                for (uint32_t i = 0 ; i < WORDS ; ++i) words[i] = from[i].load(std::memory_order_relaxed);
+
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (sequence.load(std::memory_order_relaxed) == s) break;
+                retries++;
+            }
+
+            T value;
+            memcpy(&value, words, sizeof(T));
+            return value;
+        }
+
+        // The number of writes so far, times two
+        uint32_t get_sequence() const {
+            return sequence.load(std::memory_order_acquire);
+        }
+
+    private:
+        std::atomic<uint32_t>   copies[2][WORDS];
+        std::atomic<uint32_t>   sequence {0};
+
+        void store(uint32_t index, const T& value) {
+            uint32_t words[WORDS] = {0};
+            memcpy(words, &value, sizeof(T));
+            for (uint32_t i = 0 ; i < WORDS ; ++i) copies[index][i].store(words[i], std::memory_order_relaxed);
+        }
+};
+
+
+#endif  // SEQLOCK_HEADER
@@ -0,0 +1,82 @@
+/**
+ * RP2040 FreeRTOS Template - App #5
+ * Lock-free single-producer, single-consumer ring buffer
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#ifndef SPSC_HEADER
+#define SPSC_HEADER
+
+
+#include <cstdlib>
+#include <cstdint>
+#include <atomic>
+
+
+/**
+    A fixed-size ring for passing items from one producer to one consumer
+    with no locks and no critical sections, eg. from a zero-latency ISR
+    on core 1 to a task on core 0. Each index has a single writer, and
+    only 32-bit loads and stores are used, which the Cortex-M0+ performs
+    atomically; acquire and release ordering supplies the barriers.
+    `SIZE` must be a power of two. A push to a full ring is dropped and
+    counted rather than overwriting unread items.
+ */
+template <typename T, uint32_t SIZE>
+class SPSC_Buffer {
+
+    static_assert(SIZE > 0 && (SIZE & (SIZE - 1)) == 0, "SPSC_Buffer SIZE must be a power of two");
+
+    public:
+        /**
+         * @brief Producer only: append an item.
+         *
+         * @retval `true` if the item was added, `false` if the ring is full.
+         */
+        bool push(const T& item) {
+            const uint32_t h = head.load(std::memory_order_relaxed);
+            if (h - tail.load(std::memory_order_acquire) >= SIZE) {
+                dropped = dropped + 1;
+                return false;
+            }
+
+            items[h & (SIZE - 1)] = item;
+            head.store(h + 1, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * @brief Consumer only: remove the oldest item.
+         *
+         * @retval `true` if `item` was filled, `false` if the ring is empty.
+         */
+        bool pop(T& item) {
+            const uint32_t t = tail.load(std::memory_order_relaxed);
+            if (t == head.load(std::memory_order_acquire)) return false;
+
+            item = items[t & (SIZE - 1)];
+            tail.store(t + 1, std::memory_order_release);
+            return true;
+        }
+
+        uint32_t count() const {
+            return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+        }
+
+        // Producer-side count of pushes refused because the ring was full
+        uint32_t get_dropped() const {
+            return dropped;
+        }
+
+    private:
+        T                       items[SIZE];
+        std::atomic<uint32_t>   head {0};           // Written by the producer
+        std::atomic<uint32_t>   tail {0};           // Written by the consumer
+        volatile uint32_t       dropped = 0;
+};
+
+
+#endif  // SPSC_HEADER
@@ -0,0 +1,147 @@
+/**
+ * RP2040 FreeRTOS Template - App #3
+ * Early warning of a temperature threshold from the recent trend
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#include "trend_predictor.h"
+
+
+/**
+ * @brief Constructor: instantiate a new Trend_Predictor.
+ *
+ * @param config: The threshold, the warning horizon, the point spacing
+ *                and the minimum rate.
+ */
+Trend_Predictor::Trend_Predictor(const Trend_Config& config) : config(config) {
+    next = 0;
+    count = 0;
+    pending_sum = 0;
+    pending_count = 0;
+    pending_start = 0;
+    last_point = 0;
+    time_to_threshold = TREND_NO_PREDICTION;
+    warning = false;
+    for (uint32_t i = 0 ; i < TREND_WINDOW ; ++i) times[i] = 0;
+}
+
+
+/**
+ * @brief Add a sample and re-project the threshold crossing.
+ *
+ * @param temp: The latest reading.
+ * @param now:  The tick count at which it was taken.
+ *
+ * @retval WARNING when a crossing is first projected within the horizon,
+ *         CLEARED when a warned crossing is no longer projected within
+ *         twice the horizon, otherwise NONE.
+ */
+Trend_Event Trend_Predictor::update(Fixed<4> temp, TickType_t now) {
+    if (pending_count == 0) pending_start = now;
+    pending_sum += temp.raw;
+    pending_count++;
+    if (count > 0 && (TickType_t)(now - last_point) < config.spacing) return Trend_Event::NONE;
+
+    // Close the point: the mean, in Q8, at the middle of its samples
+    int32_t unused = 0;
+    points[next] = Fixed<8>::from_raw(FixedMath::divmod_s32(pending_sum * 16, (int32_t)pending_count, &unused));
+    times[next] = pending_start + (TickType_t)(now - pending_start) / 2;
+    next = (next + 1) % TREND_WINDOW;
+    last_point = now;
+    pending_sum = 0;
+    pending_count = 0;
+
+    if (count < TREND_WINDOW) count++;
+    if (count < TREND_WINDOW) return Trend_Event::NONE;
+
+    fit();
+
+    if (!warning && time_to_threshold <= config.horizon) {
+        warning = true;
+        return Trend_Event::WARNING;
+    }
+
+    // Hysteresis, so a noisy fit near the horizon doesn't chatter
+    if (warning && (time_to_threshold == TREND_NO_PREDICTION || time_to_threshold / 2 > config.horizon)) {
+        warning = false;
+        return Trend_Event::CLEARED;
+    }
+
+    return Trend_Event::NONE;
+}
+
+
+/**
+ * @brief Fit y = a + bt over the window, with t in ticks relative to the
+ *        newest point, so a is the fitted temperature now. Sums are
+ *        64-bit: with points a second apart, as App Three spaces them,
+ *        and temperatures to 125C in Q8 they stay below 2^46.
+ */
+void Trend_Predictor::fit() {
+    const TickType_t newest = times[(next + TREND_WINDOW - 1) % TREND_WINDOW];
+    int64_t sum_t = 0, sum_y = 0, sum_ty = 0, sum_tt = 0;
+    for (uint32_t i = 0 ; i < TREND_WINDOW ; ++i) {
+        const int64_t t = -(int64_t)(TickType_t)(newest - times[i]);
+        const int64_t y = points[i].raw;
+        sum_t += t;
+        sum_y += y;
+        sum_ty += t * y;
+        sum_tt += t * t;
+    }
+
+    const int64_t n = TREND_WINDOW;
+    const int64_t denominator = n * sum_tt - sum_t * sum_t;
+    const int64_t slope = n * sum_ty - sum_t * sum_y;
+    const int64_t intercept = sum_y * sum_tt - sum_t * sum_ty;
+    time_to_threshold = TREND_NO_PREDICTION;
+    rate = Fixed<8>();
+
+    // All samples in one tick: no trend to fit
+    if (denominator <= 0) return;
+
+    // Slope in Q8 per tick, times ticks per second. Compare it with the
+    // minimum exactly, rather than at the rounded rate's resolution
+    const int64_t per_second = slope * (int64_t)configTICK_RATE_HZ;
+    rate = Fixed<8>::from_raw((int32_t)(per_second / denominator));
+    const bool rising = slope > 0 && per_second >= (int64_t)config.min_rate.raw * denominator;
+
+    // Both sides scaled by the denominator: (threshold - a) and b
+    const int64_t gap = (int64_t)config.threshold.convert<8>().raw * denominator - intercept;
+    if (gap <= 0) {
+        time_to_threshold = 0;
+    } else if (rising) {
+        const int64_t ticks = gap / slope;
+        time_to_threshold = ticks < (int64_t)TREND_NO_PREDICTION ? (TickType_t)ticks : TREND_NO_PREDICTION - 1;
+    }
+}
+
+
+/**
+ * @brief The projected time until the threshold is reached.
+ *
+ * @retval Ticks, 0 if it has been reached, or TREND_NO_PREDICTION if
+ *         the temperature is not rising fast enough to reach it.
+ */
+TickType_t Trend_Predictor::get_time_to_threshold() const {
+    return time_to_threshold;
+}
+
+
+/**
+ * @brief The fitted rate of change, in C per second.
+ */
+Fixed<8> Trend_Predictor::get_rate() const {
+    return rate;
+}
+
+
+/**
+ * @brief Whether a warning is in force: from the WARNING event that
+ *        `update()` returns until the CLEARED one.
+ */
+bool Trend_Predictor::is_warning() const {
+    return warning;
+}
@@ -0,0 +1,94 @@
+/**
+ * RP2040 FreeRTOS Template - App #3
+ * Early warning of a temperature threshold from the recent trend
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#ifndef TREND_PREDICTOR_HEADER
+#define TREND_PREDICTOR_HEADER
+
+
+#include <cstdlib>
+#include <cstdint>
+// FreeRTOS
+#include <FreeRTOS.h>
+#include <task.h>
+// App
+#include "fixed.h"
+
+
+/*
+ * CONSTANTS
+ */
+// Points in the fit. Each point costs O(TREND_WINDOW) to add
+#define TREND_WINDOW                8
+// Returned when no crossing is predicted
+#define TREND_NO_PREDICTION         0xFFFFFFFF
+
+
+/*
+ * ENUMERATIONS
+ */
+enum class Trend_Event : uint8_t {
+    NONE,
+    WARNING,        // The threshold is projected to be reached within the horizon
+    CLEARED         // The projection has moved back beyond twice the horizon
+};
+
+
+/**
+    Tuning for Trend_Predictor. Temperatures are in Celsius, times in ticks.
+ */
+struct Trend_Config {
+    Fixed<4>    threshold;          // The limit to warn ahead of
+    TickType_t  horizon;            // Warn when the crossing is this close
+    TickType_t  spacing;            // Average samples into one point per this period
+    Fixed<8>    min_rate;           // Ignore rises slower than this, in C per second
+};
+
+
+/**
+    Fits a least-squares line to the last TREND_WINDOW points and projects
+    when it will reach the threshold. Samples are averaged into one point
+    per `spacing` ticks, so the window spans a useful time whatever the
+    sample rate, and the averages resolve trends finer than the sensor's
+    0.0625C step. The fit is in 64-bit integers, so every sample costs a
+    bounded number of cycles and no floating point. The hardware alert
+    only fires after the limit is crossed; this warns before it is.
+ */
+class Trend_Predictor {
+
+    public:
+        Trend_Predictor(const Trend_Config& config);
+
+        Trend_Event     update(Fixed<4> temp, TickType_t now);
+        TickType_t      get_time_to_threshold() const;
+        Fixed<8>        get_rate() const;
+        bool            is_warning() const;
+
+    private:
+        Trend_Config    config;
+
+        Fixed<8>        points[TREND_WINDOW];
+        TickType_t      times[TREND_WINDOW];
+        uint32_t        next;
+        uint32_t        count;
+
+        // Samples waiting to be averaged into the next point
+        int32_t         pending_sum;
+        uint32_t        pending_count;
+        TickType_t      pending_start;
+        TickType_t      last_point;
+
+        TickType_t      time_to_threshold;
+        Fixed<8>        rate;
+        bool            warning;
+
+        void            fit();
+};
+
+
+#endif  // TREND_PREDICTOR_HEADER
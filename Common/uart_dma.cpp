@@ -0,0 +1,253 @@
+/**
+ * RP2040 FreeRTOS Template - App #2
+ * DMA-driven UART receiver for modem traffic
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#include "uart_dma.h"
+
+
+/*
+ * GLOBALS
+ */
+// Receivers by UART index, for the shared DMA IRQ handler
+static UART_DMA_Rx* receivers[2] = {nullptr, nullptr};
+static uint32_t     dma_users = 0;
+
+
+/**
+ * @brief Constructor: instantiate an idle receiver.
+ */
+UART_DMA_Rx::UART_DMA_Rx() {
+    uart = nullptr;
+    channel = -1;
+    queue = NULL;
+    dma_base = 0;
+    flushed = 0;
+    last_seen = 0;
+    irq_count = 0;
+    overruns = 0;
+    dropped = 0;
+}
+
+
+/**
+ * @brief Set up the UART and start receiving.
+ *
+ * @param uart:   The UART to use, `uart0` or `uart1`.
+ * @param baud:   The baud rate.
+ * @param tx_pin: The UART TX GPIO.
+ * @param rx_pin: The UART RX GPIO.
+ *
+ * @retval `true` if reception started, otherwise `false`.
+ */
+bool UART_DMA_Rx::begin(uart_inst_t* uart, uint32_t baud, uint32_t tx_pin, uint32_t rx_pin) {
+    if (!HR_Timer::init()) return false;
+
+    queue = xQueueCreate(UART_RX_QUEUE_LENGTH, sizeof(UART_Rx_Range));
+    channel = dma_claim_unused_channel(false);
+    if (queue == NULL || channel < 0) return false;
+
+    this->uart = uart;
+    uart_init(uart, baud);
+    gpio_set_function(tx_pin, GPIO_FUNC_UART);
+    gpio_set_function(rx_pin, GPIO_FUNC_UART);
+    uart_set_fifo_enabled(uart, true);
+
+    // Byte transfers from the fixed data register into the ring, paced
+    // by the UART's RX DREQ. The write address wraps on the ring size
+    dma_channel_config config = dma_channel_get_default_config(channel);
+    channel_config_set_transfer_data_size(&config, DMA_SIZE_8);
+    channel_config_set_read_increment(&config, false);
+    channel_config_set_write_increment(&config, true);
+    channel_config_set_ring(&config, true, UART_RX_RING_BITS);
+    channel_config_set_dreq(&config, uart_get_dreq(uart, false));
+
+    // The only DMA interrupt is the restart at the end of each run
+    receivers[uart_get_index(uart)] = this;
+    dma_channel_set_irq0_enabled(channel, true);
+    if (dma_users++ == 0) {
+        irq_add_shared_handler(DMA_IRQ_0, dma_isr, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+        irq_set_enabled(DMA_IRQ_0, true);
+    }
+
+    dma_channel_configure(channel, &config, ring, &uart_get_hw(uart)->dr, UART_RX_DMA_COUNT, true);
+
+    timer.set_callback(poll_callback, this);
+    timer.start_in(UART_RX_IDLE_US);
+    return true;
+}
+
+
+/**
+ * @brief Stop receiving and release the DMA channel.
+ */
+void UART_DMA_Rx::end() {
+    if (channel < 0) return;
+
+    timer.cancel();
+    dma_channel_set_irq0_enabled(channel, false);
+    dma_channel_abort(channel);
+    dma_channel_unclaim(channel);
+    if (--dma_users == 0) {
+        irq_set_enabled(DMA_IRQ_0, false);
+        irq_remove_handler(DMA_IRQ_0, dma_isr);
+    }
+
+    receivers[uart_get_index(uart)] = nullptr;
+    uart_deinit(uart);
+    channel = -1;
+}
+
+
+/**
+ * @brief Wait for the next range of received bytes.
+ *
+ * @param range: Pointer to the range to fill.
+ * @param wait:  Ticks to block for. Default: `portMAX_DELAY`.
+ *
+ * @retval `true` if a range was received, otherwise `false`.
+ */
+bool UART_DMA_Rx::receive(UART_Rx_Range* range, TickType_t wait) {
+    return xQueueReceive(queue, range, wait) == pdPASS;
+}
+
+
+/**
+ * @brief Map a range onto the ring without copying.
+ *
+ * @param range: The range to map.
+ * @param spans: Filled with one span, or two if the range wraps.
+ *
+ * @retval The number of spans.
+ */
+uint32_t UART_DMA_Rx::get_spans(const UART_Rx_Range& range, UART_Rx_Span spans[2]) const {
+    const uint32_t to_end = UART_RX_RING_SIZE - range.start;
+    spans[0].data = &ring[range.start];
+    if (range.length <= to_end) {
+        spans[0].length = range.length;
+        return 1;
+    }
+
+    spans[0].length = to_end;
+    spans[1].data = ring;
+    spans[1].length = range.length - to_end;
+    return 2;
+}
+
+
+/**
+ * @brief Copy a range out of the ring, for consumers that need it flat.
+ *
+ * @param range: The range to copy.
+ * @param dest:  Pointer to the destination.
+ * @param size:  The destination size in bytes.
+ *
+ * @retval The number of bytes copied.
+ */
+uint32_t UART_DMA_Rx::copy(const UART_Rx_Range& range, uint8_t* dest, uint32_t size) const {
+    UART_Rx_Span spans[2];
+    const uint32_t count = get_spans(range, spans);
+    uint32_t copied = 0;
+    for (uint32_t i = 0 ; i < count && copied < size ; ++i) {
+        const uint32_t length = spans[i].length < size - copied ? spans[i].length : size - copied;
+        memcpy(dest + copied, spans[i].data, length);
+        copied += length;
+    }
+
+    return copied;
+}
+
+
+QueueHandle_t UART_DMA_Rx::get_queue() const {
+    return queue;
+}
+
+
+/**
+ * @brief Interrupts taken so far: polls plus DMA restarts.
+ */
+uint32_t UART_DMA_Rx::get_irq_count() const {
+    return irq_count;
+}
+
+
+/**
+ * @brief Times the DMA lapped bytes not yet posted.
+ */
+uint32_t UART_DMA_Rx::get_overruns() const {
+    return overruns;
+}
+
+
+/**
+ * @brief Ranges lost because the receive queue was full.
+ */
+uint32_t UART_DMA_Rx::get_dropped() const {
+    return dropped;
+}
+
+
+/**
+ * @brief Total bytes received, modulo 2^32. Read from the DMA transfer
+ *        count, not the write address, so laps of the ring are counted.
+ */
+uint32_t UART_DMA_Rx::received() const {
+    return dma_base + (UART_RX_DMA_COUNT - dma_channel_hw_addr(channel)->transfer_count);
+}
+
+
+/**
+ * @brief Check the DMA's progress and post any range that is ready.
+ *        Called in the alarm ISR.
+ */
+void UART_DMA_Rx::poll(BaseType_t* higher_priority_task_woken) {
+    const uint32_t now = received();
+    uint32_t pending = now - flushed;
+    const bool idle = now == last_seen;
+    last_seen = now;
+
+    if (pending == 0) return;
+    if (pending > UART_RX_RING_SIZE) {
+        // Lapped: keep only what the ring still holds
+        overruns++;
+        flushed = now - UART_RX_RING_SIZE / 2;
+        pending = UART_RX_RING_SIZE / 2;
+    }
+
+    if (!idle && pending < UART_RX_RING_SIZE / 2) return;
+
+    UART_Rx_Range range;
+    range.start = (uint16_t)(flushed & (UART_RX_RING_SIZE - 1));
+    range.length = (uint16_t)pending;
+    if (xQueueSendToBackFromISR(queue, &range, higher_priority_task_woken) != pdPASS) dropped++;
+    flushed = now;
+}
+
+
+void UART_DMA_Rx::poll_callback(HR_Timer* timer, void* context, BaseType_t* higher_priority_task_woken) {
+    UART_DMA_Rx* rx = (UART_DMA_Rx*)context;
+    rx->irq_count = rx->irq_count + 1;
+    rx->poll(higher_priority_task_woken);
+    timer->start_at(timer->get_deadline() + UART_RX_IDLE_US);
+}
+
+
+/**
+ * @brief Shared DMA IRQ handler: restart any receiver's channel that has
+ *        finished its run. The write address carries on round the ring.
+ */
+void UART_DMA_Rx::dma_isr() {
+    for (uint32_t i = 0 ; i < 2 ; ++i) {
+        UART_DMA_Rx* rx = receivers[i];
+        if (rx == nullptr || !dma_channel_get_irq0_status(rx->channel)) continue;
+
+        dma_channel_acknowledge_irq0(rx->channel);
+        rx->irq_count = rx->irq_count + 1;
+        rx->dma_base = rx->dma_base + UART_RX_DMA_COUNT;
+        dma_channel_set_trans_count(rx->channel, UART_RX_DMA_COUNT, true);
+    }
+}
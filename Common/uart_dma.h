@@ -0,0 +1,110 @@
+/**
+ * RP2040 FreeRTOS Template - App #2
+ * DMA-driven UART receiver for modem traffic
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#ifndef UART_DMA_HEADER
+#define UART_DMA_HEADER
+
+
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+// FreeRTOS
+#include <FreeRTOS.h>
+#include <task.h>
+#include <queue.h>
+// Pico SDK
+#include "pico/stdlib.h"
+#include "hardware/uart.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+// App
+#include "hr_timer.h"
+
+
+/*
+ * CONSTANTS
+ */
+// Ring size: a power of two, as the DMA ring wraps on an address bit
+#define UART_RX_RING_BITS           10
+#define UART_RX_RING_SIZE           (1 << UART_RX_RING_BITS)
+// Flush a partial frame once the line has been quiet this long
+#define UART_RX_IDLE_US             1000
+#define UART_RX_QUEUE_LENGTH        8
+// Transfers per DMA run; the channel is restarted when one completes
+#define UART_RX_DMA_COUNT           0xFFFFFFFF
+
+
+/**
+    A run of received bytes, as offsets into the receiver's ring.
+    `start` is in [0, UART_RX_RING_SIZE); the run may wrap.
+ */
+struct UART_Rx_Range {
+    uint16_t    start;
+    uint16_t    length;
+};
+
+/**
+    A contiguous part of a UART_Rx_Range.
+ */
+struct UART_Rx_Span {
+    const uint8_t*  data;
+    uint32_t        length;
+};
+
+
+/**
+    Receives continuously into a ring buffer by DMA, with no per-byte
+    interrupts. A hardware-alarm timer checks the DMA's progress every
+    UART_RX_IDLE_US. It posts a range of new bytes to the receive queue
+    when the line has gone quiet, or when half the ring is pending.
+    Ranges are not copies: the consumer must deal with each one before
+    the DMA comes round the ring again, ie. within UART_RX_RING_SIZE / 2
+    character times. Lapped data is counted as an overrun.
+ */
+class UART_DMA_Rx {
+
+    public:
+        UART_DMA_Rx();
+
+        bool            begin(uart_inst_t* uart, uint32_t baud, uint32_t tx_pin, uint32_t rx_pin);
+        void            end();
+
+        bool            receive(UART_Rx_Range* range, TickType_t wait = portMAX_DELAY);
+        uint32_t        get_spans(const UART_Rx_Range& range, UART_Rx_Span spans[2]) const;
+        uint32_t        copy(const UART_Rx_Range& range, uint8_t* dest, uint32_t size) const;
+
+        QueueHandle_t   get_queue() const;
+        uint32_t        get_irq_count() const;
+        uint32_t        get_overruns() const;
+        uint32_t        get_dropped() const;
+
+    private:
+        static void     poll_callback(HR_Timer* timer, void* context, BaseType_t* higher_priority_task_woken);
+        static void     dma_isr();
+        uint32_t        received() const;
+        void            poll(BaseType_t* higher_priority_task_woken);
+
+        alignas(UART_RX_RING_SIZE) uint8_t ring[UART_RX_RING_SIZE];
+
+        uart_inst_t*        uart;
+        int                 channel;
+        QueueHandle_t       queue;
+        HR_Timer            timer;
+
+        volatile uint32_t   dma_base;
+        uint32_t            flushed;
+        uint32_t            last_seen;
+
+        volatile uint32_t   irq_count;
+        uint32_t            overruns;
+        uint32_t            dropped;
+};
+
+
+#endif  // UART_DMA_HEADER
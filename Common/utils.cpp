@@ -95,16 +95,16 @@ string get_field_value(string line, uint32_t field_number) {
  */
 uint32_t bcd(uint32_t base) {
     if (base > 9999) base = 9999;
-    for (uint32_t i = 0 ; i < 16 ; ++i) {
-        base = base << 1;
-        if (i == 15) break;
-        if ((base & 0x000F0000) > 0x0004FFFF) base += 0x00030000;
-        if ((base & 0x00F00000) > 0x004FFFFF) base += 0x00300000;
-        if ((base & 0x0F000000) > 0x04FFFFFF) base += 0x03000000;
-        if ((base & 0xF0000000) > 0x4FFFFFFF) base += 0x30000000;
+
+    // Four divisions on the SIO divider beat 16 shift-and-add passes
+    uint32_t result = 0;
+    for (uint32_t shift = 0 ; shift < 16 ; shift += 4) {
+        uint32_t digit = 0;
+        base = FixedMath::divmod_u32(base, 10, &digit);
+        result |= digit << shift;
     }
 
-    return (base >> 16) & 0xFFFF;
+    return result;
 }
 
 
@@ -23,6 +23,8 @@
 // Pico SDK
 #include "pico/stdlib.h"
 #include "pico/binary_info.h"
+// App
+#include "fixed.h"
 
 
 using std::vector;
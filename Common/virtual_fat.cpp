@@ -0,0 +1,246 @@
+/**
+ * RP2040 FreeRTOS Template - App #3
+ * A read-only FAT16 volume synthesised one sector at a time
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#include "virtual_fat.h"
+
+
+/*
+ * CONSTANTS
+ */
+#define VFAT_DIR_ENTRY_SIZE         32
+#define VFAT_ATTR_READ_ONLY         0x01
+#define VFAT_ATTR_VOLUME_ID         0x08
+#define VFAT_FAT_END                0xFFFF
+#define VFAT_MEDIA                  0xF8
+#define VFAT_SERIAL                 0x20402022
+// Every entry carries the same timestamp: 2022-03-20 12:00:00
+#define VFAT_DATE                   (((2022 - 1980) << 9) | (3 << 5) | 20)
+#define VFAT_TIME                   (12 << 11)
+
+
+/*
+ * STATIC FUNCTIONS
+ */
+static void put_16(uint8_t* at, uint32_t value) {
+    at[0] = (uint8_t)value;
+    at[1] = (uint8_t)(value >> 8);
+}
+
+static void put_32(uint8_t* at, uint32_t value) {
+    put_16(at, value);
+    put_16(at + 2, value >> 16);
+}
+
+/**
+ * @brief Convert a name such as `history.csv` to its space-padded,
+ *        upper-case 8.3 form. Longer parts are truncated.
+ */
+static void make_short_name(const char* name, char* short_name) {
+    memset(short_name, ' ', 11);
+    uint32_t i = 0;
+    uint32_t limit = 8;
+    for ( ; *name != 0 ; ++name) {
+        if (*name == '.') {
+            i = 8;
+            limit = 11;
+            continue;
+        }
+
+        if (i < limit) {
+            const char c = *name;
+            short_name[i++] = (c >= 'a' && c <= 'z') ? c - 'a' + 'A' : c;
+        }
+    }
+}
+
+
+/**
+ * @brief Constructor: an empty volume.
+ *
+ * @param label: The volume label, up to 11 characters.
+ */
+Virtual_FAT::Virtual_FAT(const char* label) {
+    memset(this->label, ' ', sizeof(this->label));
+    for (uint32_t i = 0 ; i < sizeof(this->label) && label[i] != 0 ; ++i) this->label[i] = label[i];
+    clear();
+}
+
+
+/**
+ * @brief Remove all the files.
+ */
+void Virtual_FAT::clear() {
+    file_count = 0;
+    next_cluster = 2;
+}
+
+
+/**
+ * @brief Add a file to the volume.
+ *
+ * @param name:    An 8.3 file name, eg. `history.csv`.
+ * @param size:    The file's size in bytes.
+ * @param reader:  Called to fill the file's sectors.
+ * @param context: Passed to `reader`.
+ *
+ * @retval `true` if the file was added, `false` if the volume is full.
+ */
+bool Virtual_FAT::add_file(const char* name, uint32_t size, VFAT_Reader reader, void* context) {
+    const uint32_t clusters = (size + VFAT_SECTOR_SIZE - 1) / VFAT_SECTOR_SIZE;
+    if (file_count == VFAT_MAX_FILES || next_cluster - 2 + clusters > VFAT_CLUSTER_COUNT) return false;
+
+    File& file = files[file_count++];
+    make_short_name(name, file.name);
+    file.size = size;
+    file.first_cluster = clusters > 0 ? next_cluster : 0;
+    file.cluster_count = clusters;
+    file.reader = reader;
+    file.context = context;
+    next_cluster += clusters;
+    return true;
+}
+
+
+/**
+ * @brief Build one sector of the volume.
+ *
+ * @param sector: The sector number.
+ * @param buffer: VFAT_SECTOR_SIZE bytes to fill.
+ */
+void Virtual_FAT::read_sector(uint32_t sector, uint8_t* buffer) const {
+    memset(buffer, 0, VFAT_SECTOR_SIZE);
+    if (sector < VFAT_FIRST_FAT_SECTOR) {
+        make_boot_sector(buffer);
+    } else if (sector < VFAT_ROOT_SECTOR) {
+        // Both FATs are the same
+        make_fat_sector((sector - VFAT_FIRST_FAT_SECTOR) % VFAT_FAT_SECTORS, buffer);
+    } else if (sector < VFAT_DATA_SECTOR) {
+        make_root_sector(sector - VFAT_ROOT_SECTOR, buffer);
+    } else if (sector < VFAT_SECTOR_COUNT) {
+        make_data_sector(sector - VFAT_DATA_SECTOR + 2, buffer);
+    }
+}
+
+
+uint32_t Virtual_FAT::get_sector_count() const {
+    return VFAT_SECTOR_COUNT;
+}
+
+
+uint32_t Virtual_FAT::get_file_count() const {
+    return file_count;
+}
+
+
+/**
+ * @brief The BIOS parameter block, which describes the layout.
+ */
+void Virtual_FAT::make_boot_sector(uint8_t* buffer) const {
+    static const uint8_t jump[3] = {0xEB, 0x3C, 0x90};
+    memcpy(buffer, jump, sizeof(jump));
+    memcpy(buffer + 3, "RP2040  ", 8);
+    put_16(buffer + 11, VFAT_SECTOR_SIZE);
+    buffer[13] = 1;
+    put_16(buffer + 14, VFAT_RESERVED_SECTORS);
+    buffer[16] = VFAT_FAT_COUNT;
+    put_16(buffer + 17, VFAT_ROOT_ENTRIES);
+    put_16(buffer + 19, VFAT_SECTOR_COUNT);
+    buffer[21] = VFAT_MEDIA;
+    put_16(buffer + 22, VFAT_FAT_SECTORS);
+    put_16(buffer + 24, 1);
+    put_16(buffer + 26, 1);
+
+    // Extended boot record
+    buffer[36] = 0x80;
+    buffer[38] = 0x29;
+    put_32(buffer + 39, VFAT_SERIAL);
+    memcpy(buffer + 43, label, sizeof(label));
+    memcpy(buffer + 54, "FAT16   ", 8);
+    buffer[510] = 0x55;
+    buffer[511] = 0xAA;
+}
+
+
+/**
+ * @brief A sector of the FAT. Each file's clusters chain to the next,
+ *        so only the last one in each file needs a lookup.
+ */
+void Virtual_FAT::make_fat_sector(uint32_t index, uint8_t* buffer) const {
+    const uint32_t per_sector = VFAT_SECTOR_SIZE / 2;
+    const uint32_t first = index * per_sector;
+    for (uint32_t i = 0 ; i < per_sector ; ++i) {
+        const uint32_t cluster = first + i;
+        uint32_t entry = 0;
+        if (cluster == 0) {
+            entry = 0xFF00 | VFAT_MEDIA;
+        } else if (cluster == 1) {
+            entry = VFAT_FAT_END;
+        } else if (cluster < next_cluster) {
+            const File* file = find_file(cluster);
+            entry = cluster == file->first_cluster + file->cluster_count - 1 ? VFAT_FAT_END : cluster + 1;
+        }
+
+        put_16(buffer + i * 2, entry);
+    }
+}
+
+
+/**
+ * @brief A sector of the root directory: the volume label, then the files.
+ */
+void Virtual_FAT::make_root_sector(uint32_t index, uint8_t* buffer) const {
+    const uint32_t per_sector = VFAT_SECTOR_SIZE / VFAT_DIR_ENTRY_SIZE;
+    for (uint32_t i = 0 ; i < per_sector ; ++i) {
+        const uint32_t slot = index * per_sector + i;
+        uint8_t* entry = buffer + i * VFAT_DIR_ENTRY_SIZE;
+        if (slot == 0) {
+            memcpy(entry, label, sizeof(label));
+            entry[11] = VFAT_ATTR_VOLUME_ID;
+        } else if (slot <= file_count) {
+            const File& file = files[slot - 1];
+            memcpy(entry, file.name, sizeof(file.name));
+            entry[11] = VFAT_ATTR_READ_ONLY;
+            put_16(entry + 14, VFAT_TIME);
+            put_16(entry + 16, VFAT_DATE);
+            put_16(entry + 18, VFAT_DATE);
+            put_16(entry + 22, VFAT_TIME);
+            put_16(entry + 24, VFAT_DATE);
+            put_16(entry + 26, file.first_cluster);
+            put_32(entry + 28, file.size);
+        } else {
+            break;
+        }
+    }
+}
+
+
+/**
+ * @brief A data sector: part of a file from its reader, or zeros.
+ */
+void Virtual_FAT::make_data_sector(uint32_t cluster, uint8_t* buffer) const {
+    if (cluster >= next_cluster) return;
+
+    const File* file = find_file(cluster);
+    const uint32_t offset = (cluster - file->first_cluster) * VFAT_SECTOR_SIZE;
+    const uint32_t remaining = file->size - offset;
+    file->reader(file->context, offset, buffer, remaining < VFAT_SECTOR_SIZE ? remaining : VFAT_SECTOR_SIZE);
+}
+
+
+/**
+ * @brief The file that holds an allocated cluster.
+ */
+const Virtual_FAT::File* Virtual_FAT::find_file(uint32_t cluster) const {
+    for (uint32_t i = 0 ; i < file_count ; ++i) {
+        const File& file = files[i];
+        if (cluster >= file.first_cluster && cluster < file.first_cluster + file.cluster_count) return &file;
+    }
+
+    return nullptr;
+}
@@ -0,0 +1,96 @@
+/**
+ * RP2040 FreeRTOS Template - App #3
+ * A read-only FAT16 volume synthesised one sector at a time
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#ifndef VIRTUAL_FAT_HEADER
+#define VIRTUAL_FAT_HEADER
+
+
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+
+
+/*
+ * CONSTANTS
+ */
+#define VFAT_SECTOR_SIZE            512
+#define VFAT_MAX_FILES              4
+// One sector per cluster. FAT16 needs at least 4085 clusters, so the
+// volume is 4MB whatever the files hold: unused clusters read as zeros
+#define VFAT_CLUSTER_COUNT          8192
+#define VFAT_ROOT_ENTRIES           512
+#define VFAT_FAT_COUNT              2
+#define VFAT_RESERVED_SECTORS       1
+#define VFAT_FAT_SECTORS            (((VFAT_CLUSTER_COUNT + 2) * 2 + VFAT_SECTOR_SIZE - 1) / VFAT_SECTOR_SIZE)
+#define VFAT_ROOT_SECTORS           (VFAT_ROOT_ENTRIES * 32 / VFAT_SECTOR_SIZE)
+#define VFAT_FIRST_FAT_SECTOR       VFAT_RESERVED_SECTORS
+#define VFAT_ROOT_SECTOR            (VFAT_FIRST_FAT_SECTOR + VFAT_FAT_COUNT * VFAT_FAT_SECTORS)
+#define VFAT_DATA_SECTOR            (VFAT_ROOT_SECTOR + VFAT_ROOT_SECTORS)
+#define VFAT_SECTOR_COUNT           (VFAT_DATA_SECTOR + VFAT_CLUSTER_COUNT)
+#define VFAT_MAX_FILE_SIZE          ((uint32_t)VFAT_CLUSTER_COUNT * VFAT_SECTOR_SIZE)
+
+
+/**
+    Fills `length` bytes of a file's content from byte `offset`. The
+    range never runs past the file's size.
+ */
+typedef void (*VFAT_Reader)(void* context, uint32_t offset, uint8_t* buffer, uint32_t length);
+
+
+/**
+    Presents files as a FAT16 volume, eg. to a USB host, without storing
+    the volume anywhere. Each sector is built when the host reads it: the
+    boot sector, FATs and root directory from the file list, and file
+    sectors from each file's reader. So a reader must be able to start at
+    any offset, and the files can be far bigger than RAM.
+
+    Files get contiguous clusters in the order they were added. Sizes are
+    fixed when the files are added, as a host caches the directory. To
+    publish new content, `clear()` and add the files again, then tell
+    the host the medium has changed.
+
+    It is portable C++, so it can be checked on the host: see
+    Tools/vfat_image.cpp.
+ */
+class Virtual_FAT {
+
+    public:
+        Virtual_FAT(const char* label = "RP2040");
+
+        void            clear();
+        bool            add_file(const char* name, uint32_t size, VFAT_Reader reader, void* context);
+        void            read_sector(uint32_t sector, uint8_t* buffer) const;
+
+        uint32_t        get_sector_count() const;
+        uint32_t        get_file_count() const;
+
+    private:
+        struct File {
+            char            name[11];
+            uint32_t        size;
+            uint32_t        first_cluster;
+            uint32_t        cluster_count;
+            VFAT_Reader     reader;
+            void*           context;
+        };
+
+        void            make_boot_sector(uint8_t* buffer) const;
+        void            make_fat_sector(uint32_t index, uint8_t* buffer) const;
+        void            make_root_sector(uint32_t index, uint8_t* buffer) const;
+        void            make_data_sector(uint32_t cluster, uint8_t* buffer) const;
+        const File*     find_file(uint32_t cluster) const;
+
+        char            label[11];
+        File            files[VFAT_MAX_FILES];
+        uint32_t        file_count;
+        uint32_t        next_cluster;
+};
+
+
+#endif  // VIRTUAL_FAT_HEADER
@@ -0,0 +1,126 @@
+/**
+ * RP2040 FreeRTOS Template - App #3
+ * Per-task execution time measurement
+ *
+ * Built into the FreeRTOS library when the project is configured
+ * with `-DWCET_TRACE=ON`.
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#include "wcet.h"
+#include "pico/stdlib.h"
+
+
+#if configUSE_WCET_TRACE
+
+/*
+ * GLOBALS
+ */
+static WCET_Record  records[WCET_MAX_TASKS];
+static uint32_t     record_count = 0;
+
+
+/*
+ * TRACE HOOKS
+ *
+ * Called by the kernel inside `vTaskSwitchContext()`, with interrupts
+ * masked, for every task: `record` is null for tasks that aren't attached.
+ */
+extern "C" void wcet_switched_in(void* record) {
+    if (record != nullptr) ((WCET_Record*)record)->since_us = time_us_32();
+}
+
+extern "C" void wcet_switched_out(void* record) {
+    WCET_Record* r = (WCET_Record*)record;
+    if (r != nullptr && r->in_iteration) r->accrued_us += time_us_32() - r->since_us;
+}
+
+
+namespace WCET {
+
+/**
+ * @brief Start measuring the calling task.
+ *
+ * @param name:      The name to report. Use the task's name so the
+ *                   analyser can match it across runs.
+ * @param period_us: The task's period or minimum inter-arrival time,
+ *                   or 0 for background tasks with no deadline.
+ *
+ * @retval `true` if the task is being measured, `false` if the table is full.
+ */
+bool attach(const char* name, uint32_t period_us) {
+    taskENTER_CRITICAL();
+    if (record_count >= WCET_MAX_TASKS) {
+        taskEXIT_CRITICAL();
+        return false;
+    }
+
+    WCET_Record* record = &records[record_count++];
+    taskEXIT_CRITICAL();
+
+    *record = {};
+    record->name = name;
+    record->task = xTaskGetCurrentTaskHandle();
+    record->period_us = period_us;
+    record->since_us = time_us_32();
+    vTaskSetThreadLocalStoragePointer(NULL, WCET_TLS_INDEX, record);
+    return true;
+}
+
+
+/**
+ * @brief Mark the start of one iteration of the calling task's work.
+ */
+void begin() {
+    WCET_Record* record = (WCET_Record*)pvTaskGetThreadLocalStoragePointer(NULL, WCET_TLS_INDEX);
+    if (record == nullptr) return;
+
+    taskENTER_CRITICAL();
+    record->accrued_us = 0;
+    record->since_us = time_us_32();
+    record->in_iteration = true;
+    taskEXIT_CRITICAL();
+}
+
+
+/**
+ * @brief Mark the end of the iteration, and log its execution time.
+ */
+void end() {
+    WCET_Record* record = (WCET_Record*)pvTaskGetThreadLocalStoragePointer(NULL, WCET_TLS_INDEX);
+    if (record == nullptr || !record->in_iteration) return;
+
+    taskENTER_CRITICAL();
+    const uint32_t us = record->accrued_us + (time_us_32() - record->since_us);
+    record->in_iteration = false;
+    record->iterations++;
+    if (us > record->max_us) record->max_us = us;
+
+    uint32_t bin = us == 0 ? 0 : 32 - __builtin_clz(us);
+    if (bin >= WCET_BINS) bin = WCET_BINS - 1;
+    record->histogram[bin]++;
+    taskEXIT_CRITICAL();
+}
+
+
+/**
+ * @brief Write every record to STDIO, one CSV line per task, for
+ *        `Tools/rta.py`:
+ *        `WCET,<task>,<priority>,<period_us>,<iterations>,<max_us>,<bin 0>,...`
+ */
+void report() {
+    for (uint32_t i = 0 ; i < record_count ; ++i) {
+        const WCET_Record& record = records[i];
+        printf("WCET,%s,%lu,%lu,%lu,%lu", record.name, (unsigned long)uxTaskPriorityGet(record.task),
+               (unsigned long)record.period_us, (unsigned long)record.iterations, (unsigned long)record.max_us);
+        for (uint32_t j = 0 ; j < WCET_BINS ; ++j) printf(",%lu", (unsigned long)record.histogram[j]);
+        printf("\n");
+    }
+}
+
+}   // namespace WCET
+
+#endif  // configUSE_WCET_TRACE
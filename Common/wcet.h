@@ -0,0 +1,73 @@
+/**
+ * RP2040 FreeRTOS Template - App #3
+ * Per-task execution time measurement
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#ifndef WCET_HEADER
+#define WCET_HEADER
+
+
+#include <cstdlib>
+#include <cstdint>
+// FreeRTOS
+#include <FreeRTOS.h>
+#include <task.h>
+
+
+/*
+ * CONSTANTS
+ */
+#define WCET_MAX_TASKS              8
+// Histogram bin n counts iterations of [2^(n-1), 2^n) us; the last is open
+#define WCET_BINS                   16
+
+
+#if configUSE_WCET_TRACE
+
+/**
+    One task's execution time record. Time accrues only while the task is
+    switched in, so preemption is excluded; ISRs that interrupt the task
+    are not, as the kernel can't see them.
+ */
+struct WCET_Record {
+    const char*     name;
+    TaskHandle_t    task;
+    uint32_t        period_us;
+    uint32_t        iterations;
+    uint32_t        max_us;
+    uint32_t        histogram[WCET_BINS];
+    // Working state, updated by the trace hooks
+    uint32_t        since_us;
+    uint32_t        accrued_us;
+    bool            in_iteration;
+};
+
+
+/*
+ * PROTOTYPES
+ */
+namespace WCET {
+    bool            attach(const char* name, uint32_t period_us);
+    void            begin();
+    void            end();
+    void            report();
+}
+
+#else
+
+// Instrumentation compiles away when the trace hooks are not built
+namespace WCET {
+    inline bool     attach(const char* name, uint32_t period_us) { return false; }
+    inline void     begin() {}
+    inline void     end() {}
+    inline void     report() {}
+}
+
+#endif  // configUSE_WCET_TRACE
+
+
+#endif  // WCET_HEADER
@@ -0,0 +1,45 @@
+/**
+ * RP2040 FreeRTOS Template - App #3
+ * FreeRTOS trace hooks for WCET measurement
+ *
+ * Included by FreeRTOSConfig.h, so it is seen by the kernel's C sources:
+ * keep it C and free of SDK headers.
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#ifndef WCET_TRACE_HEADER
+#define WCET_TRACE_HEADER
+
+
+/*
+ * CONSTANTS
+ */
+// The thread-local storage slot that holds each task's WCET record
+#define WCET_TLS_INDEX              0
+
+
+#ifndef __ASSEMBLER__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void wcet_switched_in(void* record);
+void wcet_switched_out(void* record);
+
+#ifdef __cplusplus
+}
+#endif
+
+// Expanded inside tasks.c, where `pxCurrentTCB` is in scope. FreeRTOSConfig.h
+// calls these from `traceTASK_SWITCHED_IN()` and `traceTASK_SWITCHED_OUT()`
+#define WCET_SWITCHED_IN()          wcet_switched_in(pxCurrentTCB->pvThreadLocalStoragePointers[WCET_TLS_INDEX])
+#define WCET_SWITCHED_OUT()         wcet_switched_out(pxCurrentTCB->pvThreadLocalStoragePointers[WCET_TLS_INDEX])
+
+#endif  // __ASSEMBLER__
+
+
+#endif  // WCET_TRACE_HEADER
@@ -0,0 +1,207 @@
+/**
+ * RP2040 FreeRTOS Template - App #5
+ * Zero-latency interrupts on core 1, outside the kernel
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#include "zero_latency.h"
+#include "hardware/structs/sio.h"
+
+
+namespace Zero_Latency {
+
+/*
+ * GLOBALS
+ */
+// A handler to install (or, if `handler` is `nullptr`, remove) on core 1
+struct ZL_Request {
+    uint32_t        irq;
+    irq_handler_t   handler;
+};
+
+static ZL_Request* volatile request = nullptr;
+static bool                 started = false;
+
+// Background work for core 1 -- see `set_worker()`
+static bool (* volatile worker)() = nullptr;
+
+// Doorbells: set by core 1, cleared by core 0 -- see `doorbell_isr()`
+static volatile uint8_t     rung[ZERO_LATENCY_CHANNELS] = {0};
+static TaskHandle_t         tasks[ZERO_LATENCY_CHANNELS] = {NULL};
+
+
+/*
+ * CORE 1
+ */
+
+/**
+ * @brief Apply a request from core 0. NVIC state is per core, so
+ *        zero-latency handlers must be installed and enabled here, not
+ *        by the caller.
+ */
+static void apply(ZL_Request* next) {
+    if (next->handler != nullptr) {
+        irq_set_exclusive_handler(next->irq, next->handler);
+        irq_set_priority(next->irq, IRQ_PRIORITY_ZERO_LATENCY);
+        irq_set_enabled(next->irq, true);
+    } else {
+        irq_set_enabled(next->irq, false);
+        irq_remove_handler(next->irq, irq_get_exclusive_handler(next->irq));
+    }
+
+    __dmb();
+    request = nullptr;
+    __sev();
+}
+
+/**
+ * @brief Core 1's main loop: sleep until woken, then apply any request
+ *        and call the worker until it has nothing left to do. Requests
+ *        are checked between worker calls, so they wait for at most one
+ *        unit of work.
+ */
+static void core1_main() {
+    while (true) {
+        __wfe();
+        bool (*work)() = nullptr;
+        do {
+            ZL_Request* next = request;
+            if (next != nullptr) apply(next);
+            work = worker;
+        } while (work != nullptr && work());
+    }
+}
+
+/**
+ * @brief Wake the task on a doorbell channel. Call from a zero-latency
+ *        ISR after pushing its data.
+ *
+ * @param channel: The channel, 0 to ZERO_LATENCY_CHANNELS - 1.
+ */
+void __not_in_flash_func(ring)(uint32_t channel) {
+    rung[channel] = 1;
+    __dmb();
+
+    // The FIFO word only raises core 0's interrupt. If the FIFO is full,
+    // core 0 has yet to drain it, and will see this flag when it does
+    if (multicore_fifo_wready()) {
+        sio_hw->fifo_wr = channel;
+        __sev();
+    }
+}
+
+
+/*
+ * CORE 0
+ */
+
+/**
+ * @brief The doorbell ISR, on core 0 at IRQ_PRIORITY_DOORBELL. Drain the
+ *        FIFO before reading the flags, so a doorbell rung during this
+ *        ISR either is seen now or leaves a word in the FIFO to run it
+ *        again.
+ */
+static void doorbell_isr() {
+    while (multicore_fifo_rvalid()) (void)sio_hw->fifo_rd;
+    multicore_fifo_clear_irq();
+    __dmb();
+
+    BaseType_t higher_priority_task_woken = pdFALSE;
+    for (uint32_t i = 0 ; i < ZERO_LATENCY_CHANNELS ; ++i) {
+        if (rung[i] == 0) continue;
+        rung[i] = 0;
+        if (tasks[i] != NULL) vTaskNotifyGiveFromISR(tasks[i], &higher_priority_task_woken);
+    }
+
+    portYIELD_FROM_ISR(higher_priority_task_woken);
+}
+
+/**
+ * @brief Pass a request to core 1 and wait for it to be applied.
+ *
+ * @param irq:     The IRQ number.
+ * @param handler: The handler to install, or `nullptr` to remove the current one.
+ *
+ * @retval `true` if the request was applied, `false` if core 1 is not running.
+ */
+static bool post(uint32_t irq, irq_handler_t handler) {
+    if (!started) return false;
+
+    ZL_Request next = {irq, handler};
+    vTaskSuspendAll();
+    request = &next;
+    __dmb();
+    __sev();
+    while (request != nullptr) tight_loop_contents();
+    xTaskResumeAll();
+    return true;
+}
+
+/**
+ * @brief Launch core 1 and install the doorbell ISR on core 0. Call once,
+ *        from core 0.
+ */
+void start() {
+    if (started) return;
+
+    // The launch handshake uses the FIFO, so the doorbell ISR goes in after
+    multicore_launch_core1(core1_main);
+    multicore_fifo_drain();
+    multicore_fifo_clear_irq();
+    irq_set_exclusive_handler(SIO_IRQ_PROC0, doorbell_isr);
+    irq_set_priority(SIO_IRQ_PROC0, IRQ_PRIORITY_DOORBELL);
+    irq_set_enabled(SIO_IRQ_PROC0, true);
+    started = true;
+}
+
+/**
+ * @brief Install and enable a zero-latency ISR on core 1. The source
+ *        must not also be enabled on core 0.
+ *
+ * @param irq:     The IRQ number.
+ * @param handler: The ISR. It must not call FreeRTOS.
+ *
+ * @retval `true` if the ISR was installed, `false` if `start()` has not been called.
+ */
+bool add(uint32_t irq, irq_handler_t handler) {
+    return handler != nullptr && post(irq, handler);
+}
+
+/**
+ * @brief Disable a zero-latency ISR on core 1 and remove it.
+ *
+ * @param irq: The IRQ number.
+ */
+void remove(uint32_t irq) {
+    post(irq, nullptr);
+}
+
+/**
+ * @brief Choose the task notified when a channel's doorbell rings.
+ *
+ * @param channel: The channel, 0 to ZERO_LATENCY_CHANNELS - 1.
+ * @param task:    The task to notify, or NULL for none.
+ */
+void set_doorbell_task(uint32_t channel, TaskHandle_t task) {
+    if (channel < ZERO_LATENCY_CHANNELS) tasks[channel] = task;
+}
+
+/**
+ * @brief Give core 1 background work. Core 1 calls the worker whenever
+ *        it wakes -- call `__sev()` after queueing work -- and again for
+ *        as long as it returns `true`. It must not call FreeRTOS.
+ *
+ * @param next: The worker, which does one unit of work and returns `true`,
+ *              or returns `false` if there is none. `nullptr` for none.
+ */
+void set_worker(bool (*next)()) {
+    worker = next;
+    __dmb();
+    __sev();
+}
+
+
+}   // namespace Zero_Latency
@@ -0,0 +1,60 @@
+/**
+ * RP2040 FreeRTOS Template - App #5
+ * Zero-latency interrupts on core 1, outside the kernel
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#ifndef ZERO_LATENCY_HEADER
+#define ZERO_LATENCY_HEADER
+
+
+#include <cstdlib>
+#include <cstdint>
+// FreeRTOS
+#include <FreeRTOS.h>
+#include <task.h>
+// Pico SDK
+#include "pico/stdlib.h"
+#include "pico/multicore.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
+// App
+#include "irq_priority.h"
+#include "spsc.h"
+
+
+/*
+ * CONSTANTS
+ */
+#define ZERO_LATENCY_CHANNELS           8
+
+
+/*
+ * Zero-latency ISRs run on core 1, at IRQ_PRIORITY_ZERO_LATENCY, where
+ * FreeRTOS -- single-core, on core 0 -- never masks interrupts. They must
+ * not call any FreeRTOS API. Instead they push data into an SPSC_Buffer
+ * and call `Zero_Latency::ring()` to wake the task that drains it: the
+ * doorbell crosses to core 0 through the SIO FIFO, whose ISR gives the
+ * task a notification. Mark zero-latency ISRs `__not_in_flash_func()`
+ * so that flash cache misses don't add to their latency.
+ *
+ * Between interrupts, core 1 can run background work, such as jobs -- see
+ * jobs.h. The worker runs in thread mode, so zero-latency ISRs still
+ * preempt it.
+ */
+namespace Zero_Latency {
+    void    start();
+    bool    add(uint32_t irq, irq_handler_t handler);
+    void    remove(uint32_t irq);
+
+    void    set_doorbell_task(uint32_t channel, TaskHandle_t task);
+    void    ring(uint32_t channel);
+
+    void    set_worker(bool (*worker)());
+}
+
+
+#endif  // ZERO_LATENCY_HEADER
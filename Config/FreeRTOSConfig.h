@@ -27,32 +27,63 @@
 #define FREERTOS_CONFIG_H
 
 
+/* Each app's FreeRTOS library may name an overlay header, which is read
+   first. Settings it defines replace the shared defaults below, which are
+   therefore each guarded by #ifndef. See `add_freertos_library()` in the
+   top-level CMakeLists.txt */
+#ifdef FREERTOS_CONFIG_OVERLAY
+#include FREERTOS_CONFIG_OVERLAY
+#endif
+
 /* Use Pico SDK ISR handlers */
 #define vPortSVCHandler         isr_svcall
 #define xPortPendSVHandler      isr_pendsv
 #define xPortSysTickHandler     isr_systick
 
+/* Scheduling policy: builds may set these, eg. the scheduler benchmarks */
+#ifndef configUSE_PREEMPTION
 #define configUSE_PREEMPTION                    1           // Allow tasks to be pre-empted
+#endif
+#ifndef configUSE_TIME_SLICING
 #define configUSE_TIME_SLICING                  1           // Allow FreeRTOS to switch tasks at each tick
+#endif
 #define configUSE_PORT_OPTIMISED_TASK_SELECTION 0
 #define configUSE_TICKLESS_IDLE                 0
 #define configCPU_CLOCK_HZ                      133000000   // 133MHz for RP2040
 #define configTICK_RATE_HZ                      1000        // FreeRTOS beats per second
+#ifndef configMAX_PRIORITIES
 #define configMAX_PRIORITIES                    5           // Max number of priority values (0-24)
+#endif
+#ifndef configMINIMAL_STACK_SIZE
 #define configMINIMAL_STACK_SIZE                128
+#endif
 #define configMAX_TASK_NAME_LEN                 16
 #define configUSE_16_BIT_TICKS                  0
 #define configIDLE_SHOULD_YIELD                 1
+#ifndef configUSE_TASK_NOTIFICATIONS
 #define configUSE_TASK_NOTIFICATIONS            1
+#endif
+#ifndef configTASK_NOTIFICATION_ARRAY_ENTRIES
 #define configTASK_NOTIFICATION_ARRAY_ENTRIES   3
+#endif
+#ifndef configUSE_MUTEXES
 #define configUSE_MUTEXES                       0
+#endif
+#ifndef configUSE_RECURSIVE_MUTEXES
 #define configUSE_RECURSIVE_MUTEXES             0
+#endif
+#ifndef configUSE_COUNTING_SEMAPHORES
 #define configUSE_COUNTING_SEMAPHORES           0
+#endif
+#ifndef configQUEUE_REGISTRY_SIZE
 #define configQUEUE_REGISTRY_SIZE               10
+#endif
 #define configUSE_QUEUE_SETS                    0
 #define configUSE_NEWLIB_REENTRANT              0
 #define configENABLE_BACKWARD_COMPATIBILITY     0
+#ifndef configNUM_THREAD_LOCAL_STORAGE_POINTERS
 #define configNUM_THREAD_LOCAL_STORAGE_POINTERS 5
+#endif
 
 #define configSTACK_DEPTH_TYPE                  uint16_t
 #define configMESSAGE_BUFFER_LENGTH_TYPE        size_t      // Defaults to size_t for backward compatibility,
@@ -65,10 +96,16 @@
 #define configAPPLICATION_ALLOCATED_HEAP        1
 
 /* Hook function related definitions. */
+#ifndef configUSE_IDLE_HOOK
 #define configUSE_IDLE_HOOK                     0
+#endif
+#ifndef configUSE_TICK_HOOK
 #define configUSE_TICK_HOOK                     0
+#endif
 #define configCHECK_FOR_STACK_OVERFLOW          0
+#ifndef configUSE_MALLOC_FAILED_HOOK
 #define configUSE_MALLOC_FAILED_HOOK            0
+#endif
 #define configUSE_DAEMON_TASK_STARTUP_HOOK      0
 
 /* Run time and task stats gathering related definitions. */
@@ -81,10 +118,18 @@
 #define configMAX_CO_ROUTINE_PRIORITIES         1
 
 /* Software timer related definitions. */
+#ifndef configUSE_TIMERS
 #define configUSE_TIMERS                        1
+#endif
+#ifndef configTIMER_TASK_PRIORITY
 #define configTIMER_TASK_PRIORITY               3
+#endif
+#ifndef configTIMER_QUEUE_LENGTH
 #define configTIMER_QUEUE_LENGTH                10
+#endif
+#ifndef configTIMER_TASK_STACK_DEPTH
 #define configTIMER_TASK_STACK_DEPTH            256
+#endif
 
 /* Define to trap errors during development. */
 #define configASSERT( x )
@@ -103,11 +148,70 @@
 #define INCLUDE_xTaskGetIdleTaskHandle          0
 #define INCLUDE_eTaskGetState                   0
 #define INCLUDE_xEventGroupSetBitFromISR        1
+#ifndef INCLUDE_xTimerPendFunctionCall
 #define INCLUDE_xTimerPendFunctionCall          0
+#endif
 #define INCLUDE_xTaskAbortDelay                 0
 #define INCLUDE_xTaskGetHandle                  0
 #define INCLUDE_xTaskResumeFromISR              1
 
 /* A header file that defines trace macro can be included here. */
 
+/* Per-task execution time measurement -- see Common/wcet.h */
+#ifndef configUSE_WCET_TRACE
+#define configUSE_WCET_TRACE                    0
+#endif
+
+#if configUSE_WCET_TRACE
+#include "../Common/wcet_trace.h"
+#endif
+
+/* WCET records live in a thread-local storage slot, which an overlay
+   may have removed */
+#if configUSE_WCET_TRACE && configNUM_THREAD_LOCAL_STORAGE_POINTERS <= WCET_TLS_INDEX
+#undef configNUM_THREAD_LOCAL_STORAGE_POINTERS
+#define configNUM_THREAD_LOCAL_STORAGE_POINTERS ( WCET_TLS_INDEX + 1 )
+#endif
+
+/* Per-task CPU budgets -- see Common/cpu_budget.h. They are charged
+   and replenished from the tick hook, and keep their records in a
+   thread-local storage slot of their own */
+#ifndef configUSE_CPU_BUDGET
+#define configUSE_CPU_BUDGET                    0
+#endif
+
+#if configUSE_CPU_BUDGET
+#include "../Common/cpu_budget_trace.h"
+#undef configUSE_TICK_HOOK
+#define configUSE_TICK_HOOK                     1
+#if configNUM_THREAD_LOCAL_STORAGE_POINTERS <= CPU_BUDGET_TLS_INDEX
+#undef configNUM_THREAD_LOCAL_STORAGE_POINTERS
+#define configNUM_THREAD_LOCAL_STORAGE_POINTERS ( CPU_BUDGET_TLS_INDEX + 1 )
+#endif
+#endif
+
+/* Heap allocation profiling -- see Common/heap_profile.h. The kernel's
+   allocator reports its blocks through the malloc and free trace hooks */
+#ifndef configUSE_HEAP_PROFILE
+#define configUSE_HEAP_PROFILE                  0
+#endif
+
+#if configUSE_HEAP_PROFILE
+#include "../Common/heap_profile_trace.h"
+#endif
+
+/* WCET and budgets both follow tasks on and off the CPU */
+#if configUSE_WCET_TRACE || configUSE_CPU_BUDGET
+#if !configUSE_WCET_TRACE
+#define WCET_SWITCHED_IN()
+#define WCET_SWITCHED_OUT()
+#endif
+#if !configUSE_CPU_BUDGET
+#define CPU_BUDGET_SWITCHED_IN()
+#define CPU_BUDGET_SWITCHED_OUT()
+#endif
+#define traceTASK_SWITCHED_IN()                 do { WCET_SWITCHED_IN(); CPU_BUDGET_SWITCHED_IN(); } while (0)
+#define traceTASK_SWITCHED_OUT()                do { WCET_SWITCHED_OUT(); CPU_BUDGET_SWITCHED_OUT(); } while (0)
+#endif
+
 #endif /* FREERTOS_CONFIG_H */
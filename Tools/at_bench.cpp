@@ -0,0 +1,222 @@
+/**
+ * RP2040 FreeRTOS Template - AT engine host benchmark
+ * Command throughput and tail latency against Tools/fake_modem.py,
+ * with and without URC bursts, for several pipeline depths
+ *
+ * Commands are offered at a fixed rate, over a link with a 5ms delay
+ * each way. At depth 1 every command pays the 10ms round trip, so the
+ * engine falls behind the offered rate; deeper pipelines overlap the
+ * round trips and keep up. Latency is timed from each command's send,
+ * so it measures the modem and the link, not the time spent queued.
+ * A last run turns the modem's echo on and keeps four commands in
+ * flight, and checks that no echo reaches a response or the URC handler.
+ *
+ *   g++ -std=c++20 -O2 -I Common Tools/at_bench.cpp Common/at_engine.cpp -o at_bench
+ *   python3 Tools/fake_modem.py > pty.txt &
+ *   ./at_bench $(cat pty.txt)
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#include <algorithm>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+#include "at_engine.h"
+#include "../App-Benchmarks/bench.h"
+
+
+/*
+ * CONSTANTS
+ */
+#define AT_BENCH_COMMANDS           400
+#define AT_BENCH_URC_BURST          10
+#define AT_BENCH_URC_PERIOD_MS      20
+#define AT_BENCH_LINK_MS            5
+#define AT_BENCH_OFFERED_PER_S      250
+
+
+/*
+ * GLOBALS
+ */
+static const char*      commands[][2] = {
+    {"AT+CSQ", "+CSQ:"}, {"AT+CREG?", "+CREG:"}, {"ATI", ""}, {"AT+CMGR=1", "+CMGR:"}
+};
+// The information lines the fake modem sends for each
+static const uint32_t   command_lines[] = {1, 1, 2, 2};
+
+static int              modem = -1;
+static vector<uint32_t> latencies;
+static uint32_t         failures = 0;
+static uint32_t         wrong_lines = 0;
+
+
+/*
+ * HELPERS
+ */
+static void modem_write(const char* data, uint32_t length, void*) {
+    if (write(modem, data, length) < 0) failures++;
+}
+
+static void on_done(const AT_Result& result, void*) {
+    latencies.push_back((uint32_t)result.response_us);
+    if (result.status != AT_Status::OK) failures++;
+}
+
+static void on_checked(const AT_Result& result, void* expected_lines) {
+    on_done(result, nullptr);
+    if (result.lines.size() != (uintptr_t)expected_lines) wrong_lines++;
+}
+
+/**
+ * @brief Submit the script, one command every `interval_us`, and feed
+ *        the engine until all of it has completed. Commands that fall
+ *        due while the engine's queue is full are submitted when it
+ *        has room.
+ */
+static void run(AT_Engine& engine, const vector<AT_Command>& script, uint32_t interval_us = 0) {
+    size_t next = 0;
+    const size_t target = latencies.size() + script.size();
+    const uint64_t start = bench_now_us();
+    while (latencies.size() < target) {
+        while (next < script.size() && bench_now_us() - start >= next * interval_us && engine.submit(script[next], bench_now_us())) next++;
+
+        struct pollfd fds = {modem, POLLIN, 0};
+        if (poll(&fds, 1, 1) > 0) {
+            uint8_t data[256];
+            const ssize_t count = read(modem, data, sizeof(data));
+            if (count > 0) engine.feed(data, (uint32_t)count, bench_now_us());
+        }
+
+        engine.poll(bench_now_us());
+    }
+}
+
+static void control(AT_Engine& engine, const string& text) {
+    AT_Command command;
+    command.text = text;
+    command.done = on_done;
+    run(engine, {command});
+    latencies.clear();
+}
+
+static uint32_t percentile(vector<uint32_t>& values, uint32_t pc) {
+    if (values.empty()) return 0;
+    std::sort(values.begin(), values.end());
+    return values[std::min(values.size() - 1, (values.size() * pc) / 100)];
+}
+
+
+/*
+ * BENCHMARKS
+ */
+
+/**
+ * @brief Run the command script at one pipeline depth and URC load.
+ */
+static void bench_at(uint32_t depth, uint32_t burst) {
+    AT_Engine engine(modem_write, nullptr, depth);
+    char setting[48];
+    snprintf(setting, sizeof(setting), "AT+FAKEURC=%u,%u", burst, burst > 0 ? AT_BENCH_URC_PERIOD_MS : 0);
+    control(engine, setting);
+
+    vector<AT_Command> script;
+    for (uint32_t i = 0 ; i < AT_BENCH_COMMANDS ; ++i) {
+        AT_Command command;
+        command.text = commands[i % 4][0];
+        command.prefix = commands[i % 4][1];
+        command.pipeline = true;
+        command.done = on_done;
+        script.push_back(command);
+    }
+
+    latencies.clear();
+    failures = 0;
+    const uint32_t urcs_before = engine.get_urc_count();
+    const uint64_t start = bench_now_us();
+    run(engine, script, 1000000 / AT_BENCH_OFFERED_PER_S);
+    const uint64_t elapsed = bench_now_us() - start;
+
+    char name[48];
+    snprintf(name, sizeof(name), "depth%u_urc%u", depth, burst);
+    const string prefix(name);
+    bench_report("at", (prefix + "_cmds_per_s").c_str(), (uint32_t)((AT_BENCH_COMMANDS * 1000000ULL) / elapsed), "per_s");
+    bench_report("at", (prefix + "_p50").c_str(), percentile(latencies, 50), "us");
+    bench_report("at", (prefix + "_p99").c_str(), percentile(latencies, 99), "us");
+    bench_report("at", (prefix + "_max").c_str(), percentile(latencies, 100), "us");
+    bench_report("at", (prefix + "_failures").c_str(), failures, "count");
+    bench_report("at", (prefix + "_urcs").c_str(), engine.get_urc_count() - urcs_before, "count");
+
+    control(engine, "AT+FAKEURC=0,0");
+}
+
+
+/**
+ * @brief With echo on, send the script as fast as four in flight allow.
+ *        The echoes of the later commands arrive while the first is
+ *        answered: each must be dropped, not taken as a response line
+ *        or a URC.
+ */
+static void bench_echo() {
+    AT_Engine engine(modem_write, nullptr, 4);
+    control(engine, "ATE1");
+
+    vector<AT_Command> script;
+    for (uint32_t i = 0 ; i < AT_BENCH_COMMANDS ; ++i) {
+        AT_Command command;
+        command.text = commands[i % 4][0];
+        command.prefix = commands[i % 4][1];
+        command.pipeline = true;
+        command.done = on_checked;
+        command.context = (void*)(uintptr_t)command_lines[i % 4];
+        script.push_back(command);
+    }
+
+    latencies.clear();
+    failures = 0;
+    wrong_lines = 0;
+    const uint32_t urcs_before = engine.get_urc_count();
+    run(engine, script);
+
+    bench_report("at", "echo_depth4_failures", failures, "count");
+    bench_report("at", "echo_depth4_wrong_lines", wrong_lines, "count");
+    bench_report("at", "echo_depth4_urcs", engine.get_urc_count() - urcs_before, "count");
+
+    control(engine, "ATE0");
+}
+
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: at_bench /path/to/pty\n");
+        return 1;
+    }
+
+    modem = open(argv[1], O_RDWR | O_NOCTTY);
+    if (modem < 0) {
+        perror("open");
+        return 1;
+    }
+
+    struct termios settings;
+    tcgetattr(modem, &settings);
+    cfmakeraw(&settings);
+    tcsetattr(modem, TCSANOW, &settings);
+
+    AT_Engine engine(modem_write, nullptr);
+    control(engine, "AT+FAKELINK=" + std::to_string(AT_BENCH_LINK_MS));
+    bench_report("at", "offered", AT_BENCH_OFFERED_PER_S, "per_s");
+    bench_report("at", "link", AT_BENCH_LINK_MS * 1000, "us");
+
+    for (uint32_t depth : {1, 4}) {
+        for (uint32_t burst : {0, AT_BENCH_URC_BURST}) bench_at(depth, burst);
+    }
+
+    bench_echo();
+
+    close(modem);
+    return 0;
+}
@@ -0,0 +1,91 @@
+#!/usr/bin/env python3
+
+#
+# Report each app's flash and RAM savings from its FreeRTOS configuration overlay
+#
+# @copyright 2022, Tony Smith @smittytone
+# @version   1.4.1
+# @license   MIT
+#
+# Compares the apps in two build directories: one configured with
+# `-DFREERTOS_APP_OVERLAYS=OFF`, so every app uses Config/FreeRTOSConfig.h
+# alone, and one with the overlays. Flash is text plus initialised data;
+# static RAM is initialised data plus bss. Kernel objects that FreeRTOS
+# allocates at run time, such as the timer task, come from the heap, so
+# they are not included.
+#
+# Overlays must only trim the shared configuration. An overlay that turns
+# a feature on would show its cost as a negative saving, and builds
+# without the overlays would silently lose the feature, so the script
+# stops if any overlay sets a `configUSE_` option to 1. Apps enable
+# features with compile definitions in their CMakeLists.txt instead.
+#
+# Usage:
+#   config_size.py [--size arm-none-eabi-size] shared_build overlay_build
+#
+
+import argparse
+import re
+import subprocess
+import sys
+from pathlib import Path
+
+
+# CONSTANTS
+REPO = Path(__file__).resolve().parent.parent
+FEATURE_ENABLE = re.compile(r"^\s*#define\s+(configUSE_\w+)\s+1\b", re.MULTILINE)
+
+
+# FUNCTIONS
+def overlay_enables():
+    # List each overlay setting that turns a kernel feature on
+    found = []
+    for overlay in sorted(REPO.glob("App-*/FreeRTOSConfigOverlay.h")):
+        for name in FEATURE_ENABLE.findall(overlay.read_text()):
+            found.append(f"{overlay.relative_to(REPO)}: {name}")
+    return found
+
+
+def elf_sizes(build, size_tool):
+    # Map each ELF's name to its (text, data, bss) sizes
+    sizes = {}
+    for elf in sorted(Path(build).rglob("*.elf")):
+        output = subprocess.run([size_tool, str(elf)], capture_output=True, text=True, check=True).stdout
+        fields = output.strip().splitlines()[-1].split()
+        sizes[elf.stem] = (int(fields[0]), int(fields[1]), int(fields[2]))
+    return sizes
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compare app sizes with and without FreeRTOS configuration overlays")
+    parser.add_argument("--size", default="arm-none-eabi-size", help="the size tool (default: arm-none-eabi-size)")
+    parser.add_argument("shared", help="build directory configured with -DFREERTOS_APP_OVERLAYS=OFF")
+    parser.add_argument("overlay", help="build directory configured with the overlays")
+    args = parser.parse_args()
+
+    enables = overlay_enables()
+    if enables:
+        print("[ERROR] Overlays may only trim the shared configuration, but these turn features on:")
+        for enable in enables:
+            print(f"  {enable}")
+        return 1
+
+    shared = elf_sizes(args.shared, args.size)
+    overlay = elf_sizes(args.overlay, args.size)
+    apps = sorted(set(shared) & set(overlay))
+    if not apps:
+        print("[ERROR] No app is in both build directories")
+        return 1
+
+    print(f"{'App':<32} {'Flash':>8} {'Saved':>7} {'RAM':>8} {'Saved':>7}")
+    for app in apps:
+        text, data, bss = overlay[app]
+        base_text, base_data, base_bss = shared[app]
+        flash = text + data
+        ram = data + bss
+        print(f"{app:<32} {flash:>8} {base_text + base_data - flash:>7} {ram:>8} {base_data + base_bss - ram:>7}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
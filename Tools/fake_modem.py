@@ -0,0 +1,161 @@
+#!/usr/bin/env python3
+
+#
+# Scripted fake modem on a Linux pty, for host-side AT engine tests
+#
+# @copyright 2022, Tony Smith @smittytone
+# @version   1.4.1
+# @license   MIT
+#
+# Prints the pty's path, then answers AT commands in order, as a modem
+# does, with a processing delay per command. URCs are sent in bursts
+# between lines, including between the lines of a response. An optional
+# link delay holds each command and each line sent back for a time, as
+# a radio or a slow serial link would, so a host that waits for each
+# reply before sending the next command pays the round trip every time.
+# With echo on, each command is echoed as it arrives, so the echoes of
+# pipelined commands fall among the lines of the response before them.
+#
+# Control commands, answered with OK:
+#   AT+FAKEURC=<burst>,<period_ms>   Send <burst> URCs every <period_ms>
+#                                    (0,0 to stop)
+#   AT+FAKEDELAY=<ms>                Set the per-command delay
+#   AT+FAKELINK=<ms>                 Set the one-way link delay (default 0)
+#   ATE0, ATE1                       Turn command echo off (default) or on
+#
+
+import os
+import pty
+import queue
+import random
+import sys
+import threading
+import time
+import tty
+
+
+# GLOBALS
+responses = {
+    "AT":           [],
+    "ATI":          ["Fake Modem", "Revision: 1.4.1"],
+    "AT+CSQ":       ["+CSQ: 20,0"],
+    "AT+CREG?":     ["+CREG: 0,1"],
+    "AT+CGSN":      ["867962040000000"],
+    "AT+CMGR=1":    ["+CMGR: \"REC UNREAD\",\"+447700900123\",,\"22/06/14,12:00:00+04\"", "Hello"],
+}
+
+settings = {"burst": 0, "period": 0.0, "delay": 0.002, "link": 0.0, "echo": False}
+urc_index = 0
+# Lines to send and commands received, each with the time it is due
+outgoing = queue.Queue()
+incoming = queue.Queue()
+
+
+# FUNCTIONS
+def send_line(fd, line):
+    # Whole lines only: URCs never split a line. The link delay is
+    # the same for every line, so they stay in order
+    outgoing.put((time.monotonic() + settings["link"], line))
+
+
+def wait_until(due):
+    delay = due - time.monotonic()
+    if delay > 0:
+        time.sleep(delay)
+
+
+def write_loop(fd):
+    while True:
+        due, line = outgoing.get()
+        wait_until(due)
+        os.write(fd, (line + "\r\n").encode())
+
+
+def read_loop(fd):
+    # Timestamp commands as they are written, not as they are answered,
+    # so pipelined commands cross the link while earlier ones are handled
+    buffer = b""
+    while True:
+        data = os.read(fd, 1024)
+        if not data:
+            break
+        buffer += data
+        while b"\r" in buffer:
+            command, buffer = buffer.split(b"\r", 1)
+            command = command.strip().decode(errors="replace")
+            if command:
+                incoming.put((time.monotonic() + settings["link"], command))
+                # Echoed on arrival, so after the link delay each way
+                if settings["echo"]:
+                    outgoing.put((time.monotonic() + 2 * settings["link"], command))
+    incoming.put((0, None))
+
+
+def answer(fd, command):
+    if command.startswith("AT+FAKEURC="):
+        burst, period = command[11:].split(",")
+        settings["burst"] = int(burst)
+        settings["period"] = int(period) / 1000.0
+        send_line(fd, "OK")
+        return
+
+    if command.startswith("AT+FAKEDELAY="):
+        settings["delay"] = int(command[13:]) / 1000.0
+        send_line(fd, "OK")
+        return
+
+    if command.startswith("AT+FAKELINK="):
+        settings["link"] = int(command[12:]) / 1000.0
+        send_line(fd, "OK")
+        return
+
+    if command in ("ATE0", "ATE1"):
+        settings["echo"] = command == "ATE1"
+        send_line(fd, "OK")
+        return
+
+    time.sleep(settings["delay"] * random.uniform(0.5, 1.5))
+    if command in responses:
+        for line in responses[command]:
+            send_line(fd, line)
+        send_line(fd, "OK")
+    else:
+        send_line(fd, "ERROR")
+
+
+def urc_loop(fd):
+    global urc_index
+    while True:
+        if settings["burst"] > 0 and settings["period"] > 0:
+            time.sleep(settings["period"])
+            for _ in range(settings["burst"]):
+                urc_index += 1
+                send_line(fd, "+CMTI: \"SM\",%i" % (urc_index % 100))
+        else:
+            time.sleep(0.05)
+
+
+def main():
+    master, slave = pty.openpty()
+    tty.setraw(slave)
+    print(os.ttyname(slave), flush=True)
+
+    threading.Thread(target=urc_loop, args=(master,), daemon=True).start()
+    threading.Thread(target=write_loop, args=(master,), daemon=True).start()
+    threading.Thread(target=read_loop, args=(master,), daemon=True).start()
+
+    # Commands are handled strictly in order, so pipelined
+    # commands queue up as they would in a modem
+    while True:
+        due, command = incoming.get()
+        if command is None:
+            break
+        wait_until(due)
+        answer(master, command)
+
+
+if __name__ == "__main__":
+    try:
+        main()
+    except KeyboardInterrupt:
+        sys.exit(0)
@@ -0,0 +1,119 @@
+#!/usr/bin/env python3
+
+#
+# Heap allocation hotspots from on-target profiles
+#
+# @copyright 2022, Tony Smith @smittytone
+# @version   1.4.1
+# @license   MIT
+#
+# Reads the `HEAP,...` and `HEAP_SITE,...` lines that `Heap_Profile::report()`
+# writes to STDIO (build with `-DHEAP_PROFILE=ON`). It takes the last report
+# in the log, resolves each site's return addresses against the app's ELF
+# file with addr2line, and lists the sites by allocation rate, so the
+# steady-state hotspots come first. Frames in the C++ library are folded
+# away, so each site shows the app code behind it. Direct malloc() calls
+# are not profiled: the heap's total use is shown beside the profiled
+# bytes, so the gap shows.
+#
+# Usage:
+#   heap_report.py --elf build/App-IRQs/IRQS_DEMO.elf [--sort bytes] [--top 20] log
+#
+
+import argparse
+import shutil
+import subprocess
+import sys
+
+
+# CONSTANTS
+ADDR2LINE = "arm-none-eabi-addr2line"
+# Library functions that allocate on the app's behalf
+LIBRARY_PREFIXES = ("std::", "__gnu_cxx::", "operator new", "__wrap__Zn", "pvPortMalloc", "heap_profile_")
+
+
+# FUNCTIONS
+def read_log(path):
+    # Each report starts with a HEAP line: keep the last complete one
+    totals, sites = None, []
+    with open(path, errors="replace") as log:
+        for line in log:
+            fields = line.strip().split(",")
+            if len(fields) >= 9 and fields[0] == "HEAP":
+                totals = dict(zip(("interval_ms", "allocs", "frees", "live_bytes", "peak_bytes",
+                                   "sites", "dropped", "untracked", "heap_in_use"), (int(f) for f in fields[1:10])))
+                sites = []
+            elif len(fields) >= 9 and fields[0] == "HEAP_SITE" and totals is not None:
+                sites.append({
+                    "task":         fields[1],
+                    "allocs":       int(fields[2]),
+                    "frees":        int(fields[3]),
+                    "bytes":        int(fields[4]),
+                    "live_bytes":   int(fields[5]),
+                    "allocs_per_s": int(fields[6]),
+                    "bytes_per_s":  int(fields[7]),
+                    "frames":       [int(f, 16) for f in fields[8:] if int(f, 16) != 0],
+                })
+    return totals, sites
+
+
+def resolve(elf, addresses):
+    # Return addresses point past the call: step back into it
+    if not addresses:
+        return {}
+    if elf is None or shutil.which(ADDR2LINE) is None:
+        return dict((a, "0x%08x" % a) for a in addresses)
+    ordered = sorted(addresses)
+    output = subprocess.run([ADDR2LINE, "-f", "-C", "-s", "-e", elf] + ["0x%x" % (a - 1) for a in ordered],
+                            capture_output=True, text=True, check=True).stdout.splitlines()
+    names = {}
+    for i, address in enumerate(ordered):
+        function, place = output[2 * i], output[2 * i + 1]
+        names[address] = "%s (%s)" % (function, place) if function != "??" else "0x%08x" % address
+    return names
+
+
+def is_library(name):
+    return name.startswith(LIBRARY_PREFIXES)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Heap allocation hotspots from Heap_Profile logs")
+    parser.add_argument("log", help="STDIO capture")
+    parser.add_argument("--elf", help="The app's ELF file, to name the call sites")
+    parser.add_argument("--sort", choices=("allocs", "bytes", "live"), default="allocs",
+                        help="Rank by allocations or bytes per second, or by live bytes (default: allocs)")
+    parser.add_argument("--top", type=int, default=20, help="Sites to list (default: 20)")
+    args = parser.parse_args()
+
+    totals, sites = read_log(args.log)
+    if totals is None:
+        print("No HEAP records -- was the app built with -DHEAP_PROFILE=ON?")
+        sys.exit(1)
+
+    print("Since boot: %i allocation(s), %i free(s), %i live byte(s), peak %i" % (
+          totals["allocs"], totals["frees"], totals["live_bytes"], totals["peak_bytes"]))
+    print("Rates over the last %.1fs" % (totals["interval_ms"] / 1000))
+    if "heap_in_use" in totals:
+        print("Warning: direct malloc() calls are not counted. The heap has %i byte(s) in use, overhead included" % (
+              totals["heap_in_use"]))
+    if totals["dropped"] or totals["untracked"]:
+        print("Warning: %i allocation(s) had no room for their site, %i kernel block(s) weren't tracked" % (
+              totals["dropped"], totals["untracked"]))
+    print()
+
+    names = resolve(args.elf, set(a for s in sites for a in s["frames"]))
+    key = {"allocs": "allocs_per_s", "bytes": "bytes_per_s", "live": "live_bytes"}[args.sort]
+    print("%8s %10s %10s %8s %10s  %-12s %s" % ("ALLOC/S", "BYTES/S", "LIVE", "ALLOCS", "BYTES", "TASK", "SITE"))
+    for site in sorted(sites, key=lambda s: s[key], reverse=True)[:args.top]:
+        chain = [names[a] for a in site["frames"]]
+        # Keep the innermost frame, and the app frames beyond the library
+        shown = chain[:1] + [n for n in chain[1:] if not is_library(n)]
+        print("%8i %10i %10i %8i %10i  %-12s %s" % (site["allocs_per_s"], site["bytes_per_s"], site["live_bytes"],
+              site["allocs"], site["bytes"], site["task"], shown[0]))
+        for name in shown[1:]:
+            print("%63s<- %s" % ("", name))
+
+
+if __name__ == "__main__":
+    main()
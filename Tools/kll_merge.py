@@ -0,0 +1,167 @@
+#!/usr/bin/env python3
+
+#
+# Merge KLL quantile sketch snapshots and report long-window quantiles
+#
+# @copyright 2022, Tony Smith @smittytone
+# @version   1.4.1
+# @license   MIT
+#
+# Reads the `KLL,...` lines that `KLL_Sketch::write_snapshot()` writes to
+# STDIO -- one per unit per window -- from any number of logs. Merges the
+# windows for each unit, then every unit together, and prints p50, p95
+# and p99 for each. Values are Q-format: `--frac` sets the fraction bits
+# (default: 4, as for MCP9808 temperatures).
+#
+# Usage:
+#   kll_merge.py [--frac 4] [--snapshot] log [log ...]
+#
+
+import argparse
+import random
+
+
+# CLASSES
+class Sketch:
+    # Mirrors KLL_Sketch in Common/kll.h, with unbounded storage, so
+    # merged results can be written back out as snapshots
+
+    def __init__(self, k):
+        self.k = k
+        self.count = 0
+        self.min = None
+        self.max = None
+        self.levels = [[]]
+
+    @classmethod
+    def from_line(cls, line):
+        # KLL,<unit>,<K>,<count>,<min>,<max>,<levels>,<level sizes>...,<items>...
+        fields = line.strip().split(",")
+        unit = fields[1]
+        sketch = cls(int(fields[2]))
+        sketch.count = int(fields[3])
+        sketch.min = int(fields[4])
+        sketch.max = int(fields[5])
+        level_count = int(fields[6])
+        sizes = [int(f) for f in fields[7:7 + level_count]]
+        items = [int(f) for f in fields[7 + level_count:]]
+        if sum(sizes) != len(items):
+            raise ValueError("truncated snapshot for unit %s" % unit)
+        sketch.levels = []
+        start = 0
+        for size in sizes:
+            sketch.levels.append(items[start:start + size])
+            start += size
+        return unit, sketch
+
+    def capacity(self, h):
+        cap = self.k
+        for _ in range(len(self.levels) - 1 - h):
+            if cap <= 2:
+                break
+            cap = (cap * 2 + 2) // 3
+        return max(cap, 2)
+
+    def merge(self, other):
+        if other.k != self.k:
+            raise ValueError("cannot merge sketches with K %i and %i" % (self.k, other.k))
+        if other.count == 0:
+            return
+        while len(self.levels) < len(other.levels):
+            self.levels.append([])
+        for h, level in enumerate(other.levels):
+            self.levels[h].extend(level)
+        self.min = other.min if self.min is None else min(self.min, other.min)
+        self.max = other.max if self.max is None else max(self.max, other.max)
+        self.count += other.count
+        self.compress()
+
+    def compress(self):
+        # Compact until every level is within its capacity, as the
+        # device would have done holding the same items
+        h = 0
+        while h < len(self.levels):
+            level = self.levels[h]
+            if len(level) < self.capacity(h):
+                h += 1
+                continue
+            if h + 1 == len(self.levels):
+                self.levels.append([])
+            level.sort()
+            odd = len(level) % 2
+            self.levels[h + 1].extend(level[odd + random.randint(0, 1)::2])
+            self.levels[h] = level[:odd]
+            h = 0
+
+    def quantile(self, rank):
+        if self.count == 0:
+            return None
+        weighted = sorted((item, 1 << h) for h, level in enumerate(self.levels) for item in level)
+        target = rank * self.count
+        total = 0
+        for item, weight in weighted:
+            total += weight
+            if total >= target:
+                return item
+        return self.max
+
+    def to_line(self, unit):
+        fields = ["KLL", unit, self.k, self.count, self.min, self.max, len(self.levels)]
+        fields += [len(level) for level in self.levels]
+        fields += [item for level in self.levels for item in level]
+        return ",".join(str(f) for f in fields)
+
+
+# FUNCTIONS
+def report(name, sketch, scale):
+    values = ["%s %8.3f" % (label, sketch.quantile(rank) / scale)
+              for label, rank in (("p50", 0.50), ("p95", 0.95), ("p99", 0.99))]
+    print("%-24s n=%-10i min %8.3f  %s  max %8.3f" % (name, sketch.count, sketch.min / scale,
+          "  ".join(values), sketch.max / scale))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Merge KLL sketch snapshots")
+    parser.add_argument("logs", nargs="+", help="STDIO captures holding KLL lines")
+    parser.add_argument("--frac", type=int, default=4, help="Fraction bits of the values (default: 4)")
+    parser.add_argument("--snapshot", action="store_true", help="Also print each merged sketch as a KLL line")
+    args = parser.parse_args()
+
+    random.seed(1)
+    units = {}
+    for path in args.logs:
+        with open(path, errors="replace") as log:
+            for line in log:
+                if not line.startswith("KLL,"):
+                    continue
+                try:
+                    unit, sketch = Sketch.from_line(line)
+                except (ValueError, IndexError) as err:
+                    print("Skipping a line in %s: %s" % (path, err))
+                    continue
+                if unit not in units:
+                    units[unit] = Sketch(sketch.k)
+                units[unit].merge(sketch)
+
+    if not units:
+        print("No KLL snapshots found")
+        return
+
+    scale = float(1 << args.frac)
+    combined = None
+    for unit in sorted(units):
+        report(unit, units[unit], scale)
+        if args.snapshot:
+            print(units[unit].to_line(unit))
+        if combined is None:
+            combined = Sketch(units[unit].k)
+        combined.merge(units[unit])
+
+    if len(units) > 1:
+        report("ALL", combined, scale)
+        if args.snapshot:
+            print(combined.to_line("ALL"))
+
+
+if __name__ == "__main__":
+    main()
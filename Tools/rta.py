@@ -0,0 +1,144 @@
+#!/usr/bin/env python3
+
+#
+# Response-time analysis from on-target WCET measurements
+#
+# @copyright 2022, Tony Smith @smittytone
+# @version   1.4.1
+# @license   MIT
+#
+# Reads the `WCET,...` lines that `WCET::report()` writes to STDIO (build
+# with `-DWCET_TRACE=ON`), one log per app configuration. For each log it
+# runs response-time analysis on the tasks' current priorities and on a
+# deadline-monotonic assignment, and reports which pass.
+#
+# Usage:
+#   rta.py [--margin 1.2] [--levels 4] [--deadline TASK=us ...] log [log ...]
+#
+
+import argparse
+import math
+import sys
+
+
+# FUNCTIONS
+def read_log(path):
+    # The report repeats: keep each task's latest line
+    tasks = {}
+    with open(path, errors="replace") as log:
+        for line in log:
+            fields = line.strip().split(",")
+            if len(fields) < 6 or fields[0] != "WCET":
+                continue
+            tasks[fields[1]] = {
+                "name":       fields[1],
+                "priority":   int(fields[2]),
+                "period":     int(fields[3]),
+                "iterations": int(fields[4]),
+                "wcet":       int(fields[5]),
+            }
+    return list(tasks.values())
+
+
+def response_time(task, tasks, priorities):
+    # Classic RTA: R = C + sum over interfering tasks of ceil(R / T) * C.
+    # Equal priorities interfere too, as FreeRTOS time-slices them
+    own = priorities[task["name"]]
+    others = [t for t in tasks if t is not task and priorities[t["name"]] >= own]
+    if any(t["period"] == 0 for t in others):
+        # A background task at or above this priority can take all the CPU
+        return math.inf
+
+    r = task["cost"]
+    while True:
+        total = task["cost"] + sum(math.ceil(r / t["period"]) * t["cost"] for t in others)
+        if total == r or total > task["deadline"]:
+            return total
+        r = total
+
+
+def analyse(tasks, priorities):
+    results = []
+    for task in tasks:
+        if task["period"] == 0:
+            results.append((task, None, True))
+            continue
+        r = response_time(task, tasks, priorities)
+        results.append((task, r, r <= task["deadline"]))
+    return results
+
+
+def deadline_monotonic(tasks, levels):
+    # Shortest deadline highest. Background tasks go to the bottom level,
+    # with everything else above them; with too few levels, the tasks with
+    # the longest deadlines share
+    periodic = sorted([t for t in tasks if t["period"] > 0], key=lambda t: t["deadline"])
+    background = [t for t in tasks if t["period"] == 0]
+    top = levels
+    bottom = 2 if background else 1
+    priorities = {}
+    for i, task in enumerate(periodic):
+        priorities[task["name"]] = max(top - i, bottom)
+    for task in background:
+        priorities[task["name"]] = 1
+    return priorities
+
+
+def report(title, results):
+    print("  %s" % title)
+    print("    %-16s %5s %10s %10s %10s %10s  %s" % ("TASK", "PRI", "C_US", "T_US", "D_US", "R_US", "RESULT"))
+    for task, r, ok in results:
+        response = "-" if r is None else ("inf" if r == math.inf else str(r))
+        print("    %-16s %5i %10i %10i %10i %10s  %s" % (task["name"], task["assigned"], task["cost"],
+              task["period"], task["deadline"], response, "PASS" if ok else "FAIL"))
+    verdict = all(ok for _, _, ok in results)
+    print("    => %s\n" % ("SCHEDULABLE" if verdict else "NOT SCHEDULABLE"))
+    return verdict
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Response-time analysis from WCET logs")
+    parser.add_argument("logs", nargs="+", help="STDIO captures, one per app configuration")
+    parser.add_argument("--margin", type=float, default=1.2,
+                        help="Scale measured maxima by this to allow for unobserved paths (default: 1.2)")
+    parser.add_argument("--levels", type=int, default=4,
+                        help="Highest task priority available, ie. configMAX_PRIORITIES - 1 (default: 4)")
+    parser.add_argument("--deadline", action="append", default=[], metavar="TASK=US",
+                        help="Constrained deadline for a task (default: its period)")
+    args = parser.parse_args()
+
+    deadlines = dict((d.split("=")[0], int(d.split("=")[1])) for d in args.deadline)
+    all_pass = True
+    for path in args.logs:
+        tasks = read_log(path)
+        print("%s: %i task(s)" % (path, len(tasks)))
+        if not tasks:
+            print("  No WCET records -- was the app built with -DWCET_TRACE=ON?\n")
+            all_pass = False
+            continue
+
+        for task in tasks:
+            task["cost"] = math.ceil(task["wcet"] * args.margin)
+            task["deadline"] = deadlines.get(task["name"], task["period"])
+        utilisation = sum(t["cost"] / t["period"] for t in tasks if t["period"] > 0)
+        print("  Utilisation: %.3f (margin %.2f)\n" % (utilisation, args.margin))
+
+        current = dict((t["name"], t["priority"]) for t in tasks)
+        for task in tasks:
+            task["assigned"] = current[task["name"]]
+        current_ok = report("Current priorities", analyse(tasks, current))
+
+        recommended = deadline_monotonic(tasks, args.levels)
+        for task in tasks:
+            task["assigned"] = recommended[task["name"]]
+        recommended_ok = report("Recommended (deadline-monotonic)", analyse(tasks, recommended))
+
+        all_pass = all_pass and current_ok
+        if not current_ok and recommended_ok:
+            print("  Apply the recommended priorities to pass.\n")
+
+    sys.exit(0 if all_pass else 1)
+
+
+if __name__ == "__main__":
+    main()
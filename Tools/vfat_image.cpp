@@ -0,0 +1,142 @@
+/**
+ * RP2040 FreeRTOS Template - Virtual FAT host check
+ * Fills a Sensor_History with a synthetic trace, presents it on a
+ * Virtual_FAT and writes every sector to a disk image, which standard
+ * tools can then check and read. It also checks that readings added
+ * after the freeze leave the files' bytes unchanged
+ *
+ *   g++ -std=c++20 -O2 -I Common Tools/vfat_image.cpp Common/virtual_fat.cpp Common/sensor_history.cpp -o vfat_image
+ *   ./vfat_image history.img
+ *   fsck.fat -n history.img
+ *   mcopy -i history.img ::HISTORY.CSV -
+ *
+ * @copyright 2022, Tony Smith (@smittytone)
+ * @version   1.4.1
+ * @licence   MIT
+ *
+ */
+#include <cstdio>
+#include <chrono>
+#include <vector>
+#include "virtual_fat.h"
+#include "sensor_history.h"
+
+
+/*
+ * CONSTANTS
+ */
+// More readings than the history holds, so the export starts mid-ring
+#define VFAT_IMAGE_READINGS         (SENSOR_HISTORY_CAPACITY + 500)
+#define VFAT_IMAGE_PERIOD_MS        10000
+// Added after the freeze: enough to fill the headroom and be dropped
+#define VFAT_IMAGE_LATE_READINGS    SENSOR_HISTORY_CAPACITY
+
+
+/*
+ * GLOBALS
+ */
+static Sensor_History   history;
+static Virtual_FAT      volume("RP2040 TEMP");
+
+
+/*
+ * HELPERS
+ */
+
+/**
+ * @brief The synthetic trace: a day-long swing from -5C to 35C in 1/16C
+ *        steps, with alert flags above 25C, then the switch to the on-die
+ *        sensor part way through.
+ */
+static History_Record make_reading(uint32_t i) {
+    const uint32_t phase = i % 8640;
+    const int32_t swing = phase < 4320 ? (int32_t)phase : (int32_t)(8640 - phase);
+    const int16_t temp_raw = (int16_t)(-80 + swing * 640 / 4320);
+    return {i * VFAT_IMAGE_PERIOD_MS, temp_raw, (uint8_t)(temp_raw > 400 ? 0x02 : 0x00), (uint8_t)(i > VFAT_IMAGE_READINGS - 100)};
+}
+
+
+/**
+ * @brief Check the files read back through the volume match the trace,
+ *        by parsing the binary file's records from the data sectors.
+ */
+static bool check_binary(uint32_t first_sector) {
+    uint8_t sector[VFAT_SECTOR_SIZE];
+    uint8_t record[SENSOR_HISTORY_RECORD_SIZE];
+    uint32_t bad = 0;
+    for (uint32_t i = 0 ; i < history.get_frozen_count() ; ++i) {
+        const uint32_t offset = SENSOR_HISTORY_HEADER_SIZE + i * SENSOR_HISTORY_RECORD_SIZE;
+        for (uint32_t b = 0 ; b < SENSOR_HISTORY_RECORD_SIZE ; ++b) {
+            volume.read_sector(first_sector + (offset + b) / VFAT_SECTOR_SIZE, sector);
+            record[b] = sector[(offset + b) % VFAT_SECTOR_SIZE];
+        }
+
+        const History_Record expected = make_reading(VFAT_IMAGE_READINGS - history.get_frozen_count() + i);
+        const uint32_t time_ms = record[0] | (record[1] << 8) | (record[2] << 16) | ((uint32_t)record[3] << 24);
+        const int16_t temp_raw = (int16_t)(record[4] | (record[5] << 8));
+        if (time_ms != expected.time_ms || temp_raw != expected.temp_raw || record[6] != expected.flags) bad++;
+    }
+
+    return bad == 0;
+}
+
+
+/*
+ * RUNTIME START
+ */
+
+int main(int argc, char* argv[]) {
+    if (argc != 2) {
+        printf("Usage: vfat_image <image file>\n");
+        return 1;
+    }
+
+    for (uint32_t i = 0 ; i < VFAT_IMAGE_READINGS ; ++i) history.add(make_reading(i));
+
+    history.freeze();
+    volume.add_file("history.csv", history.get_csv_size(), Sensor_History::read_csv, &history);
+    volume.add_file("history.bin", history.get_binary_size(), Sensor_History::read_binary, &history);
+
+    FILE* image = fopen(argv[1], "wb");
+    if (image == nullptr) {
+        printf("[ERROR] Can't open %s\n", argv[1]);
+        return 1;
+    }
+
+    // Time the synthesis of the files' sectors alone, then write the image.
+    // The CSV file takes the first clusters, so the binary file follows it
+    const uint32_t csv_sectors = (history.get_csv_size() + VFAT_SECTOR_SIZE - 1) / VFAT_SECTOR_SIZE;
+    const uint32_t file_sectors = csv_sectors + (history.get_binary_size() + VFAT_SECTOR_SIZE - 1) / VFAT_SECTOR_SIZE;
+    std::vector<uint8_t> files(file_sectors * VFAT_SECTOR_SIZE);
+    uint8_t sector[VFAT_SECTOR_SIZE];
+    const auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0 ; i < file_sectors ; ++i) volume.read_sector(VFAT_DATA_SECTOR + i, &files[i * VFAT_SECTOR_SIZE]);
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    for (uint32_t i = 0 ; i < volume.get_sector_count() ; ++i) {
+        volume.read_sector(i, sector);
+        fwrite(sector, 1, sizeof(sector), image);
+    }
+
+    fclose(image);
+
+    const bool match = check_binary(VFAT_DATA_SECTOR + csv_sectors);
+
+    // Keep adding readings, as the sensor task does while the drive is
+    // mounted, then render the files again: not a byte may change
+    for (uint32_t i = 0 ; i < VFAT_IMAGE_LATE_READINGS ; ++i) history.add(make_reading(VFAT_IMAGE_READINGS + i));
+    uint32_t changed = 0;
+    for (uint32_t i = 0 ; i < file_sectors ; ++i) {
+        volume.read_sector(VFAT_DATA_SECTOR + i, sector);
+        for (uint32_t b = 0 ; b < VFAT_SECTOR_SIZE ; ++b) {
+            if (sector[b] != files[i * VFAT_SECTOR_SIZE + b]) changed++;
+        }
+    }
+
+    printf("%lu sectors, %lu readings, %lu CSV bytes, %lu binary bytes\n", (unsigned long)volume.get_sector_count(),
+           (unsigned long)history.get_frozen_count(), (unsigned long)history.get_csv_size(), (unsigned long)history.get_binary_size());
+    printf("Synthesis: %.1f MB/s. Binary records %s\n", file_sectors * (double)VFAT_SECTOR_SIZE / seconds / 1e6, match ? "match" : "DO NOT MATCH");
+    printf("After %lu more readings (%lu dropped): %lu file byte(s) changed\n", (unsigned long)VFAT_IMAGE_LATE_READINGS,
+           (unsigned long)history.get_dropped_count(), (unsigned long)changed);
+    return match && changed == 0 ? 0 : 1;
+}